@@ -0,0 +1,194 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+#include "AudioLib/MathDefs.h"
+#include "BenchmarkRunner.h"
+
+namespace NoiseInvader
+{
+	namespace Benchmark
+	{
+		BenchmarkRunner::BenchmarkRunner()
+		{
+			BlockSizes = { 16, 64, 256, 1024, 4096, 8192 };
+			SampleRates = { 44100, 48000, 96000, 192000, 384000 };
+			MinTimeSeconds = 0.02;
+			Repeats = 3;
+		}
+
+		void BenchmarkRunner::Add(const std::string& name, BlockFactory factory)
+		{
+			BenchmarkCase c;
+			c.Name = name;
+			c.Create = factory;
+			cases.push_back(c);
+		}
+
+		std::vector<BenchmarkResult> BenchmarkRunner::Run(const std::string& filter, bool verbose)
+		{
+			std::vector<BenchmarkResult> results;
+
+			int maxBlock = 0;
+			for (auto size : BlockSizes)
+				if (size > maxBlock)
+					maxBlock = size;
+
+			std::vector<float> output(maxBlock);
+
+			for (auto& c : cases)
+			{
+				if (!filter.empty() && c.Name.find(filter) == std::string::npos)
+					continue;
+
+				for (auto fs : SampleRates)
+				{
+					// guitar-ish test signal: decaying 300Hz tone over a low noise floor, deterministic
+					std::vector<float> input(maxBlock);
+					unsigned int seed = 12345;
+					for (int i = 0; i < maxBlock; i++)
+					{
+						seed = seed * 1664525 + 1013904223;
+						auto noise = (seed >> 8) / (double)(1 << 24) * 2 - 1;
+						auto env = std::exp(-i / (0.05 * fs));
+						input[i] = (float)(0.5 * env * std::sin(2 * M_PI * 300 * i / fs) + 0.001 * noise);
+					}
+
+					for (auto blockSize : BlockSizes)
+					{
+						auto func = c.Create(fs);
+						auto nsPerSample = Measure(func, &input[0], &output[0], blockSize);
+
+						BenchmarkResult r;
+						r.Name = c.Name;
+						r.Fs = fs;
+						r.BlockSize = blockSize;
+						r.NsPerSample = nsPerSample;
+						r.SamplesPerSec = 1e9 / nsPerSample;
+						results.push_back(r);
+
+						if (verbose)
+						{
+							std::printf("%-42s fs=%-7.0f block=%-5d %9.3f ns/sample %12.0f samples/sec\n",
+								r.Name.c_str(), r.Fs, r.BlockSize, r.NsPerSample, r.SamplesPerSec);
+						}
+					}
+				}
+			}
+
+			return results;
+		}
+
+		double BenchmarkRunner::Measure(BlockFunc& func, const float* input, float* output, int blockSize)
+		{
+			typedef std::chrono::steady_clock Clock;
+
+			// warm up caches, branch predictors and the processor state
+			for (int i = 0; i < 16; i++)
+				func(input, output, blockSize);
+
+			double best = 1e30;
+			for (int r = 0; r < Repeats; r++)
+			{
+				long long samples = 0;
+				double elapsed = 0.0;
+				auto start = Clock::now();
+
+				while (elapsed < MinTimeSeconds)
+				{
+					// batch up calls so the clock read doesn't dominate tiny blocks
+					for (int i = 0; i < 16; i++)
+						func(input, output, blockSize);
+
+					samples += 16 * blockSize;
+					elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+				}
+
+				auto ns = elapsed * 1e9 / samples;
+				if (ns < best)
+					best = ns;
+			}
+
+			return best;
+		}
+
+		bool BenchmarkRunner::WriteCsv(const std::string& path, const std::vector<BenchmarkResult>& results)
+		{
+			FILE* f = std::fopen(path.c_str(), "w");
+			if (f == 0)
+				return false;
+
+			std::fprintf(f, "component,fs,block,ns_per_sample,samples_per_sec\n");
+			for (auto& r : results)
+				std::fprintf(f, "%s,%.0f,%d,%.4f,%.0f\n", r.Name.c_str(), r.Fs, r.BlockSize, r.NsPerSample, r.SamplesPerSec);
+
+			std::fclose(f);
+			return true;
+		}
+
+		bool BenchmarkRunner::ReadCsv(const std::string& path, std::vector<BenchmarkResult>& results)
+		{
+			std::ifstream file(path);
+			if (!file)
+				return false;
+
+			std::string line;
+			std::getline(file, line); // header
+
+			while (std::getline(file, line))
+			{
+				if (line.empty())
+					continue;
+
+				std::stringstream ss(line);
+				std::string field;
+				BenchmarkResult r;
+
+				std::getline(ss, r.Name, ',');
+				std::getline(ss, field, ','); r.Fs = std::atof(field.c_str());
+				std::getline(ss, field, ','); r.BlockSize = std::atoi(field.c_str());
+				std::getline(ss, field, ','); r.NsPerSample = std::atof(field.c_str());
+				std::getline(ss, field, ','); r.SamplesPerSec = std::atof(field.c_str());
+				results.push_back(r);
+			}
+
+			return true;
+		}
+
+		int BenchmarkRunner::Compare(
+			const std::vector<BenchmarkResult>& results,
+			const std::vector<BenchmarkResult>& baseline,
+			double tolerancePercent)
+		{
+			typedef std::tuple<std::string, double, int> Key;
+			std::map<Key, double> baseTimes;
+			for (auto& b : baseline)
+				baseTimes[Key(b.Name, b.Fs, b.BlockSize)] = b.NsPerSample;
+
+			int regressions = 0;
+			std::printf("\n%-42s %-7s %-6s %12s %12s %9s\n", "component", "fs", "block", "baseline ns", "current ns", "change");
+
+			for (auto& r : results)
+			{
+				auto it = baseTimes.find(Key(r.Name, r.Fs, r.BlockSize));
+				if (it == baseTimes.end())
+					continue;
+
+				auto change = (r.NsPerSample / it->second - 1.0) * 100;
+				bool regressed = change > tolerancePercent;
+				if (regressed)
+					regressions++;
+
+				std::printf("%-42s %-7.0f %-6d %12.3f %12.3f %+8.1f%%%s\n",
+					r.Name.c_str(), r.Fs, r.BlockSize, it->second, r.NsPerSample, change, regressed ? "  REGRESSION" : "");
+			}
+
+			return regressions;
+		}
+	}
+}
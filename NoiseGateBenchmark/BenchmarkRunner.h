@@ -0,0 +1,69 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace NoiseInvader
+{
+	namespace Benchmark
+	{
+		// Processes one block of len samples. Implementations own whatever state they need
+		typedef std::function<void(const float* input, float* output, int len)> BlockFunc;
+
+		// Creates a fresh processor, configured for the given samplerate
+		typedef std::function<BlockFunc(double fs)> BlockFactory;
+
+		struct BenchmarkCase
+		{
+			std::string Name;
+			BlockFactory Create;
+		};
+
+		struct BenchmarkResult
+		{
+			std::string Name;
+			double Fs;
+			int BlockSize;
+			double NsPerSample;
+			double SamplesPerSec;
+		};
+
+		class BenchmarkRunner
+		{
+		private:
+			std::vector<BenchmarkCase> cases;
+
+		public:
+			std::vector<int> BlockSizes;
+			std::vector<double> SampleRates;
+
+			// each measurement runs blocks until at least this much time has passed, best of Repeats is kept
+			double MinTimeSeconds;
+			int Repeats;
+
+			BenchmarkRunner();
+
+			void Add(const std::string& name, BlockFactory factory);
+
+			// Runs every case whose name contains filter (empty filter runs everything)
+			std::vector<BenchmarkResult> Run(const std::string& filter, bool verbose);
+
+			static bool WriteCsv(const std::string& path, const std::vector<BenchmarkResult>& results);
+			static bool ReadCsv(const std::string& path, std::vector<BenchmarkResult>& results);
+
+			/// <summary>
+			/// Prints the change relative to the baseline for every result that exists in both sets.
+			/// Returns the number of results that got slower by more than tolerancePercent
+			/// </summary>
+			static int Compare(
+				const std::vector<BenchmarkResult>& results,
+				const std::vector<BenchmarkResult>& baseline,
+				double tolerancePercent);
+
+		private:
+			double Measure(BlockFunc& func, const float* input, float* output, int blockSize);
+		};
+	}
+}
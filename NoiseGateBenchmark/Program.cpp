@@ -0,0 +1,968 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AudioLib/Biquad.h"
+#include "AudioLib/BiquadBank.h"
+#include "AudioLib/Butterworth.h"
+#include "AudioLib/OnePoleFilters.h"
+#include "AudioLib/Sos.h"
+#include "AudioLib/Transfer.h"
+#include "AudioLib/Utils.h"
+#include "AudioLib/ValueTables.h"
+#include "AudioLib/VectorMath.h"
+#include "EnvelopeFollower.h"
+#include "Expander.h"
+#include "GainRamp.h"
+#include "GateBank.h"
+#include "Indicators.h"
+#include "NoiseGateKernel.h"
+#include "PeakDetector.h"
+#include "SlewLimiter.h"
+
+#include "BenchmarkRunner.h"
+
+using namespace AudioLib;
+using namespace NoiseInvader;
+using namespace NoiseInvader::Benchmark;
+
+// Maps the -1...1 test signal onto a -100...0 dB range for the stages that operate in the log domain
+static inline double ToDb(float x)
+{
+	return std::abs(x) * 100.0 - 100.0;
+}
+
+/// <summary>
+/// The PeakDetector before it moved to a sliding window maximum, kept as the benchmark baseline. Rescans every stored
+/// peak of the hold window on every sample. Produces the same output as PeakDetector
+/// </summary>
+class ScanningPeakDetector
+{
+private:
+	std::vector<std::pair<long, float>> peakStorage;
+	float decay;
+	int windowSize;
+	float prevInputValue;
+	long timeIndex;
+	int peakReadIndex;
+	int peakWriteIndex;
+	float currentValue;
+
+public:
+	ScanningPeakDetector(double fs, float decay = 0.995f, float peakHoldMillis = 10.0f)
+	{
+		this->decay = decay;
+		windowSize = (int)(peakHoldMillis / 1000.0f * fs);
+		peakStorage.resize(windowSize);
+		prevInputValue = 0.0f;
+		timeIndex = 0;
+		peakReadIndex = 0;
+		peakWriteIndex = 0;
+		currentValue = 0.0f;
+	}
+
+	inline float ProcessPeaks(float val)
+	{
+		if (val < prevInputValue)
+		{
+			peakStorage[peakWriteIndex] = std::make_pair(timeIndex, prevInputValue);
+			peakWriteIndex = (peakWriteIndex + 1) % windowSize;
+		}
+		prevInputValue = val;
+
+		std::pair<long, float> maxPeak;
+		bool foundPeak = false;
+		int readIdx = peakReadIndex;
+		long minTimeIndex = timeIndex - windowSize;
+		while (readIdx != peakWriteIndex)
+		{
+			auto p = peakStorage[readIdx];
+			if (p.first < minTimeIndex)
+				peakReadIndex = (peakReadIndex + 1) % windowSize;
+			else if (!foundPeak || p.second > maxPeak.second)
+			{
+				maxPeak = p;
+				foundPeak = true;
+			}
+
+			readIdx = (readIdx + 1) % windowSize;
+		}
+
+		auto fallbackValue = currentValue * decay;
+		if (fallbackValue < val)
+			fallbackValue = val;
+
+		currentValue = foundPeak && maxPeak.second > fallbackValue ? maxPeak.second : fallbackValue;
+		timeIndex++;
+		return currentValue;
+	}
+};
+
+// Every lane of the bank processes the benchmark input, the time is for all lanes together
+template<int Lanes>
+static BlockFactory GateBankCase()
+{
+	return [](double fs) -> BlockFunc
+	{
+		auto bank = std::make_shared<GateBank<Lanes>>((int)fs);
+		auto scratch = std::make_shared<std::vector<float>>(8192 * Lanes);
+		return [bank, scratch](const float* input, float* output, int len)
+		{
+			const float* in[Lanes];
+			float* out[Lanes];
+			for (int l = 0; l < Lanes; l++)
+			{
+				in[l] = input;
+				out[l] = l == 0 ? output : &(*scratch)[l * 8192];
+			}
+
+			bank->Process(in, nullptr, out, len);
+		};
+	};
+}
+
+// The 2kHz lowpass of the envelope follower's band filter
+static SosCoefficients<float> DetectorLowpass(double fs)
+{
+	Biquad lp(Biquad::FilterType::LowPass, (int)fs);
+	lp.Frequency = 2000;
+	lp.SetQ(1);
+	lp.Update();
+	return lp.GetCoefficients();
+}
+
+// A 4th order Butterworth lowpass at 2kHz as transfer function polynomials, for the Transfer cases
+static void DetectorLowpass4(double fs, double* b, double* a)
+{
+	Butterworth design(fs);
+	design.CutoffHz = 2000;
+	design.Order = 4;
+	design.Update();
+	design.GetTransfer(b, a);
+}
+
+// Lanes scalar biquads filtering the benchmark input one channel after the other, the baseline for the banks
+template<int Lanes>
+static BlockFactory ScalarBiquadsCase()
+{
+	return [](double fs) -> BlockFunc
+	{
+		auto filters = std::make_shared<std::vector<Biquad>>(Lanes, Biquad(Biquad::FilterType::LowPass, (int)fs));
+		auto scratch = std::make_shared<std::vector<float>>(8192);
+		for (auto& f : *filters)
+		{
+			f.Frequency = 2000;
+			f.SetQ(1);
+			f.Update();
+		}
+
+		return [filters, scratch](const float* input, float* output, int len)
+		{
+			for (int l = 0; l < Lanes; l++)
+				(*filters)[l].Process(const_cast<float*>(input), l == 0 ? output : &(*scratch)[0], len);
+		};
+	};
+}
+
+// Every lane of the bank filters the benchmark input, planar in and out like a multichannel host buffer
+template<int Lanes, typename TAcc, BiquadForm Form = BiquadForm::TransposedDirectForm2>
+static BlockFactory BiquadBankCase()
+{
+	return [](double fs) -> BlockFunc
+	{
+		auto bank = std::make_shared<BiquadBankT<Lanes, TAcc, Form>>();
+		auto scratch = std::make_shared<std::vector<float>>(8192 * Lanes);
+		bank->SetCoefficients(DetectorLowpass(fs));
+		return [bank, scratch](const float* input, float* output, int len)
+		{
+			const float* in[Lanes];
+			float* out[Lanes];
+			for (int l = 0; l < Lanes; l++)
+			{
+				in[l] = input;
+				out[l] = l == 0 ? output : &(*scratch)[l * 8192];
+			}
+
+			bank->Process(in, out, len);
+		};
+	};
+}
+
+/// <summary>
+/// The kernel held in a steady state: the benchmark input scaled by inputGain (0 for digital silence), against a
+/// threshold that keeps the gate fully closed or fully open. With fastPaths off the whole chain runs for comparison
+/// </summary>
+static BlockFactory SteadyStateCase(float inputGain, float thresholdDb, bool fastPaths)
+{
+	return [inputGain, thresholdDb, fastPaths](double fs) -> BlockFunc
+	{
+		auto kernel = std::make_shared<NoiseGateKernel>((int)fs);
+		auto scaled = std::make_shared<std::vector<float>>(8192);
+		auto scratch = std::make_shared<std::vector<float>>(8192);
+		kernel->ThresholdDb = thresholdDb;
+		kernel->ReductionDb = -60;
+		kernel->FastPaths = fastPaths;
+		kernel->UpdateAll();
+		return [kernel, scaled, scratch, inputGain](const float* input, float* output, int len)
+		{
+			float* in = &(*scaled)[0];
+			for (int i = 0; i < len; i++)
+				in[i] = input[i] * inputGain;
+
+			kernel->Process(in, in, in, output, &(*scratch)[0], len);
+		};
+	};
+}
+
+/// <summary>
+/// Registers the components of the gain chain for sample type T. The float cases keep the plain component
+/// names so they line up with older baselines, the double cases get a " (double)" suffix
+/// </summary>
+template<typename T>
+static void RegisterChainCases(BenchmarkRunner& runner, const std::string& suffix)
+{
+	runner.Add("Sma" + suffix, [](double fs) -> BlockFunc
+	{
+		auto sma = std::make_shared<SmaT<T>>((int)(fs * 0.01));
+		return [sma](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = (float)sma->Update(std::abs(input[i]));
+		};
+	});
+
+	runner.Add("Ema" + suffix, [](double fs) -> BlockFunc
+	{
+		auto ema = std::make_shared<EmaT<T>>((T)Utils::ComputeLpAlpha(200.0, 1.0 / fs));
+		return [ema](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = (float)ema->Update(std::abs(input[i]));
+		};
+	});
+
+	runner.Add("EmaLatch" + suffix, [](double fs) -> BlockFunc
+	{
+		auto latch = std::make_shared<EmaLatchT<T>>((T)0.005, (T)0.2);
+		return [latch](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = (float)latch->Update(input[i] > 0);
+		};
+	});
+
+	runner.Add("Hp1" + suffix, [](double fs) -> BlockFunc
+	{
+		auto hp = std::make_shared<Hp1T<T>>();
+		hp->SetFc((T)(100.0 / (fs * 0.5)));
+		return [hp](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = (float)hp->Process(input[i]);
+		};
+	});
+
+	runner.Add("Biquad" + suffix, [](double fs) -> BlockFunc
+	{
+		auto biquad = std::make_shared<BiquadT<T>>(BiquadT<T>::FilterType::LowPass, (int)fs);
+		auto buffer = std::make_shared<std::vector<T>>(8192);
+		biquad->Frequency = 2000;
+		biquad->SetQ(1);
+		biquad->Update();
+		return [biquad, buffer](const float* input, float* output, int len)
+		{
+			T* x = &(*buffer)[0];
+			for (int i = 0; i < len; i++)
+				x[i] = input[i];
+
+			biquad->Process(x, x, len);
+			output[0] = (float)x[0];
+		};
+	});
+
+	runner.Add("Tdf2Biquad" + suffix, [](double fs) -> BlockFunc
+	{
+		auto biquad = std::make_shared<Tdf2BiquadT<T>>();
+		auto buffer = std::make_shared<std::vector<T>>(8192);
+		biquad->SetCoefficients(DetectorLowpass(fs));
+		return [biquad, buffer](const float* input, float* output, int len)
+		{
+			T* x = &(*buffer)[0];
+			for (int i = 0; i < len; i++)
+				x[i] = input[i];
+
+			biquad->Process(x, x, len);
+			output[0] = (float)x[0];
+		};
+	});
+
+	// The two hold smoothers of the envelope follower, 200Hz each, over the rectified input
+	runner.Add("HoldSmoother[one pole x4]" + suffix, [](double fs) -> BlockFunc
+	{
+		auto h = std::make_shared<std::vector<T>>(4, (T)0);
+		auto buffer = std::make_shared<std::vector<T>>(8192);
+		T alpha = (T)Utils::ComputeLpAlpha(200.0, 1.0 / fs);
+		return [h, buffer, alpha](const float* input, float* output, int len)
+		{
+			T* x = &(*buffer)[0];
+			for (int i = 0; i < len; i++)
+				x[i] = std::abs((T)input[i]);
+
+			T h1 = (*h)[0], h2 = (*h)[1], h3 = (*h)[2], h4 = (*h)[3];
+			for (int i = 0; i < len; i++)
+			{
+				h1 = alpha * x[i] + (1 - alpha) * h1;
+				h2 = alpha * h1 + (1 - alpha) * h2;
+				h3 = alpha * h2 + (1 - alpha) * h3;
+				h4 = alpha * h3 + (1 - alpha) * h4;
+				x[i] = h4;
+			}
+
+			*h = { h1, h2, h3, h4 };
+			output[0] = (float)x[0];
+		};
+	});
+
+	runner.Add("HoldSmoother[butterworth]" + suffix, [](double fs) -> BlockFunc
+	{
+		auto smoother = std::make_shared<SosCascadeT<T, 2, double>>();
+		auto buffer = std::make_shared<std::vector<T>>(8192);
+		Butterworth design(fs);
+		design.CutoffHz = 200;
+		design.Order = 4;
+		design.Update();
+		smoother->SetSections(design.GetSections(), design.GetSectionCount());
+		return [smoother, buffer](const float* input, float* output, int len)
+		{
+			T* x = &(*buffer)[0];
+			for (int i = 0; i < len; i++)
+				x[i] = std::abs((T)input[i]);
+
+			smoother->Process(x, x, len);
+			output[0] = (float)x[0];
+		};
+	});
+
+	runner.Add("Expander::Expand" + suffix, [](double fs) -> BlockFunc
+	{
+		auto expander = std::make_shared<ExpanderT<T>>();
+		expander->Update(-20, -100, 3);
+		return [expander](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+			{
+				expander->Expand((T)ToDb(input[i]));
+				output[i] = (float)expander->GetOutput();
+			}
+		};
+	});
+
+	runner.Add("SlewLimiter::Process" + suffix, [](double fs) -> BlockFunc
+	{
+		auto slew = std::make_shared<SlewLimiterT<T>>(fs);
+		slew->UpdateDb60(2.0, 100.0);
+		return [slew](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = (float)slew->Process((T)ToDb(input[i]));
+		};
+	});
+
+	runner.Add("EnvelopeFollower::ProcessEnvelope" + suffix, [](double fs) -> BlockFunc
+	{
+		auto follower = std::make_shared<EnvelopeFollowerT<T>>(fs, 100);
+		return [follower](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+			{
+				follower->ProcessEnvelope(input[i]);
+				output[i] = (float)follower->GetOutput();
+			}
+		};
+	});
+
+	runner.Add("Expander::Expand[block]" + suffix, [](double fs) -> BlockFunc
+	{
+		auto expander = std::make_shared<ExpanderT<T>>();
+		auto db = std::make_shared<std::vector<T>>(8192);
+		auto gain = std::make_shared<std::vector<T>>(8192);
+		expander->Update(-20, -100, 3);
+		return [expander, db, gain](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				(*db)[i] = (T)ToDb(input[i]);
+
+			expander->Expand(&(*db)[0], &(*gain)[0], len);
+			output[0] = (float)(*gain)[0];
+		};
+	});
+
+	runner.Add("SlewLimiter::Process[block]" + suffix, [](double fs) -> BlockFunc
+	{
+		auto slew = std::make_shared<SlewLimiterT<T>>(fs);
+		auto db = std::make_shared<std::vector<T>>(8192);
+		slew->UpdateDb60(2.0, 100.0);
+		return [slew, db](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				(*db)[i] = (T)ToDb(input[i]);
+
+			slew->Process(&(*db)[0], &(*db)[0], len);
+			output[0] = (float)(*db)[0];
+		};
+	});
+
+	runner.Add("EnvelopeFollower::ProcessEnvelope[block]" + suffix, [](double fs) -> BlockFunc
+	{
+		auto follower = std::make_shared<EnvelopeFollowerT<T>>(fs, 100);
+		auto buffer = std::make_shared<std::vector<T>>(8192);
+		auto env = std::make_shared<std::vector<T>>(8192);
+		return [follower, buffer, env](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				(*buffer)[i] = input[i];
+
+			follower->ProcessEnvelope(&(*buffer)[0], &(*env)[0], len);
+			output[0] = (float)(*env)[0];
+		};
+	});
+
+	runner.Add("EnvelopeFollower::ProcessEnvelope[block, butterworth]" + suffix, [](double fs) -> BlockFunc
+	{
+		auto follower = std::make_shared<EnvelopeFollowerT<T>>(fs, 100);
+		auto buffer = std::make_shared<std::vector<T>>(8192);
+		auto env = std::make_shared<std::vector<T>>(8192);
+		follower->SetHoldSmoother(HoldSmootherMode::Butterworth);
+		return [follower, buffer, env](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				(*buffer)[i] = input[i];
+
+			follower->ProcessEnvelope(&(*buffer)[0], &(*env)[0], len);
+			output[0] = (float)(*env)[0];
+		};
+	});
+
+	for (int factor : { 2, 4, 8 })
+	{
+		runner.Add("EnvelopeFollower::ProcessEnvelope[block, decimated /" + std::to_string(factor) + "]" + suffix, [factor](double fs) -> BlockFunc
+		{
+			auto follower = std::make_shared<EnvelopeFollowerT<T>>(fs, 100);
+			auto buffer = std::make_shared<std::vector<T>>(8192);
+			auto env = std::make_shared<std::vector<T>>(8192);
+			follower->SetDecimation(factor);
+			return [follower, buffer, env](const float* input, float* output, int len)
+			{
+				for (int i = 0; i < len; i++)
+					(*buffer)[i] = input[i];
+
+				follower->ProcessEnvelope(&(*buffer)[0], &(*env)[0], len);
+				output[0] = (float)(*env)[0];
+			};
+		});
+	}
+
+	// Steps of 16 samples towards the level of the input at each step's start
+	runner.Add("GainRamp::Process" + suffix, [](double fs) -> BlockFunc
+	{
+		auto ramp = std::make_shared<GainRampT<T>>();
+		auto db = std::make_shared<std::vector<T>>(8192);
+		auto gain = std::make_shared<std::vector<T>>(8192);
+		auto level = std::make_shared<T>((T)0);
+		ramp->SetInterval(16);
+		return [ramp, db, gain, level](const float* input, float* output, int len)
+		{
+			int i = 0;
+			while (i < len)
+			{
+				if (ramp->IsStepDone())
+				{
+					T target = (T)ToDb(input[i]);
+					ramp->Start((target - *level) / 16, target);
+					*level = target;
+				}
+
+				i += ramp->Process(&(*db)[i], &(*gain)[i], len - i);
+			}
+
+			output[0] = (float)(*gain)[0];
+		};
+	});
+
+	// The per sample gain factor of a slew limited gain in dB
+	runner.Add("GainRamp::Follow" + suffix, [](double fs) -> BlockFunc
+	{
+		auto ramp = std::make_shared<GainRampT<T>>();
+		auto slew = std::make_shared<SlewLimiterT<T>>(fs);
+		auto db = std::make_shared<std::vector<T>>(8192);
+		auto gain = std::make_shared<std::vector<T>>(8192);
+		slew->UpdateDb60(2.0, 100.0);
+		return [ramp, slew, db, gain](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				(*db)[i] = slew->Process((T)ToDb(input[i]));
+
+			ramp->Follow(&(*db)[0], &(*gain)[0], len);
+			output[0] = (float)(*gain)[0];
+		};
+	});
+
+	runner.Add("NoiseGateKernel::Process" + suffix, [](double fs) -> BlockFunc
+	{
+		auto kernel = std::make_shared<NoiseGateKernelT<T>>((int)fs);
+		auto scratch = std::make_shared<std::vector<float>>(8192);
+		return [kernel, scratch](const float* input, float* output, int len)
+		{
+			auto in = const_cast<float*>(input);
+			kernel->Process(in, in, in, output, &(*scratch)[0], len);
+		};
+	});
+
+	// the output gain followed incrementally instead of exponentiated in a vectorized pass
+	runner.Add("NoiseGateKernel::Process[exact]" + suffix, [](double fs) -> BlockFunc
+	{
+		auto kernel = std::make_shared<NoiseGateKernelT<T>>((int)fs);
+		auto scratch = std::make_shared<std::vector<float>>(8192);
+		kernel->Precision = MathPrecision::Exact;
+		kernel->UpdateAll();
+		return [kernel, scratch](const float* input, float* output, int len)
+		{
+			auto in = const_cast<float*>(input);
+			kernel->Process(in, in, in, output, &(*scratch)[0], len);
+		};
+	});
+
+	for (int interval : { 8, 32 })
+	{
+		runner.Add("NoiseGateKernel::Process[gain steps /" + std::to_string(interval) + "]" + suffix, [interval](double fs) -> BlockFunc
+		{
+			auto kernel = std::make_shared<NoiseGateKernelT<T>>((int)fs);
+			auto scratch = std::make_shared<std::vector<float>>(8192);
+			kernel->GainInterval = interval;
+			kernel->UpdateAll();
+			return [kernel, scratch](const float* input, float* output, int len)
+			{
+				auto in = const_cast<float*>(input);
+				kernel->Process(in, in, in, output, &(*scratch)[0], len);
+			};
+		});
+	}
+
+	for (int factor : { 2, 8 })
+	{
+		runner.Add("NoiseGateKernel::Process[decimated /" + std::to_string(factor) + "]" + suffix, [factor](double fs) -> BlockFunc
+		{
+			auto kernel = std::make_shared<NoiseGateKernelT<T>>((int)fs);
+			auto scratch = std::make_shared<std::vector<float>>(8192);
+			kernel->DetectorDecimation = factor;
+			kernel->UpdateAll();
+			return [kernel, scratch](const float* input, float* output, int len)
+			{
+				auto in = const_cast<float*>(input);
+				kernel->Process(in, in, in, output, &(*scratch)[0], len);
+			};
+		});
+	}
+}
+
+static void RegisterCases(BenchmarkRunner& runner)
+{
+	RegisterChainCases<float>(runner, "");
+	RegisterChainCases<double>(runner, " (double)");
+
+	const char* precisionNames[] = { "Exact", "Db001", "Db01" };
+	for (int p = 0; p < 3; p++)
+	{
+		auto precision = (MathPrecision)p;
+		runner.Add(std::string("VectorMath::Gain2Db[") + precisionNames[p] + "]", [precision](double fs) -> BlockFunc
+		{
+			return [precision](const float* input, float* output, int len)
+			{
+				VectorMath::Gain2Db(input, output, len, precision);
+			};
+		});
+
+		runner.Add(std::string("VectorMath::Db2Gain[") + precisionNames[p] + "]", [precision](double fs) -> BlockFunc
+		{
+			return [precision](const float* input, float* output, int len)
+			{
+				VectorMath::Db2Gain(input, output, len, precision);
+			};
+		});
+	}
+
+	// the fast conversions on every instruction set the CPU has, switched for the call only
+	for (int l = 0; l <= (int)Simd::GetSupportedLevel(); l++)
+	{
+		auto level = (SimdLevel)l;
+		runner.Add(std::string("VectorMath::Db2Gain[Db001, ") + Simd::GetName(level) + "]", [level](double fs) -> BlockFunc
+		{
+			return [level](const float* input, float* output, int len)
+			{
+				auto previous = Simd::GetLevel();
+				Simd::SetLevel(level);
+				VectorMath::Db2Gain(input, output, len, MathPrecision::Db001);
+				Simd::SetLevel(previous);
+			};
+		});
+
+		runner.Add(std::string("VectorMath::MaxAbs[") + Simd::GetName(level) + "]", [level](double fs) -> BlockFunc
+		{
+			return [level](const float* input, float* output, int len)
+			{
+				auto previous = Simd::GetLevel();
+				Simd::SetLevel(level);
+				output[0] = VectorMath::MaxAbs(input, len);
+				Simd::SetLevel(previous);
+			};
+		});
+	}
+
+	runner.Add("PeakDetector::ProcessPeaks[scan]", [](double fs) -> BlockFunc
+	{
+		auto detector = std::make_shared<ScanningPeakDetector>(fs);
+		return [detector](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = detector->ProcessPeaks(std::abs(input[i]));
+		};
+	});
+
+	runner.Add("PeakDetector::ProcessPeaks", [](double fs) -> BlockFunc
+	{
+		auto detector = std::make_shared<PeakDetector>(fs);
+		return [detector](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = detector->ProcessPeaks(std::abs(input[i]));
+		};
+	});
+
+	runner.Add("NoiseGateKernel::Process[peak hold]", [](double fs) -> BlockFunc
+	{
+		auto kernel = std::make_shared<NoiseGateKernel>((int)fs);
+		auto scratch = std::make_shared<std::vector<float>>(8192);
+		kernel->Detector = DetectorMode::PeakHold;
+		kernel->UpdateAll();
+		return [kernel, scratch](const float* input, float* output, int len)
+		{
+			auto in = const_cast<float*>(input);
+			kernel->Process(in, in, in, output, &(*scratch)[0], len);
+		};
+	});
+
+	runner.Add("NoiseGateKernel::Process[silent]", SteadyStateCase(0, -20, true));
+	runner.Add("NoiseGateKernel::Process[silent, full chain]", SteadyStateCase(0, -20, false));
+	runner.Add("NoiseGateKernel::Process[closed]", SteadyStateCase(1e-3f, -20, true));
+	runner.Add("NoiseGateKernel::Process[closed, full chain]", SteadyStateCase(1e-3f, -20, false));
+	runner.Add("NoiseGateKernel::Process[open]", SteadyStateCase(1, -100, true));
+	runner.Add("NoiseGateKernel::Process[open, full chain]", SteadyStateCase(1, -100, false));
+
+	runner.Add("Tdf2Biquad[double acc]", [](double fs) -> BlockFunc
+	{
+		auto biquad = std::make_shared<Tdf2BiquadT<float, double>>();
+		biquad->SetCoefficients(DetectorLowpass(fs));
+		return [biquad](const float* input, float* output, int len)
+		{
+			biquad->Process(input, output, len);
+		};
+	});
+
+	// four sections, the cost of an 8th order filter
+	runner.Add("SosCascade[4 sections]", [](double fs) -> BlockFunc
+	{
+		auto cascade = std::make_shared<SosCascadeT<float, 4>>();
+		SosCoefficients<float> sections[4];
+		for (int i = 0; i < 4; i++)
+			sections[i] = DetectorLowpass(fs);
+		cascade->SetSections(sections, 4);
+		return [cascade](const float* input, float* output, int len)
+		{
+			cascade->Process(input, output, len);
+		};
+	});
+
+	// The same 4th order lowpass and 16 tap FIR, order known at runtime and at compile time
+	runner.Add("Transfer[order 4]", [](double fs) -> BlockFunc
+	{
+		auto transfer = std::make_shared<Transfer>();
+		double b[5], a[5];
+		DetectorLowpass4(fs, b, a);
+		transfer->SetB(std::vector<double>(b, b + 5));
+		transfer->SetA(std::vector<double>(a, a + 5));
+		return [transfer](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = (float)transfer->Process(input[i]);
+		};
+	});
+
+	runner.Add("TransferT<4>", [](double fs) -> BlockFunc
+	{
+		auto transfer = std::make_shared<TransferT<double, 4>>();
+		auto buffer = std::make_shared<std::vector<double>>(8192);
+		double b[5], a[5];
+		DetectorLowpass4(fs, b, a);
+		transfer->SetB(b);
+		transfer->SetA(a);
+		return [transfer, buffer](const float* input, float* output, int len)
+		{
+			double* x = &(*buffer)[0];
+			for (int i = 0; i < len; i++)
+				x[i] = input[i];
+
+			transfer->Process(x, x, len);
+			for (int i = 0; i < len; i++)
+				output[i] = (float)x[i];
+		};
+	});
+
+	runner.Add("Transfer[FIR 16]", [](double fs) -> BlockFunc
+	{
+		auto transfer = std::make_shared<Transfer>();
+		transfer->SetB(std::vector<double>(17, 1.0 / 17));
+		transfer->SetA(std::vector<double> { 1.0 });
+		return [transfer](const float* input, float* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = (float)transfer->Process(input[i]);
+		};
+	});
+
+	runner.Add("TransferT<16, 0>[FIR]", [](double fs) -> BlockFunc
+	{
+		auto transfer = std::make_shared<TransferT<double, 16, 0>>();
+		auto buffer = std::make_shared<std::vector<double>>(8192);
+		double b[17];
+		for (int j = 0; j <= 16; j++)
+			b[j] = 1.0 / 17;
+		transfer->SetB(b);
+		return [transfer, buffer](const float* input, float* output, int len)
+		{
+			double* x = &(*buffer)[0];
+			for (int i = 0; i < len; i++)
+				x[i] = input[i];
+
+			transfer->Process(x, x, len);
+			for (int i = 0; i < len; i++)
+				output[i] = (float)x[i];
+		};
+	});
+
+	runner.Add("Biquad[16 channels, scalar]", ScalarBiquadsCase<16>());
+	runner.Add("BiquadBank<4>[4 channels]", BiquadBankCase<4, float>());
+	runner.Add("BiquadBank<8>[8 channels]", BiquadBankCase<8, float>());
+	runner.Add("BiquadBank<16>[16 channels]", BiquadBankCase<16, float>());
+	runner.Add("BiquadBank<16>[16 channels, double acc]", BiquadBankCase<16, double>());
+	runner.Add("BiquadBank<16>[16 channels, direct form I]", BiquadBankCase<16, float, BiquadForm::DirectForm1>());
+
+	runner.Add("GateBank<4>::Process[4 gates]", GateBankCase<4>());
+	runner.Add("GateBank<8>::Process[8 gates]", GateBankCase<8>());
+	runner.Add("GateBank<16>::Process[16 gates]", GateBankCase<16>());
+}
+
+/// <summary>
+/// Runs one kernel over 10 seconds of bursty noise for every block size, then prints the per-stage timing histograms.
+/// Needs a build with NOISEINVADER_ENABLE_PROFILING
+/// </summary>
+static int RunProfile(const std::vector<int>& blockSizes, double fs)
+{
+	auto kernel = std::unique_ptr<NoiseGateKernel>(new NoiseGateKernel((int)fs));
+	auto profiler = kernel->GetProfiler();
+	if (profiler == nullptr)
+	{
+		std::fprintf(stderr, "Profiling is compiled out, configure with -DNOISEINVADER_ENABLE_PROFILING=ON\n");
+		return 1;
+	}
+
+	int len = (int)(fs * 10);
+	std::vector<float> input(len);
+	std::vector<float> outputL(len);
+	std::vector<float> outputR(len);
+	unsigned int seed = 12345;
+	for (int i = 0; i < len; i++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		float noise = ((seed >> 8) / 8388608.0f) - 1.0f;
+		input[i] = noise * ((i / (int)(fs * 0.25)) % 2 == 0 ? 0.5f : 0.001f);
+	}
+
+	for (auto blockSize : blockSizes)
+	{
+		for (int pos = 0; pos + blockSize <= len; pos += blockSize)
+			kernel->Process(&input[pos], &input[pos], &input[pos], &outputL[pos], &outputR[pos], blockSize);
+	}
+
+	std::printf("fs = %.0f\n", fs);
+	profiler->Print(stdout, NoiseGateKernel::GetMemoryFootprint());
+	return 0;
+}
+
+/// <summary>
+/// Times what creating plugin instances costs, the way createEffectInstance and the first samplerate change do it.
+/// The first instance builds the lookup tables the gate uses, the later ones find them ready. Then times building
+/// the tables the gate doesn't use, which instances no longer pay for. Must run before anything else touches the tables
+/// </summary>
+static int RunInstantiation(double fs)
+{
+	typedef std::chrono::steady_clock Clock;
+	const int Instances = 200;
+
+	auto createInstance = [fs]()
+	{
+		Utils::Initialize();
+		auto kernel = std::unique_ptr<NoiseGateKernel>(new NoiseGateKernel((int)fs));
+		kernel->ReleaseMs = (float)(10 + ValueTables::Get(0.5, ValueTables::Response2Dec()) * 990);
+		kernel->ThresholdDb = (float)-ValueTables::Get(0.5, ValueTables::Response2Oct()) * 80;
+		kernel->UpdateAll();
+		return kernel;
+	};
+
+	std::vector<std::unique_ptr<NoiseGateKernel>> kernels;
+	auto start = Clock::now();
+	kernels.push_back(createInstance());
+	double first = std::chrono::duration<double>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (int i = 1; i < Instances; i++)
+		kernels.push_back(createInstance());
+	double later = std::chrono::duration<double>(Clock::now() - start).count() / (Instances - 1);
+
+	start = Clock::now();
+	ValueTables::Init();
+	volatile float unused = Utils::Note2Freq(60) + Utils::TanhLookup(0.5f);
+	(void)unused;
+	double remaining = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::printf("fs = %.0f, %d instances\n", fs, Instances);
+	std::printf("  first instance, with its lookup tables  %10.1f us\n", first * 1e6);
+	std::printf("  every later instance                    %10.1f us\n", later * 1e6);
+	std::printf("  tables the gate doesn't use             %10.1f us (not paid by the instances)\n", remaining * 1e6);
+	return 0;
+}
+
+static void PrintUsage()
+{
+	std::printf(
+		"Usage: NoiseGateBenchmark [options]\n"
+		"  --filter <text>        only run components whose name contains text\n"
+		"  --out <file.csv>       write results as csv\n"
+		"  --baseline <file.csv>  compare results against a stored baseline\n"
+		"  --tolerance <percent>  slowdown allowed before a result counts as a regression (default 10)\n"
+		"  --fail-on-regression   exit with a non-zero code when any regression is found\n"
+		"  --quick                reduced block size / samplerate matrix and shorter runs\n"
+		"  --min-time <seconds>   minimum measuring time per result (default 0.02)\n"
+		"  --profile              print per-stage latency histograms of the kernel instead (profiling build only)\n"
+		"  --instantiation        time creating plugin instances, with and without building the lookup tables, instead\n"
+		"  --simd <level>         run on scalar, sse2, avx2 or avx512 instead of the widest level the CPU supports\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::string filter;
+	std::string outFile;
+	std::string baselineFile;
+	double tolerance = 10.0;
+	bool failOnRegression = false;
+	bool profile = false;
+	bool instantiation = false;
+	std::string simd;
+
+	BenchmarkRunner runner;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "--filter" && hasValue)
+			filter = argv[++i];
+		else if (arg == "--out" && hasValue)
+			outFile = argv[++i];
+		else if (arg == "--baseline" && hasValue)
+			baselineFile = argv[++i];
+		else if (arg == "--tolerance" && hasValue)
+			tolerance = std::atof(argv[++i]);
+		else if (arg == "--min-time" && hasValue)
+			runner.MinTimeSeconds = std::atof(argv[++i]);
+		else if (arg == "--fail-on-regression")
+			failOnRegression = true;
+		else if (arg == "--profile")
+			profile = true;
+		else if (arg == "--instantiation")
+			instantiation = true;
+		else if (arg == "--simd" && hasValue)
+			simd = argv[++i];
+		else if (arg == "--quick")
+		{
+			runner.BlockSizes = { 64, 1024 };
+			runner.SampleRates = { 48000, 192000 };
+			runner.MinTimeSeconds = 0.005;
+			runner.Repeats = 2;
+		}
+		else
+		{
+			PrintUsage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	// before Utils::Initialize(), it has to find the tables unbuilt
+	if (instantiation)
+		return RunInstantiation(48000);
+
+	if (!simd.empty())
+	{
+		const char* levelNames[] = { "scalar", "sse2", "avx2", "avx512" };
+		int level = -1;
+		for (int l = 0; l < 4; l++)
+			level = simd == levelNames[l] ? l : level;
+
+		if (level < 0)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		Simd::SetLevel((SimdLevel)level);
+	}
+
+	Utils::Initialize();
+	Simd::PreventDenormals();
+	std::printf("SIMD: %s (CPU supports %s)\n", Simd::GetName(Simd::GetLevel()), Simd::GetName(Simd::GetSupportedLevel()));
+
+	if (profile)
+		return RunProfile(runner.BlockSizes, 48000);
+
+	RegisterCases(runner);
+	auto results = runner.Run(filter, true);
+
+	if (!outFile.empty() && !BenchmarkRunner::WriteCsv(outFile, results))
+	{
+		std::fprintf(stderr, "Failed to write %s\n", outFile.c_str());
+		return 1;
+	}
+
+	if (!baselineFile.empty())
+	{
+		std::vector<BenchmarkResult> baseline;
+		if (!BenchmarkRunner::ReadCsv(baselineFile, baseline))
+		{
+			std::fprintf(stderr, "Failed to read baseline %s\n", baselineFile.c_str());
+			return 1;
+		}
+
+		auto regressions = BenchmarkRunner::Compare(results, baseline, tolerance);
+		std::printf("\n%d regression(s) beyond %.1f%%\n", regressions, tolerance);
+
+		if (failOnRegression && regressions > 0)
+			return 2;
+	}
+
+	return 0;
+}
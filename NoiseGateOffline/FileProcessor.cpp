@@ -0,0 +1,504 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+#include "AudioLib/Utils.h"
+#include "NoiseGateKernel.h"
+
+#include "FileProcessor.h"
+
+using namespace AudioLib;
+
+namespace NoiseInvader
+{
+	namespace Offline
+	{
+		// Gain statistics gathered from the kernel telemetry, weighted by sample count
+		struct GainStats
+		{
+			double GainSum = 0;
+			double OpenSum = 0;
+			double MinGain = 0;
+			uint64_t Samples = 0;
+
+			void Add(const GateTelemetry& record)
+			{
+				GainSum += (double)record.MeanGainDb * record.SampleCount;
+				OpenSum += (double)record.OpenFraction * record.SampleCount;
+				Samples += record.SampleCount;
+				if (record.MinGainDb < MinGain)
+					MinGain = record.MinGainDb;
+			}
+
+			void Add(const GainStats& other)
+			{
+				GainSum += other.GainSum;
+				OpenSum += other.OpenSum;
+				Samples += other.Samples;
+				MinGain = std::min(MinGain, other.MinGain);
+			}
+
+			// Takes out the sums of a stretch that was processed again. The minimum can't be taken out and stays
+			void Subtract(const GainStats& other)
+			{
+				GainSum -= other.GainSum;
+				OpenSum -= other.OpenSum;
+				Samples -= other.Samples;
+			}
+
+			void Store(FileStats& stats) const
+			{
+				stats.MeanGainDb = Samples > 0 ? GainSum / Samples : 0;
+				stats.OpenFraction = Samples > 0 ? OpenSum / Samples : 0;
+				stats.MinGainDb = MinGain;
+			}
+		};
+
+		// One kernel per channel pair, configured from the settings
+		template<typename TKernel>
+		static std::vector<std::unique_ptr<TKernel>> CreateKernels(const Settings& settings, const WavFormat& format)
+		{
+			std::vector<std::unique_ptr<TKernel>> kernels;
+			for (int p = 0; p < (format.Channels + 1) / 2; p++)
+			{
+				auto kernel = std::unique_ptr<TKernel>(new TKernel(format.SampleRate));
+				kernel->Precision = settings.Precision;
+				kernel->DetectorGain = Utils::DB2gain(settings.SensitivityDb);
+				kernel->ReductionDb = -settings.ReductionDb;
+				kernel->ThresholdDb = settings.ThresholdDb;
+				kernel->Slope = settings.Slope;
+				kernel->ReleaseMs = settings.ReleaseMs;
+				kernel->LookaheadMs = settings.LookaheadMs;
+				kernel->UpdateAll();
+				kernels.push_back(std::move(kernel));
+			}
+
+			return kernels;
+		}
+
+		// Largest state distance between two sets of kernels, see NoiseGateKernelT::GetStateDistanceDb
+		template<typename TKernel>
+		static double GetStateDistanceDb(const std::vector<std::unique_ptr<TKernel>>& a, const std::vector<std::unique_ptr<TKernel>>& b)
+		{
+			double distance = 0;
+			for (size_t p = 0; p < a.size(); p++)
+				distance = std::max(distance, a[p]->GetStateDistanceDb(*b[p]));
+			return distance;
+		}
+
+		// Sizes the chunk buffers: one extra input channel as silent partner for an odd last channel
+		static void PrepareScratch(Scratch& scratch, int channels, int auxChannels, int chunk)
+		{
+			if ((int)scratch.In.size() < channels + 1)
+			{
+				scratch.In.resize(channels + 1);
+				scratch.Out.resize(channels + 1);
+			}
+
+			for (int c = 0; c <= channels; c++)
+			{
+				scratch.In[c].resize(chunk);
+				scratch.Out[c].resize(chunk);
+				std::fill(scratch.In[c].begin(), scratch.In[c].end(), 0.0f);
+			}
+
+			scratch.AuxChannels.resize(auxChannels);
+			for (auto& a : scratch.AuxChannels)
+				a.resize(chunk);
+		}
+
+		/// <summary>
+		/// Reads count frames from frame pos of the input, and of the aux file if there is one, into the chunk buffers.
+		/// Frames past the end read as silence. Returns the detector signal, or null to key each pair from its left channel
+		/// </summary>
+		static const float* ReadChunk(const Settings& settings, WavReader& input, WavReader* aux, Scratch& scratch, IoLimiter* io, uint64_t pos, int count)
+		{
+			std::vector<float*> in;
+			for (int c = 0; c < input.GetFormat().Channels; c++)
+				in.push_back(&scratch.In[c][0]);
+
+			std::vector<float*> auxIn;
+			for (auto& a : scratch.AuxChannels)
+				auxIn.push_back(&a[0]);
+
+			IoLimiter::Scope slot(io);
+			input.Read(pos, count, &in[0]);
+			if (aux != nullptr)
+			{
+				aux->Read(pos, count, &auxIn[0]);
+				return auxIn[0];
+			}
+
+			return settings.AuxChannel >= 0 ? in[settings.AuxChannel] : nullptr;
+		}
+
+		/// <summary>
+		/// Runs the chunk in the scratch input buffers through the kernels, one per channel pair, into out.
+		/// The telemetry of each call goes to gains if given, and is dropped otherwise. If gainDb is given, the gain
+		/// of each pair in dB is traced into it
+		/// </summary>
+		template<typename TKernel>
+		static void RunKernels(std::vector<std::unique_ptr<TKernel>>& kernels, Scratch& scratch, const float* key,
+			std::vector<std::vector<float>>& out, int count, GainStats* gains, std::vector<std::vector<double>>* gainDb = nullptr)
+		{
+			int channels = scratch.Input.GetFormat().Channels;
+			for (size_t p = 0; p < kernels.size(); p++)
+			{
+				int left = (int)p * 2;
+				int right = left + 1 < channels ? left + 1 : channels; // odd last channel: silent partner
+				auto detector = key != nullptr ? key : &scratch.In[left][0];
+				StageTrace trace = { nullptr, nullptr, gainDb != nullptr ? &(*gainDb)[p][0] : nullptr };
+				kernels[p]->Process(&scratch.In[left][0], &scratch.In[right][0], const_cast<float*>(detector), &out[left][0], &out[right][0], count, &trace);
+
+				// one record per Process call, polled right away so the ring never overflows
+				GateTelemetry record;
+				while (kernels[p]->PollTelemetry(record))
+				{
+					if (gains != nullptr)
+						gains->Add(record);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Streams the input through the kernels in chunks of ChunkFrames. The first latency frames of the output are
+		/// dropped and the input is padded with as many frames of silence at the end, so the output has the length
+		/// and timing of the input
+		/// </summary>
+		template<typename TKernel>
+		static bool Process(const Settings& settings, WavReader* aux, Scratch& scratch, IoLimiter* io, FileStats& stats)
+		{
+			auto& input = scratch.Input;
+			auto format = input.GetFormat();
+			int channels = format.Channels;
+			int chunk = settings.ChunkFrames;
+
+			auto kernels = CreateKernels<TKernel>(settings, format);
+			int latency = kernels[0]->GetLatencySamples();
+			PrepareScratch(scratch, channels, aux != nullptr ? aux->GetFormat().Channels : 0, chunk);
+
+			std::vector<const float*> out(channels);
+			GainStats gains;
+
+			uint64_t totalFrames = input.GetFrameCount() + latency;
+			for (uint64_t pos = 0; pos < totalFrames; pos += chunk)
+			{
+				int count = (int)std::min<uint64_t>(totalFrames - pos, chunk);
+				auto key = ReadChunk(settings, input, aux, scratch, io, pos, count);
+				RunKernels(kernels, scratch, key, scratch.Out, count, &gains);
+
+				// latency compensation, drop the frames before the delayed signal starts
+				int skip = (int)std::min<uint64_t>(pos < (uint64_t)latency ? latency - pos : 0, count);
+				if (skip == count)
+					continue;
+
+				for (int c = 0; c < channels; c++)
+					out[c] = &scratch.Out[c][skip];
+
+				IoLimiter::Scope slot(io);
+				if (!scratch.Output.Write(&out[0], count - skip))
+					return false;
+			}
+
+			gains.Store(stats);
+			return true;
+		}
+
+		// ------------------------------------------------------------------------------------
+		// Segmented processing of one long file
+
+		template<typename TKernel>
+		struct Segment
+		{
+			// output frames [Begin, End) of the file
+			uint64_t Begin;
+			uint64_t End;
+
+			// the kernels after their segment, continued at the next seam
+			std::vector<std::unique_ptr<TKernel>> Kernels;
+
+			// their state at Begin, after the warm-up, to replay the segment at its seam
+			std::vector<std::unique_ptr<typename TKernel::Snapshot>> Start;
+			GainStats Gains;
+			bool Ok;
+			std::string Error;
+		};
+
+		/// <summary>
+		/// Opens its own readers, so segments can run on separate threads
+		/// </summary>
+		struct SegmentReaders
+		{
+			Scratch Buffers;
+			WavReader* Aux = nullptr;
+
+			bool Open(const Settings& settings, const std::string& inputPath, std::string& error)
+			{
+				if (!Buffers.Input.Open(inputPath, error))
+					return false;
+
+				if (!settings.AuxFile.empty())
+				{
+					if (!Buffers.Aux.Open(settings.AuxFile, error))
+						return false;
+					Aux = &Buffers.Aux;
+				}
+
+				PrepareScratch(Buffers, Buffers.Input.GetFormat().Channels, Aux != nullptr ? Aux->GetFormat().Channels : 0, settings.ChunkFrames);
+				return true;
+			}
+		};
+
+		/// <summary>
+		/// Runs kernels over kernel time [from, to). Kernel time t produces output frame t - latency. The output is written
+		/// to the file if output is given and dropped otherwise
+		/// </summary>
+		template<typename TKernel>
+		static bool RunRange(const Settings& settings, SegmentReaders& readers, std::vector<std::unique_ptr<TKernel>>& kernels,
+			uint64_t from, uint64_t to, int latency, WavWriter* output, GainStats* gains, IoLimiter* io)
+		{
+			auto& scratch = readers.Buffers;
+			int channels = readers.Buffers.Input.GetFormat().Channels;
+			std::vector<const float*> out(channels);
+
+			for (uint64_t pos = from; pos < to; pos += settings.ChunkFrames)
+			{
+				int count = (int)std::min<uint64_t>(to - pos, settings.ChunkFrames);
+				auto key = ReadChunk(settings, scratch.Input, readers.Aux, scratch, io, pos, count);
+				RunKernels(kernels, scratch, key, scratch.Out, count, gains);
+
+				if (output == nullptr)
+					continue;
+
+				for (int c = 0; c < channels; c++)
+					out[c] = &scratch.Out[c][0];
+
+				IoLimiter::Scope slot(io);
+				if (!output->WriteAt(pos - latency, &out[0], count))
+					return false;
+			}
+
+			return true;
+		}
+
+		/// <summary>
+		/// Splits the file into segments gated in parallel. Each segment's kernels start GetWarmupSamples() ahead of it
+		/// with the output dropped, which settles the follower and the slew limiter. The expander has hysteresis that no
+		/// warm-up can settle, so each seam is then checked: the kernels of the previous segment run on into the next one,
+		/// next to a replay of that segment's warmed-up kernels (restored from a snapshot taken after the warm-up), and overwrite its output until the two states have
+		/// converged. That output is what the serial run produces; the gain difference measured on the way is the error
+		/// the seam would have had without it.
+		/// No segment is made shorter than the warm-up, a file too short for two of them is processed serially
+		/// </summary>
+		template<typename TKernel>
+		static bool ProcessSegmented(const Settings& settings, const std::string& inputPath, WavReader* aux, Scratch& scratch,
+			IoLimiter* io, FileStats& stats, std::string& error)
+		{
+			auto format = scratch.Input.GetFormat();
+			uint64_t frames = scratch.Input.GetFrameCount();
+			int channels = format.Channels;
+			int chunk = settings.ChunkFrames;
+
+			auto probe = CreateKernels<TKernel>(settings, format);
+			int latency = probe[0]->GetLatencySamples();
+			uint64_t warmup = (uint64_t)probe[0]->GetWarmupSamples();
+
+			uint64_t maxCount = frames / std::max<uint64_t>(warmup, 1);
+			int count = (int)std::min<uint64_t>(settings.Segments, maxCount);
+			if (count < 2)
+				return Process<TKernel>(settings, aux, scratch, io, stats);
+
+			uint64_t segmentLength = (frames + count - 1) / count;
+			std::vector<Segment<TKernel>> segments;
+			for (uint64_t begin = 0; begin < frames; begin += segmentLength)
+				segments.push_back({ begin, std::min(begin + segmentLength, frames), {}, {}, GainStats(), false, "" });
+
+			// warm-up start in kernel time, output frame begin comes out at kernel time begin + latency
+			auto warmupStart = [&](const Segment<TKernel>& s) { return s.Begin + latency > warmup ? s.Begin + latency - warmup : 0; };
+
+			// 1. every segment on its own thread, output written in place
+			std::vector<std::thread> threads;
+			for (auto& segment : segments)
+			{
+				threads.push_back(std::thread([&, s = &segment]()
+				{
+					SegmentReaders readers;
+					s->Ok = readers.Open(settings, inputPath, s->Error);
+					if (!s->Ok)
+						return;
+
+					s->Kernels = CreateKernels<TKernel>(settings, format);
+					RunRange(settings, readers, s->Kernels, warmupStart(*s), s->Begin + latency, latency, nullptr, nullptr, io);
+					for (auto& kernel : s->Kernels)
+					{
+						s->Start.push_back(std::unique_ptr<typename TKernel::Snapshot>(new typename TKernel::Snapshot()));
+						kernel->TakeSnapshot(*s->Start.back());
+					}
+
+					s->Ok = RunRange(settings, readers, s->Kernels, s->Begin + latency, s->End + latency, latency, &scratch.Output, &s->Gains, io);
+					if (!s->Ok)
+						s->Error = "failed to write segment";
+				}));
+			}
+
+			for (auto& thread : threads)
+				thread.join();
+
+			GainStats gains;
+			for (auto& segment : segments)
+			{
+				if (!segment.Ok)
+				{
+					error = inputPath + ": " + segment.Error;
+					return false;
+				}
+
+				gains.Add(segment.Gains);
+			}
+
+			// 2. the seams in order. previous holds the kernels on the serial trajectory, at the start of the next segment
+			SegmentReaders readers;
+			if (!readers.Open(settings, inputPath, error))
+				return false;
+
+			std::vector<std::vector<float>> replayOut(channels + 1, std::vector<float>(chunk));
+			std::vector<std::vector<double>> gainDb(probe.size(), std::vector<double>(chunk));
+			std::vector<std::vector<double>> replayGainDb(probe.size(), std::vector<double>(chunk));
+			std::vector<const float*> out(channels);
+			double seamErrorDb = 0;
+			double seamError = 0;
+			uint64_t stitched = 0;
+
+			// the statistics of the re-run stretches replace those of the segments there
+			GainStats stitchedGains;
+			GainStats replacedGains;
+
+			auto previous = std::move(segments[0].Kernels);
+			for (size_t k = 1; k < segments.size(); k++)
+			{
+				auto& segment = segments[k];
+				auto replay = CreateKernels<TKernel>(settings, format);
+				for (size_t p = 0; p < replay.size(); p++)
+					replay[p]->RestoreSnapshot(*segment.Start[p]);
+
+				uint64_t pos = segment.Begin + latency;
+				uint64_t end = segment.End + latency;
+				while (pos < end && GetStateDistanceDb(previous, replay) > TKernel::ConvergedDistanceDb)
+				{
+					int n = (int)std::min<uint64_t>(end - pos, chunk);
+					auto key = ReadChunk(settings, readers.Buffers.Input, readers.Aux, readers.Buffers, io, pos, n);
+
+					RunKernels(previous, readers.Buffers, key, readers.Buffers.Out, n, &stitchedGains, &gainDb);
+					RunKernels(replay, readers.Buffers, key, replayOut, n, &replacedGains, &replayGainDb);
+
+					for (size_t p = 0; p < probe.size(); p++)
+					{
+						for (int i = 0; i < n; i++)
+							seamErrorDb = std::max(seamErrorDb, std::abs(gainDb[p][i] - replayGainDb[p][i]));
+					}
+
+					for (int c = 0; c < channels; c++)
+					{
+						for (int i = 0; i < n; i++)
+							seamError = std::max(seamError, (double)std::abs(readers.Buffers.Out[c][i] - replayOut[c][i]));
+						out[c] = &readers.Buffers.Out[c][0];
+					}
+
+					IoLimiter::Scope slot(io);
+					if (!scratch.Output.WriteAt(pos - latency, &out[0], n))
+					{
+						error = "failed to write seam";
+						return false;
+					}
+
+					pos += n;
+					stitched += n;
+				}
+
+				// converged: the rest of the segment is good and its kernels carry on. Otherwise previous has run
+				// through the whole segment and carries on itself
+				if (pos < end || GetStateDistanceDb(previous, replay) <= TKernel::ConvergedDistanceDb)
+					previous = std::move(segment.Kernels);
+			}
+
+			gains.Add(stitchedGains);
+			gains.Subtract(replacedGains);
+			gains.Store(stats);
+			stats.Segments = (int)segments.size();
+			stats.WarmupSeconds = (double)warmup / format.SampleRate;
+			stats.StitchedSeconds = (double)stitched / format.SampleRate;
+			stats.SeamErrorDb = seamErrorDb;
+			stats.SeamError = seamError;
+			return true;
+		}
+
+		bool ProcessFile(const Settings& settings, const std::string& inputPath, const std::string& outputPath,
+			Scratch& scratch, IoLimiter* io, FileStats& stats, std::string& error)
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			if (!scratch.Input.Open(inputPath, error))
+				return false;
+
+			auto format = scratch.Input.GetFormat();
+			if (settings.AuxChannel >= format.Channels)
+			{
+				error = inputPath + ": aux channel " + std::to_string(settings.AuxChannel) + " does not exist, the input has "
+					+ std::to_string(format.Channels) + " channels";
+				return false;
+			}
+
+			WavReader* aux = nullptr;
+			if (!settings.AuxFile.empty())
+			{
+				if (!scratch.Aux.Open(settings.AuxFile, error))
+					return false;
+
+				if (scratch.Aux.GetFormat().SampleRate != format.SampleRate)
+				{
+					error = "the aux file has a different samplerate than " + inputPath;
+					return false;
+				}
+
+				aux = &scratch.Aux;
+			}
+
+			if (!scratch.Output.Open(outputPath, format, error))
+				return false;
+
+			bool ok;
+			if (settings.Segments > 1)
+			{
+				ok = settings.DoublePrecision
+					? ProcessSegmented<NoiseGateKernelDouble>(settings, inputPath, aux, scratch, io, stats, error)
+					: ProcessSegmented<NoiseGateKernel>(settings, inputPath, aux, scratch, io, stats, error);
+			}
+			else
+			{
+				ok = settings.DoublePrecision
+					? Process<NoiseGateKernelDouble>(settings, aux, scratch, io, stats)
+					: Process<NoiseGateKernel>(settings, aux, scratch, io, stats);
+			}
+
+			{
+				IoLimiter::Scope slot(io);
+				ok &= scratch.Output.Close();
+			}
+
+			if (!ok)
+			{
+				if (error.empty())
+					error = "failed to write " + outputPath;
+				return false;
+			}
+
+			stats.Channels = format.Channels;
+			stats.Frames = scratch.Input.GetFrameCount();
+			stats.AudioSeconds = (double)stats.Frames / format.SampleRate;
+			stats.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			return true;
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AudioLib/VectorMath.h"
+
+#include "IoLimiter.h"
+#include "WavFile.h"
+
+namespace NoiseInvader
+{
+	namespace Offline
+	{
+		// The plugin parameters, in the plugin's display units and ranges
+		struct Settings
+		{
+			double SensitivityDb = 0;
+			double ReductionDb = 100;
+			double ThresholdDb = -20;
+			double Slope = 3;
+			double ReleaseMs = 100;
+			double LookaheadMs = 0;
+			bool AuxDetector = false;
+			std::string AuxFile;
+			int AuxChannel = -1;
+			AudioLib::MathPrecision Precision = AudioLib::MathPrecision::Db001;
+			bool DoublePrecision = false;
+			int ChunkFrames = 65536;
+
+			// Above 1, the file is split into this many segments gated on separate threads
+			int Segments = 1;
+		};
+
+		// Runtime and gain reduction of one processed file, gains in dB as in GateTelemetry
+		struct FileStats
+		{
+			int Channels = 0;
+			uint64_t Frames = 0;
+			double AudioSeconds = 0;
+			double Seconds = 0;
+			double MeanGainDb = 0;
+			double MinGainDb = 0;
+			double OpenFraction = 0;
+
+			// Segmented processing: warm-up ahead of each segment, audio re-run at the seams until the kernels converged,
+			// and the largest gain (dB) and sample deviation found there, which the seams would have had without the re-run
+			int Segments = 1;
+			double WarmupSeconds = 0;
+			double StitchedSeconds = 0;
+			double SeamErrorDb = 0;
+			double SeamError = 0;
+		};
+
+		/// <summary>
+		/// Chunk buffers and file objects of one worker thread. They are kept between files so a batch
+		/// only allocates when a file needs more channels than any before it
+		/// </summary>
+		struct Scratch
+		{
+			WavReader Input;
+			WavReader Aux;
+			WavWriter Output;
+			std::vector<std::vector<float>> In;
+			std::vector<std::vector<float>> Out;
+			std::vector<std::vector<float>> AuxChannels;
+		};
+
+		/// <summary>
+		/// Gates inputPath into outputPath. Reads, writes and closing the output take a slot of io if it is
+		/// given, the processing in between runs without one. Returns false and sets error on failure
+		/// </summary>
+		bool ProcessFile(const Settings& settings, const std::string& inputPath, const std::string& outputPath,
+			Scratch& scratch, IoLimiter* io, FileStats& stats, std::string& error);
+	}
+}
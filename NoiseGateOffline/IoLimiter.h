@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+namespace NoiseInvader
+{
+	namespace Offline
+	{
+		/// <summary>
+		/// Counting semaphore that bounds how many threads touch the disk at once. Batch workers hold a slot
+		/// only while they read or write a chunk, so the processing of one file overlaps the I/O of another
+		/// without every worker seeking on the same disk
+		/// </summary>
+		class IoLimiter
+		{
+		private:
+			std::mutex lock;
+			std::condition_variable released;
+			int available;
+
+		public:
+			explicit IoLimiter(int slots) : available(slots) { }
+
+			void Acquire()
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				released.wait(guard, [this] { return available > 0; });
+				available--;
+			}
+
+			void Release()
+			{
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					available++;
+				}
+				released.notify_one();
+			}
+
+			// Holds a slot for its lifetime, does nothing if limiter is null
+			class Scope
+			{
+			private:
+				IoLimiter* limiter;
+
+			public:
+				explicit Scope(IoLimiter* limiter) : limiter(limiter)
+				{
+					if (limiter != nullptr)
+						limiter->Acquire();
+				}
+
+				~Scope()
+				{
+					if (limiter != nullptr)
+						limiter->Release();
+				}
+
+				Scope(const Scope&) = delete;
+				Scope& operator=(const Scope&) = delete;
+			};
+		};
+	}
+}
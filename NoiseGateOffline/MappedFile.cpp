@@ -0,0 +1,157 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace NoiseInvader
+{
+	namespace Offline
+	{
+		MappedFile::MappedFile()
+		{
+#ifdef _WIN32
+			fileHandle = INVALID_HANDLE_VALUE;
+			mappingHandle = nullptr;
+#else
+			fd = -1;
+#endif
+			size = 0;
+			view = nullptr;
+			viewOffset = 0;
+			viewLength = 0;
+		}
+
+		MappedFile::~MappedFile()
+		{
+			Close();
+		}
+
+		bool MappedFile::Open(const std::string& path)
+		{
+			Close();
+
+#ifdef _WIN32
+			fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (fileHandle == INVALID_HANDLE_VALUE)
+				return false;
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+			{
+				Close();
+				return false;
+			}
+
+			size = (uint64_t)fileSize.QuadPart;
+			mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mappingHandle == nullptr)
+			{
+				Close();
+				return false;
+			}
+#else
+			fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+
+			struct stat st;
+			if (fstat(fd, &st) != 0 || st.st_size == 0)
+			{
+				Close();
+				return false;
+			}
+
+			size = (uint64_t)st.st_size;
+#endif
+			return true;
+		}
+
+		void MappedFile::Close()
+		{
+			Unmap();
+
+#ifdef _WIN32
+			if (mappingHandle != nullptr)
+				CloseHandle(mappingHandle);
+			if (fileHandle != INVALID_HANDLE_VALUE)
+				CloseHandle(fileHandle);
+			mappingHandle = nullptr;
+			fileHandle = INVALID_HANDLE_VALUE;
+#else
+			if (fd >= 0)
+				close(fd);
+			fd = -1;
+#endif
+			size = 0;
+		}
+
+		const uint8_t* MappedFile::Map(uint64_t offset, size_t length)
+		{
+			if (offset + length > size)
+				return nullptr;
+
+			if (view != nullptr && offset >= viewOffset && offset + length <= viewOffset + viewLength)
+				return view + (offset - viewOffset);
+
+			Unmap();
+
+			// the window starts on an allocation boundary and always covers the requested range
+			uint64_t start = offset - offset % Granularity();
+			uint64_t end = offset + length;
+			if (end - start < WindowSize)
+				end = start + WindowSize;
+			if (end > size)
+				end = size;
+
+#ifdef _WIN32
+			auto ptr = MapViewOfFile(mappingHandle, FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)(start & 0xFFFFFFFF), (SIZE_T)(end - start));
+			if (ptr == nullptr)
+				return nullptr;
+#else
+			auto ptr = mmap(nullptr, (size_t)(end - start), PROT_READ, MAP_SHARED, fd, (off_t)start);
+			if (ptr == MAP_FAILED)
+				return nullptr;
+
+			madvise(ptr, (size_t)(end - start), MADV_SEQUENTIAL);
+#endif
+			view = (uint8_t*)ptr;
+			viewOffset = start;
+			viewLength = (size_t)(end - start);
+			return view + (offset - viewOffset);
+		}
+
+		void MappedFile::Unmap()
+		{
+			if (view == nullptr)
+				return;
+
+#ifdef _WIN32
+			UnmapViewOfFile(view);
+#else
+			munmap(view, viewLength);
+#endif
+			view = nullptr;
+			viewOffset = 0;
+			viewLength = 0;
+		}
+
+		size_t MappedFile::Granularity()
+		{
+#ifdef _WIN32
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			return info.dwAllocationGranularity;
+#else
+			return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace NoiseInvader
+{
+	namespace Offline
+	{
+		/// <summary>
+		/// Read-only memory mapping of a file through a sliding window. Only WindowSize bytes are mapped at any
+		/// time, so files of any size can be read with flat memory use (and on 32 bit systems)
+		/// </summary>
+		class MappedFile
+		{
+		public:
+			static const size_t WindowSize = 64 << 20;
+
+		private:
+#ifdef _WIN32
+			void* fileHandle;
+			void* mappingHandle;
+#else
+			int fd;
+#endif
+			uint64_t size;
+			uint8_t* view;
+			uint64_t viewOffset;
+			size_t viewLength;
+
+		public:
+			MappedFile();
+			~MappedFile();
+
+			bool Open(const std::string& path);
+			void Close();
+
+			uint64_t Size() const { return size; }
+
+			/// <summary>
+			/// Returns a pointer to length bytes at offset, or null if the range is outside the file or
+			/// can't be mapped. The pointer stays valid until the next call to Map
+			/// </summary>
+			const uint8_t* Map(uint64_t offset, size_t length);
+
+		private:
+			void Unmap();
+			static size_t Granularity();
+		};
+	}
+}
@@ -0,0 +1,430 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AudioLib/Utils.h"
+#include "NoiseGateKernel.h"
+
+#include "FileProcessor.h"
+#include "WorkStealingPool.h"
+
+using namespace AudioLib;
+using namespace NoiseInvader;
+using namespace NoiseInvader::Offline;
+
+namespace fs = std::filesystem;
+
+struct BatchOptions
+{
+	std::string Source;
+	std::string OutDir;
+	std::string SummaryFile;
+	int Jobs = 0;
+	int IoJobs = 2;
+};
+
+struct BatchItem
+{
+	std::string Input;
+	std::string Output;
+	uint64_t Size = 0;
+	bool Ok = false;
+	std::string Error;
+	FileStats Stats;
+};
+
+static void PrintUsage()
+{
+	std::printf(
+		"Usage: NoiseGateOffline [options] <input.wav> <output.wav>\n"
+		"       NoiseGateOffline [options] --batch <directory|list.txt> --out-dir <directory>\n"
+		"Gates every channel pair of a WAV / RF64 file (16, 24, 32 bit int or 32 bit float) and writes the\n"
+		"result in the same format. Lookahead latency is compensated, the output lines up with the input.\n"
+		"  --sensitivity <dB>     detector gain, -20...20 (default 0)\n"
+		"  --reduction <dB>       maximum gain reduction, 0...100 (default 100)\n"
+		"  --threshold <dB>       -80...0 (default -20)\n"
+		"  --slope <ratio>        expansion slope, 1...51 (default 3)\n"
+		"  --release <ms>         10...1000 (default 100)\n"
+		"  --lookahead <ms>       0...10 (default 0)\n"
+		"  --detector main|aux    detection from the left channel of each pair (default) or from the aux signal\n"
+		"  --aux <file.wav>       aux signal for --detector aux, first channel of the file (not with --batch)\n"
+		"  --aux-channel <n>      aux signal for --detector aux, channel n (from 0) of the input file\n"
+		"  --precision <mode>     dB conversion accuracy: exact, 0.01 (default) or 0.1\n"
+		"  --double               run the gain chain in double precision, with exact dB conversions by default\n"
+		"  --chunk <frames>       frames processed per chunk (default 65536)\n"
+		"  --segments <n>         split one long file into n segments gated in parallel (not with --batch)\n"
+		"Batch mode:\n"
+		"  --batch <source>       every .wav file below a directory, or the files listed in a text file (one per line)\n"
+		"  --out-dir <directory>  output directory, a directory source keeps its subdirectories\n"
+		"  --jobs <n>             worker threads (default: number of cores)\n"
+		"  --io-jobs <n>          workers or segments reading or writing at the same time (default 2)\n"
+		"  --summary <file.csv>   per-file runtime and gain reduction as CSV\n");
+}
+
+static bool ParseRange(const char* text, double min, double max, const char* name, double& value)
+{
+	char* end;
+	value = std::strtod(text, &end);
+	if (*end != 0 || value < min || value > max)
+	{
+		std::fprintf(stderr, "%s must be a number between %g and %g\n", name, min, max);
+		return false;
+	}
+
+	return true;
+}
+
+static void PrintStats(const std::string& name, const FileStats& stats)
+{
+	std::printf("%s: %d channels, %.1f s of audio in %.2f s (%.0fx realtime), gain mean %.1f dB, min %.1f dB, open %.0f%%\n",
+		name.c_str(), stats.Channels, stats.AudioSeconds, stats.Seconds, stats.AudioSeconds / stats.Seconds,
+		stats.MeanGainDb, stats.MinGainDb, stats.OpenFraction * 100);
+}
+
+static void PrintSegmentStats(const FileStats& stats)
+{
+	std::printf("%d segments, %.0f ms warm-up each. %.2f s re-run at the seams until the kernels converged to within %g dB,\n"
+		"the seams would have deviated from the serial result by up to %.3g dB of gain / %.1f dBFS without it\n",
+		stats.Segments, stats.WarmupSeconds * 1000, stats.StitchedSeconds, NoiseGateKernel::ConvergedDistanceDb,
+		stats.SeamErrorDb, 20 * std::log10(std::max(stats.SeamError, 1e-10)));
+}
+
+static bool IsWavFile(const fs::path& path)
+{
+	auto extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+	return extension == ".wav";
+}
+
+/// <summary>
+/// Collects the batch from a directory (recursive, the output mirrors the subdirectories) or from a list file
+/// (outputs are named after the input file). Sorted largest first for the pool, see WorkStealingPool
+/// </summary>
+static bool CollectBatch(const BatchOptions& options, std::vector<BatchItem>& items)
+{
+	std::error_code ec;
+	fs::path source(options.Source);
+	fs::path outDir(options.OutDir);
+
+	if (fs::is_directory(source, ec))
+	{
+		for (auto it = fs::recursive_directory_iterator(source, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec))
+		{
+			if (!it->is_regular_file(ec) || !IsWavFile(it->path()))
+				continue;
+
+			BatchItem item;
+			item.Input = it->path().string();
+			item.Output = (outDir / fs::relative(it->path(), source, ec)).string();
+			items.push_back(item);
+		}
+
+		if (ec)
+		{
+			std::fprintf(stderr, "can't read directory %s: %s\n", options.Source.c_str(), ec.message().c_str());
+			return false;
+		}
+	}
+	else
+	{
+		std::ifstream list(options.Source);
+		if (!list)
+		{
+			std::fprintf(stderr, "can't open %s\n", options.Source.c_str());
+			return false;
+		}
+
+		std::string line;
+		while (std::getline(list, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			if (line.empty() || line[0] == '#')
+				continue;
+
+			BatchItem item;
+			item.Input = line;
+			item.Output = (outDir / fs::path(line).filename()).string();
+			items.push_back(item);
+		}
+	}
+
+	std::set<std::string> outputs;
+	for (auto& item : items)
+	{
+		if (!outputs.insert(item.Output).second)
+		{
+			std::fprintf(stderr, "more than one input would be written to %s\n", item.Output.c_str());
+			return false;
+		}
+
+		if (fs::equivalent(item.Input, item.Output, ec))
+		{
+			std::fprintf(stderr, "%s would overwrite its input\n", item.Input.c_str());
+			return false;
+		}
+
+		item.Size = fs::file_size(item.Input, ec);
+		if (ec)
+			item.Size = 0;
+	}
+
+	std::stable_sort(items.begin(), items.end(), [](const BatchItem& a, const BatchItem& b) { return a.Size > b.Size; });
+	return true;
+}
+
+static bool WriteSummary(const std::string& path, const std::vector<BatchItem>& items)
+{
+	FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr)
+		return false;
+
+	std::fprintf(file, "file,status,channels,audio_s,runtime_s,realtime,mean_gain_db,min_gain_db,open_fraction,error\n");
+	for (auto& item : items)
+	{
+		auto& s = item.Stats;
+		if (item.Ok)
+			std::fprintf(file, "\"%s\",ok,%d,%.3f,%.3f,%.1f,%.2f,%.2f,%.4f,\n", item.Input.c_str(), s.Channels, s.AudioSeconds,
+				s.Seconds, s.AudioSeconds / s.Seconds, s.MeanGainDb, s.MinGainDb, s.OpenFraction);
+		else
+			std::fprintf(file, "\"%s\",failed,,,,,,,,\"%s\"\n", item.Input.c_str(), item.Error.c_str());
+	}
+
+	return std::fclose(file) == 0;
+}
+
+static int RunBatch(const Settings& settings, const BatchOptions& options)
+{
+	std::vector<BatchItem> items;
+	if (!CollectBatch(options, items))
+		return 1;
+
+	if (items.empty())
+	{
+		std::fprintf(stderr, "no .wav files in %s\n", options.Source.c_str());
+		return 1;
+	}
+
+	int jobs = options.Jobs > 0 ? options.Jobs : (int)std::thread::hardware_concurrency();
+	if (jobs < 1)
+		jobs = 1;
+	if (jobs > (int)items.size())
+		jobs = (int)items.size();
+
+	std::printf("%d files, %d workers, %d I/O slots\n", (int)items.size(), jobs, options.IoJobs);
+
+	IoLimiter io(options.IoJobs);
+	std::vector<Scratch> scratch(jobs);
+	std::mutex printLock;
+
+	auto start = std::chrono::steady_clock::now();
+	{
+		WorkStealingPool pool(jobs);
+		for (auto& item : items)
+		{
+			BatchItem* current = &item;
+			pool.Submit([&, current](int worker)
+			{
+				std::error_code ec;
+				fs::create_directories(fs::path(current->Output).parent_path(), ec);
+				current->Ok = ProcessFile(settings, current->Input, current->Output, scratch[worker], &io, current->Stats, current->Error);
+
+				std::lock_guard<std::mutex> guard(printLock);
+				if (current->Ok)
+					PrintStats(current->Output, current->Stats);
+				else
+					std::fprintf(stderr, "%s\n", current->Error.c_str());
+			});
+		}
+
+		pool.Wait();
+	}
+	double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	int failed = 0;
+	double audioSeconds = 0;
+	double fileSeconds = 0;
+	double gainSum = 0;
+	double minGain = 0;
+	for (auto& item : items)
+	{
+		if (!item.Ok)
+		{
+			failed++;
+			continue;
+		}
+
+		audioSeconds += item.Stats.AudioSeconds;
+		fileSeconds += item.Stats.Seconds;
+		gainSum += item.Stats.MeanGainDb * item.Stats.AudioSeconds;
+		minGain = std::min(minGain, item.Stats.MinGainDb);
+	}
+
+	std::printf("\n%d files processed, %d failed, %.1f s of audio in %.2f s (%.0fx realtime)\n",
+		(int)items.size() - failed, failed, audioSeconds, wallSeconds, audioSeconds / wallSeconds);
+	std::printf("per-file time %.2f s in total, %.2f files in flight on average on %d workers\n", fileSeconds, fileSeconds / wallSeconds, jobs);
+	if (audioSeconds > 0)
+		std::printf("gain mean %.1f dB, min %.1f dB\n", gainSum / audioSeconds, minGain);
+
+	if (!options.SummaryFile.empty() && !WriteSummary(options.SummaryFile, items))
+	{
+		std::fprintf(stderr, "failed to write %s\n", options.SummaryFile.c_str());
+		return 1;
+	}
+
+	return failed > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+	Settings settings;
+	BatchOptions batch;
+	std::vector<std::string> files;
+	bool precisionSet = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		bool ok = true;
+		double value;
+
+		if (arg == "--sensitivity" && hasValue)
+			ok = ParseRange(argv[++i], -20, 20, "sensitivity", settings.SensitivityDb);
+		else if (arg == "--reduction" && hasValue)
+			ok = ParseRange(argv[++i], 0, 100, "reduction", settings.ReductionDb);
+		else if (arg == "--threshold" && hasValue)
+			ok = ParseRange(argv[++i], -80, 0, "threshold", settings.ThresholdDb);
+		else if (arg == "--slope" && hasValue)
+			ok = ParseRange(argv[++i], 1, 51, "slope", settings.Slope);
+		else if (arg == "--release" && hasValue)
+			ok = ParseRange(argv[++i], 10, 1000, "release", settings.ReleaseMs);
+		else if (arg == "--lookahead" && hasValue)
+			ok = ParseRange(argv[++i], 0, NoiseGateKernel::MaxLookaheadMs, "lookahead", settings.LookaheadMs);
+		else if (arg == "--detector" && hasValue)
+		{
+			std::string mode = argv[++i];
+			ok = mode == "main" || mode == "aux";
+			settings.AuxDetector = mode == "aux";
+		}
+		else if (arg == "--aux" && hasValue)
+			settings.AuxFile = argv[++i];
+		else if (arg == "--aux-channel" && hasValue)
+		{
+			ok = ParseRange(argv[++i], 0, 1023, "aux-channel", value);
+			settings.AuxChannel = (int)value;
+		}
+		else if (arg == "--precision" && hasValue)
+		{
+			std::string mode = argv[++i];
+			ok = mode == "exact" || mode == "0.01" || mode == "0.1";
+			settings.Precision = mode == "exact" ? MathPrecision::Exact : mode == "0.1" ? MathPrecision::Db01 : MathPrecision::Db001;
+			precisionSet = true;
+		}
+		else if (arg == "--double")
+			settings.DoublePrecision = true;
+		else if (arg == "--chunk" && hasValue)
+		{
+			ok = ParseRange(argv[++i], 256, 1 << 24, "chunk", value);
+			settings.ChunkFrames = (int)value;
+		}
+		else if (arg == "--segments" && hasValue)
+		{
+			ok = ParseRange(argv[++i], 1, 1024, "segments", value);
+			settings.Segments = (int)value;
+		}
+		else if (arg == "--batch" && hasValue)
+			batch.Source = argv[++i];
+		else if (arg == "--out-dir" && hasValue)
+			batch.OutDir = argv[++i];
+		else if (arg == "--summary" && hasValue)
+			batch.SummaryFile = argv[++i];
+		else if (arg == "--jobs" && hasValue)
+		{
+			ok = ParseRange(argv[++i], 1, 1024, "jobs", value);
+			batch.Jobs = (int)value;
+		}
+		else if (arg == "--io-jobs" && hasValue)
+		{
+			ok = ParseRange(argv[++i], 1, 1024, "io-jobs", value);
+			batch.IoJobs = (int)value;
+		}
+		else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0)
+			ok = false;
+		else
+			files.push_back(arg);
+
+		if (!ok || (arg == "--help"))
+		{
+			PrintUsage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	bool batchMode = !batch.Source.empty();
+	if (batchMode ? (!files.empty() || batch.OutDir.empty()) : files.size() != 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (settings.AuxDetector && settings.AuxFile.empty() && settings.AuxChannel < 0)
+	{
+		std::fprintf(stderr, "--detector aux needs --aux or --aux-channel\n");
+		return 1;
+	}
+
+	if (batchMode && settings.Segments > 1)
+	{
+		std::fprintf(stderr, "--segments can't be used with --batch, the batch already runs files in parallel\n");
+		return 1;
+	}
+
+	if (batchMode && settings.AuxDetector && !settings.AuxFile.empty())
+	{
+		std::fprintf(stderr, "--aux can't be used with --batch, use --aux-channel\n");
+		return 1;
+	}
+
+	// like NoiseGateKernelDouble, the double chain defaults to exact conversions, the fast modes compute in float
+	if (settings.DoublePrecision && !precisionSet)
+		settings.Precision = MathPrecision::Exact;
+
+	// the aux signal is only used with --detector aux, like the plugin's Detection parameter
+	if (!settings.AuxDetector)
+	{
+		settings.AuxFile.clear();
+		settings.AuxChannel = -1;
+	}
+
+	Utils::Initialize();
+
+	if (batchMode)
+		return RunBatch(settings, batch);
+
+	IoLimiter io(batch.IoJobs);
+	Scratch scratch;
+	FileStats stats;
+	std::string error;
+	if (!ProcessFile(settings, files[0], files[1], scratch, settings.Segments > 1 ? &io : nullptr, stats, error))
+	{
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	PrintStats(files[1], stats);
+	if (stats.Segments > 1)
+		PrintSegmentStats(stats);
+
+	return 0;
+}
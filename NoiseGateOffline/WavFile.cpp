@@ -0,0 +1,440 @@
+#include <cmath>
+#include <cstring>
+
+#include "WavFile.h"
+
+#ifdef _WIN32
+#define FileSeek _fseeki64
+#define FileTell _ftelli64
+#else
+#define FileSeek fseeko
+#define FileTell ftello
+#endif
+
+namespace NoiseInvader
+{
+	namespace Offline
+	{
+		static const uint16_t FormatPcm = 1;
+		static const uint16_t FormatFloat = 3;
+		static const uint16_t FormatExtensible = 0xFFFE;
+
+		static inline uint16_t ReadU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+		static inline uint32_t ReadU32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+		static inline uint64_t ReadU64(const uint8_t* p) { return (uint64_t)ReadU32(p) | ((uint64_t)ReadU32(p + 4) << 32); }
+
+		static inline void WriteU16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+		static inline void WriteU32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i)); }
+		static inline void WriteU64(uint8_t* p, uint64_t v) { WriteU32(p, (uint32_t)v); WriteU32(p + 4, (uint32_t)(v >> 32)); }
+
+		int WavFormat::BytesPerSample() const
+		{
+			switch (Format)
+			{
+			case SampleFormat::Int16: return 2;
+			case SampleFormat::Int24: return 3;
+			default: return 4;
+			}
+		}
+
+		// ------------------------------------------------------------------------------------
+
+		WavReader::WavReader()
+		{
+			format = { 0, 0, SampleFormat::Int16 };
+			dataOffset = 0;
+			frameCount = 0;
+		}
+
+		bool WavReader::Open(const std::string& path, std::string& error)
+		{
+			if (!file.Open(path))
+			{
+				error = "can't open " + path;
+				return false;
+			}
+
+			auto header = file.Map(0, 12);
+			if (header == nullptr || std::memcmp(header + 8, "WAVE", 4) != 0)
+			{
+				error = path + " is not a WAV file";
+				return false;
+			}
+
+			bool rf64 = std::memcmp(header, "RF64", 4) == 0;
+			if (!rf64 && std::memcmp(header, "RIFF", 4) != 0)
+			{
+				error = path + " is not a WAV file";
+				return false;
+			}
+
+			uint64_t dataSize64 = 0;
+			uint64_t dataSize = 0;
+			bool hasFormat = false;
+			bool hasData = false;
+			uint64_t pos = 12;
+
+			while (pos + 8 <= file.Size() && !hasData)
+			{
+				// a chunk cut off by the end of the file ends the scan, like a missing one
+				auto chunk = file.Map(pos, 8);
+				if (chunk == nullptr)
+					break;
+
+				uint64_t chunkSize = ReadU32(chunk + 4);
+
+				if (std::memcmp(chunk, "ds64", 4) == 0 && chunkSize >= 16)
+				{
+					auto ds64 = file.Map(pos + 8, 16);
+					if (ds64 == nullptr)
+						break;
+
+					dataSize64 = ReadU64(ds64 + 8);
+				}
+				else if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16)
+				{
+					auto fmt = file.Map(pos + 8, (size_t)chunkSize);
+					if (fmt == nullptr)
+						break;
+
+					uint16_t tag = ReadU16(fmt);
+					format.Channels = ReadU16(fmt + 2);
+					format.SampleRate = (int)ReadU32(fmt + 4);
+					int bits = ReadU16(fmt + 14);
+
+					// the first two bytes of the extensible sub format GUID are the plain format tag
+					if (tag == FormatExtensible && chunkSize >= 40)
+						tag = ReadU16(fmt + 24);
+
+					if (tag == FormatPcm && bits == 16)
+						format.Format = SampleFormat::Int16;
+					else if (tag == FormatPcm && bits == 24)
+						format.Format = SampleFormat::Int24;
+					else if (tag == FormatPcm && bits == 32)
+						format.Format = SampleFormat::Int32;
+					else if (tag == FormatFloat && bits == 32)
+						format.Format = SampleFormat::Float32;
+					else
+					{
+						error = path + ": unsupported sample format (tag " + std::to_string(tag) + ", " + std::to_string(bits) + " bit)";
+						return false;
+					}
+
+					hasFormat = true;
+				}
+				else if (std::memcmp(chunk, "data", 4) == 0)
+				{
+					dataOffset = pos + 8;
+					dataSize = (rf64 && chunkSize == 0xFFFFFFFF) ? dataSize64 : chunkSize;
+					hasData = true;
+				}
+
+				pos += 8 + chunkSize + (chunkSize & 1);
+			}
+
+			if (!hasFormat || !hasData || format.Channels <= 0)
+			{
+				error = path + ": missing fmt or data chunk";
+				return false;
+			}
+
+			// tolerate files that were cut short while recording
+			if (dataOffset + dataSize > file.Size())
+				dataSize = file.Size() - dataOffset;
+
+			frameCount = dataSize / format.BlockAlign();
+			return true;
+		}
+
+		void WavReader::Read(uint64_t startFrame, int count, float* const* channels)
+		{
+			int available = startFrame >= frameCount ? 0 : (int)(frameCount - startFrame < (uint64_t)count ? frameCount - startFrame : count);
+			int channelCount = format.Channels;
+
+			int blockAlign = format.BlockAlign();
+			const uint8_t* data = available > 0 ? file.Map(dataOffset + startFrame * blockAlign, (size_t)available * blockAlign) : nullptr;
+
+			// the frames that can't be mapped read as silence, like the ones past the end
+			if (data == nullptr)
+				available = 0;
+
+			if (available > 0)
+			{
+
+				// one pass per channel, each a strided gather with a constant scale
+				for (int c = 0; c < channelCount; c++)
+				{
+					float* out = channels[c];
+					switch (format.Format)
+					{
+					case SampleFormat::Int16:
+					{
+						const uint8_t* p = data + c * 2;
+						for (int i = 0; i < available; i++, p += blockAlign)
+						{
+							int16_t v;
+							std::memcpy(&v, p, 2);
+							out[i] = v * (1.0f / 32768.0f);
+						}
+						break;
+					}
+					case SampleFormat::Int24:
+					{
+						const uint8_t* p = data + c * 3;
+						for (int i = 0; i < available; i++, p += blockAlign)
+						{
+							int32_t v = (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8;
+							out[i] = v * (1.0f / 8388608.0f);
+						}
+						break;
+					}
+					case SampleFormat::Int32:
+					{
+						const uint8_t* p = data + c * 4;
+						for (int i = 0; i < available; i++, p += blockAlign)
+						{
+							int32_t v;
+							std::memcpy(&v, p, 4);
+							out[i] = v * (1.0f / 2147483648.0f);
+						}
+						break;
+					}
+					case SampleFormat::Float32:
+					{
+						const uint8_t* p = data + c * 4;
+						for (int i = 0; i < available; i++, p += blockAlign)
+							std::memcpy(&out[i], p, 4);
+						break;
+					}
+					}
+				}
+			}
+
+			for (int c = 0; c < channelCount; c++)
+				for (int i = available; i < count; i++)
+					channels[c][i] = 0;
+		}
+
+		// ------------------------------------------------------------------------------------
+
+		WavWriter::WavWriter()
+		{
+			file = nullptr;
+			format = { 0, 0, SampleFormat::Int16 };
+			framesWritten = 0;
+			junkOffset = 0;
+			dataSizeOffset = 0;
+		}
+
+		WavWriter::~WavWriter()
+		{
+			Close();
+		}
+
+		bool WavWriter::Open(const std::string& path, const WavFormat& format, std::string& error)
+		{
+			Close();
+			this->format = format;
+			framesWritten = 0;
+
+			file = std::fopen(path.c_str(), "wb");
+			if (file == nullptr)
+			{
+				error = "can't create " + path;
+				return false;
+			}
+
+			// large stdio buffer, the data is written in big chunks anyway
+			std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+			bool isFloat = format.Format == SampleFormat::Float32;
+			bool extensible = format.Channels > 2;
+			int bits = format.BytesPerSample() * 8;
+			uint32_t fmtSize = extensible ? 40 : 16;
+
+			std::vector<uint8_t> header(12 + 8 + 28 + 8 + fmtSize + 8);
+			uint8_t* p = &header[0];
+
+			std::memcpy(p, "RIFF", 4);
+			WriteU32(p + 4, 0); // patched in Close
+			std::memcpy(p + 8, "WAVE", 4);
+			p += 12;
+
+			// placeholder for the ds64 chunk of RF64
+			junkOffset = p - &header[0];
+			std::memcpy(p, "JUNK", 4);
+			WriteU32(p + 4, 28);
+			std::memset(p + 8, 0, 28);
+			p += 8 + 28;
+
+			std::memcpy(p, "fmt ", 4);
+			WriteU32(p + 4, fmtSize);
+			WriteU16(p + 8, extensible ? FormatExtensible : isFloat ? FormatFloat : FormatPcm);
+			WriteU16(p + 10, (uint16_t)format.Channels);
+			WriteU32(p + 12, (uint32_t)format.SampleRate);
+			WriteU32(p + 16, (uint32_t)(format.SampleRate * format.BlockAlign()));
+			WriteU16(p + 20, (uint16_t)format.BlockAlign());
+			WriteU16(p + 22, (uint16_t)bits);
+			if (extensible)
+			{
+				static const uint8_t guidTail[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+				WriteU16(p + 24, 22);
+				WriteU16(p + 26, (uint16_t)bits);
+				WriteU32(p + 28, 0); // no speaker positions
+				WriteU16(p + 32, isFloat ? FormatFloat : FormatPcm);
+				std::memcpy(p + 34, guidTail, 14);
+			}
+			p += 8 + fmtSize;
+
+			std::memcpy(p, "data", 4);
+			WriteU32(p + 4, 0); // patched in Close
+			dataSizeOffset = (p + 4) - &header[0];
+
+			if (std::fwrite(&header[0], 1, header.size(), file) != header.size())
+			{
+				error = "can't write " + path;
+				std::fclose(file);
+				file = nullptr;
+				return false;
+			}
+
+			return true;
+		}
+
+		bool WavWriter::Write(const float* const* channels, int count)
+		{
+			if (file == nullptr)
+				return false;
+
+			Convert(channels, count);
+			if (std::fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size())
+				return false;
+
+			framesWritten += count;
+			return true;
+		}
+
+		bool WavWriter::WriteAt(uint64_t startFrame, const float* const* channels, int count)
+		{
+			std::lock_guard<std::mutex> guard(writeLock);
+			if (file == nullptr)
+				return false;
+
+			Convert(channels, count);
+			int64_t offset = dataSizeOffset + 4 + (int64_t)(startFrame * format.BlockAlign());
+			if (FileSeek(file, offset, SEEK_SET) != 0 || std::fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size())
+				return false;
+
+			if (startFrame + count > framesWritten)
+				framesWritten = startFrame + count;
+
+			return true;
+		}
+
+		void WavWriter::Convert(const float* const* channels, int count)
+		{
+			int blockAlign = format.BlockAlign();
+			buffer.resize((size_t)count * blockAlign);
+
+			for (int c = 0; c < format.Channels; c++)
+			{
+				const float* in = channels[c];
+				switch (format.Format)
+				{
+				case SampleFormat::Int16:
+				{
+					uint8_t* p = &buffer[c * 2];
+					for (int i = 0; i < count; i++, p += blockAlign)
+					{
+						float x = in[i] * 32768.0f;
+						x = x < -32768.0f ? -32768.0f : x > 32767.0f ? 32767.0f : x;
+						int16_t v = (int16_t)std::lrint(x);
+						std::memcpy(p, &v, 2);
+					}
+					break;
+				}
+				case SampleFormat::Int24:
+				{
+					uint8_t* p = &buffer[c * 3];
+					for (int i = 0; i < count; i++, p += blockAlign)
+					{
+						float x = in[i] * 8388608.0f;
+						x = x < -8388608.0f ? -8388608.0f : x > 8388607.0f ? 8388607.0f : x;
+						int32_t v = (int32_t)std::lrint(x);
+						p[0] = (uint8_t)v;
+						p[1] = (uint8_t)(v >> 8);
+						p[2] = (uint8_t)(v >> 16);
+					}
+					break;
+				}
+				case SampleFormat::Int32:
+				{
+					uint8_t* p = &buffer[c * 4];
+					for (int i = 0; i < count; i++, p += blockAlign)
+					{
+						// double, float can't represent the 32 bit limits exactly
+						double x = in[i] * 2147483648.0;
+						x = x < -2147483648.0 ? -2147483648.0 : x > 2147483647.0 ? 2147483647.0 : x;
+						int32_t v = (int32_t)std::lrint(x);
+						std::memcpy(p, &v, 4);
+					}
+					break;
+				}
+				case SampleFormat::Float32:
+				{
+					uint8_t* p = &buffer[c * 4];
+					for (int i = 0; i < count; i++, p += blockAlign)
+						std::memcpy(p, &in[i], 4);
+					break;
+				}
+				}
+			}
+		}
+
+		bool WavWriter::Close()
+		{
+			if (file == nullptr)
+				return true;
+
+			uint64_t dataSize = framesWritten * format.BlockAlign();
+			bool ok = FileSeek(file, 0, SEEK_END) == 0;
+
+			if (dataSize & 1)
+				ok &= std::fputc(0, file) != EOF;
+
+			uint64_t fileSize = (uint64_t)FileTell(file);
+			uint64_t riffSize = fileSize - 8;
+			uint8_t field[8];
+
+			if (riffSize <= 0xFFFFFFFFull)
+			{
+				WriteU32(field, (uint32_t)riffSize);
+				ok &= FileSeek(file, 4, SEEK_SET) == 0 && std::fwrite(field, 1, 4, file) == 4;
+				WriteU32(field, (uint32_t)dataSize);
+				ok &= FileSeek(file, dataSizeOffset, SEEK_SET) == 0 && std::fwrite(field, 1, 4, file) == 4;
+			}
+			else
+			{
+				// RF64: the 32 bit sizes are set to -1 and the real sizes go into the ds64 chunk that replaces JUNK
+				uint8_t ds64[36];
+				std::memcpy(ds64, "ds64", 4);
+				WriteU32(ds64 + 4, 28);
+				WriteU64(ds64 + 8, riffSize);
+				WriteU64(ds64 + 16, dataSize);
+				WriteU64(ds64 + 24, framesWritten);
+				WriteU32(ds64 + 32, 0);
+
+				std::memcpy(field, "RF64", 4);
+				WriteU32(field + 4, 0xFFFFFFFF);
+				ok &= FileSeek(file, 0, SEEK_SET) == 0 && std::fwrite(field, 1, 8, file) == 8;
+				ok &= FileSeek(file, junkOffset, SEEK_SET) == 0 && std::fwrite(ds64, 1, 36, file) == 36;
+				WriteU32(field, 0xFFFFFFFF);
+				ok &= FileSeek(file, dataSizeOffset, SEEK_SET) == 0 && std::fwrite(field, 1, 4, file) == 4;
+			}
+
+			ok &= std::fclose(file) == 0;
+			file = nullptr;
+			return ok;
+		}
+	}
+}
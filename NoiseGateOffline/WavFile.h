@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace NoiseInvader
+{
+	namespace Offline
+	{
+		enum class SampleFormat
+		{
+			Int16,
+			Int24,
+			Int32,
+			Float32
+		};
+
+		struct WavFormat
+		{
+			int Channels;
+			int SampleRate;
+			SampleFormat Format;
+
+			int BytesPerSample() const;
+			int BlockAlign() const { return Channels * BytesPerSample(); }
+		};
+
+		/// <summary>
+		/// Reads RIFF / RF64 WAV files (PCM 16, 24 and 32 bit, 32 bit float, plain or extensible format)
+		/// through a memory mapping, converting to planar float on the fly
+		/// </summary>
+		class WavReader
+		{
+		private:
+			MappedFile file;
+			WavFormat format;
+			uint64_t dataOffset;
+			uint64_t frameCount;
+
+		public:
+			WavReader();
+
+			// Returns false and sets error if the file can't be read or isn't a supported WAV file
+			bool Open(const std::string& path, std::string& error);
+
+			const WavFormat& GetFormat() const { return format; }
+			uint64_t GetFrameCount() const { return frameCount; }
+
+			/// <summary>
+			/// Converts count frames starting at startFrame into channels[c][0...count-1].
+			/// Frames past the end of the file are written as silence
+			/// </summary>
+			void Read(uint64_t startFrame, int count, float* const* channels);
+		};
+
+		/// <summary>
+		/// Streams a WAV file to disk. The header leaves room for a ds64 chunk, so a file that grows beyond 4GB
+		/// is turned into RF64 when it is closed
+		/// </summary>
+		class WavWriter
+		{
+		private:
+			FILE* file;
+			WavFormat format;
+			uint64_t framesWritten;
+			int64_t junkOffset;
+			int64_t dataSizeOffset;
+			std::vector<uint8_t> buffer;
+			std::mutex writeLock;
+
+		public:
+			WavWriter();
+			~WavWriter();
+
+			bool Open(const std::string& path, const WavFormat& format, std::string& error);
+
+			// Converts channels[c][0...count-1] to the file format, clipping to full scale, and writes them
+			bool Write(const float* const* channels, int count);
+
+			/// <summary>
+			/// Writes count frames at startFrame, for filling the file out of order. May be called from several threads.
+			/// Frames that are never written read back as silence. Don't mix with Write
+			/// </summary>
+			bool WriteAt(uint64_t startFrame, const float* const* channels, int count);
+
+			// Patches the chunk sizes, returns false if the file couldn't be finished
+			bool Close();
+
+		private:
+			// Converts channels[c][0...count-1] into buffer
+			void Convert(const float* const* channels, int count);
+		};
+	}
+}
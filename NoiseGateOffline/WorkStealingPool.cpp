@@ -0,0 +1,126 @@
+#include "WorkStealingPool.h"
+
+namespace NoiseInvader
+{
+	namespace Offline
+	{
+		WorkStealingPool::WorkStealingPool(int threadCount)
+		{
+			if (threadCount < 1)
+				threadCount = 1;
+
+			queued = 0;
+			nextWorker = 0;
+			unfinished = 0;
+			stopping = false;
+
+			for (int i = 0; i < threadCount; i++)
+				workers.push_back(std::unique_ptr<Worker>(new Worker()));
+
+			for (int i = 0; i < threadCount; i++)
+				threads.push_back(std::thread(&WorkStealingPool::Run, this, i));
+		}
+
+		WorkStealingPool::~WorkStealingPool()
+		{
+			{
+				std::lock_guard<std::mutex> guard(stateLock);
+				stopping = true;
+			}
+
+			wake.notify_all();
+			for (auto& thread : threads)
+				thread.join();
+		}
+
+		void WorkStealingPool::Submit(Task task)
+		{
+			{
+				std::lock_guard<std::mutex> guard(stateLock);
+				unfinished++;
+			}
+
+			auto& worker = *workers[nextWorker++ % workers.size()];
+			{
+				std::lock_guard<std::mutex> guard(worker.Lock);
+				worker.Tasks.push_back(std::move(task));
+			}
+
+			{
+				// under stateLock, so a worker can't miss the wakeup between checking queued and waiting
+				std::lock_guard<std::mutex> guard(stateLock);
+				queued++;
+			}
+
+			wake.notify_one();
+		}
+
+		void WorkStealingPool::Wait()
+		{
+			std::unique_lock<std::mutex> guard(stateLock);
+			done.wait(guard, [this] { return unfinished == 0; });
+		}
+
+		bool WorkStealingPool::TryTake(int index, Task& task)
+		{
+			int count = (int)workers.size();
+
+			// own deque first, from the front
+			{
+				auto& own = *workers[index];
+				std::lock_guard<std::mutex> guard(own.Lock);
+				if (!own.Tasks.empty())
+				{
+					task = std::move(own.Tasks.front());
+					own.Tasks.pop_front();
+					queued--;
+					return true;
+				}
+			}
+
+			// then steal from the back of the others, starting with the next worker
+			for (int i = 1; i < count; i++)
+			{
+				auto& victim = *workers[(index + i) % count];
+				std::lock_guard<std::mutex> guard(victim.Lock);
+				if (!victim.Tasks.empty())
+				{
+					task = std::move(victim.Tasks.back());
+					victim.Tasks.pop_back();
+					queued--;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		void WorkStealingPool::Run(int index)
+		{
+			while (true)
+			{
+				Task task;
+				if (TryTake(index, task))
+				{
+					task(index);
+
+					bool finished;
+					{
+						std::lock_guard<std::mutex> guard(stateLock);
+						finished = --unfinished == 0;
+					}
+
+					if (finished)
+						done.notify_all();
+
+					continue;
+				}
+
+				std::unique_lock<std::mutex> guard(stateLock);
+				wake.wait(guard, [this] { return stopping || queued > 0; });
+				if (stopping && queued == 0)
+					return;
+			}
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NoiseInvader
+{
+	namespace Offline
+	{
+		/// <summary>
+		/// Thread pool with one task deque per worker. Submit deals tasks out round robin; a worker takes tasks from
+		/// the front of its own deque and, once that is empty, steals from the back of the others. With a batch
+		/// sorted longest first, every worker starts on a long file and the short ones at the end balance the load.
+		/// Tasks get the index of the worker running them, for per-thread scratch state
+		/// </summary>
+		class WorkStealingPool
+		{
+		public:
+			typedef std::function<void(int worker)> Task;
+
+		private:
+			struct Worker
+			{
+				std::mutex Lock;
+				std::deque<Task> Tasks;
+			};
+
+			std::vector<std::unique_ptr<Worker>> workers;
+			std::vector<std::thread> threads;
+			std::atomic<int> queued;
+			std::atomic<unsigned int> nextWorker;
+
+			std::mutex stateLock;
+			std::condition_variable wake;
+			std::condition_variable done;
+			int unfinished;
+			bool stopping;
+
+		public:
+			explicit WorkStealingPool(int threadCount);
+			~WorkStealingPool();
+
+			int GetThreadCount() const { return (int)workers.size(); }
+
+			void Submit(Task task);
+
+			// Blocks until every submitted task has finished
+			void Wait();
+
+		private:
+			void Run(int index);
+			bool TryTake(int index, Task& task);
+		};
+	}
+}
@@ -0,0 +1,489 @@
+#pragma once
+
+#include <cmath>
+
+#include "AudioLib/MathDefs.h"
+#include "AudioLib/Utils.h"
+
+// ------------------------------------------------------------------------------------
+// FROZEN REFERENCE - DO NOT OPTIMIZE
+//
+// This is a verbatim copy of the original scalar gain chain (NoiseGateKernel, EnvelopeFollower,
+// Sma, Ema, EmaLatch, Hp1, Biquad lowpass, Expander, SlewLimiter), including its mix of float
+// and double arithmetic. Every optimized engine is compared against it, so it must never change.
+// The only deviations from the original are the zero-initialized state, the -150dB floor on the
+// expander input (the original produced NaN after ~1s of digital silence) and the saturating
+// trigger counter, all of which the production kernel has as well.
+// ------------------------------------------------------------------------------------
+
+namespace NoiseInvader
+{
+	namespace Reference
+	{
+		inline double DB2gain(double input)
+		{
+			return std::pow(10, input / 20);
+		}
+
+		inline float Gain2DB(float input)
+		{
+			return 20.0f * std::log10(input);
+		}
+
+		class Hp1
+		{
+		private:
+			float z1_state = 0.0f;
+			float g2 = 0.0f;
+
+		public:
+			inline float Process(float x)
+			{
+				float v = (x - z1_state) * g2;
+				float y = v + z1_state;
+				z1_state = y + v;
+				return x - y;
+			}
+
+			inline void SetFc(float fcRel)
+			{
+				float g = (float)(fcRel * M_PI);
+				g2 = g / (1 + g);
+			}
+		};
+
+		class BiquadLowpass
+		{
+		private:
+			float a0, a1, a2, b0, b1, b2;
+			float x1 = 0, x2 = 0, y = 0, y1 = 0, y2 = 0;
+
+		public:
+			void Update(float frequency, float q, int samplerate)
+			{
+				float omega = (float)(2 * M_PI * frequency / samplerate);
+				float sinOmega = AudioLib::Utils::FastSin(omega);
+				float cosOmega = AudioLib::Utils::FastCos(omega);
+				float alpha = sinOmega / (2 * q);
+
+				b0 = (1 - cosOmega) / 2;
+				b1 = 1 - cosOmega;
+				b2 = (1 - cosOmega) / 2;
+				a0 = 1 + alpha;
+				a1 = -2 * cosOmega;
+				a2 = 1 - alpha;
+
+				float g = 1 / a0;
+
+				b0 = b0 * g;
+				b1 = b1 * g;
+				b2 = b2 * g;
+				a1 = a1 * g;
+				a2 = a2 * g;
+			}
+
+			inline float Process(float x)
+			{
+				y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+				x2 = x1;
+				y2 = y1;
+				x1 = x;
+				y1 = y;
+				return y;
+			}
+		};
+
+		class Sma
+		{
+		private:
+			double* queue;
+			int sampleCount;
+			int head;
+			double sum;
+			double dbDecayPerSample;
+
+		public:
+			Sma(int sampleCount)
+			{
+				this->sampleCount = sampleCount;
+				this->queue = new double[sampleCount];
+				for (int i = 0; i < sampleCount; i++)
+					queue[i] = 0.0;
+
+				head = 0;
+				sum = 0.0;
+				dbDecayPerSample = 0.0;
+			}
+
+			~Sma()
+			{
+				delete[] queue;
+			}
+
+			double GetDbDecayPerSample()
+			{
+				return dbDecayPerSample;
+			}
+
+			double Update(double sample)
+			{
+				auto takeAway = queue[head];
+				queue[head] = sample;
+				head++;
+				if (head >= sampleCount)
+					head = 0;
+
+				sum -= takeAway;
+				sum += sample;
+
+				auto sampleDb = Gain2DB(sample);
+				auto takeAwayDb = Gain2DB(takeAway);
+
+				if (sampleDb < -150)
+					sampleDb = -150;
+				if (takeAwayDb < -150)
+					takeAwayDb = -150;
+
+				dbDecayPerSample = (sampleDb - takeAwayDb) / sampleCount;
+
+				return sum / sampleCount;
+			}
+		};
+
+		class Ema
+		{
+		private:
+			double alpha;
+			double value = 0.0;
+
+		public:
+			Ema(double alpha) : alpha(alpha) { }
+
+			double Update(double sample)
+			{
+				value = sample * alpha + value * (1 - alpha);
+				return value;
+			}
+		};
+
+		class EmaLatch
+		{
+		private:
+			double alpha;
+			double latch;
+			double value = 0.0;
+			double currentValue = 0.0;
+
+		public:
+			EmaLatch(double alpha, double latch) : alpha(alpha), latch(latch) { }
+
+			double Update(bool input)
+			{
+				auto sample = input ? 1.0 : -1.0;
+				value = sample * alpha + value * (1 - alpha);
+
+				if (value > latch)
+					currentValue = 1.0;
+				if (value < -latch)
+					currentValue = -1.0;
+
+				return currentValue;
+			}
+		};
+
+		class EnvelopeFollower
+		{
+		private:
+			double Fs;
+			Hp1 hpFilter;
+			BiquadLowpass inputFilter;
+			Sma sma;
+			Ema ema;
+			EmaLatch movementLatch;
+
+			int triggerCounterTimeoutSamples;
+			double slowDecay;
+			double fastDecay;
+			double holdAlpha;
+
+			double hold = 0.0;
+			int lastTriggerCounter = 0;
+			double h1 = 0.0, h2 = 0.0, h3 = 0.0, h4 = 0.0;
+			double holdFiltered = 0.0;
+
+		public:
+			EnvelopeFollower(double fs, double releaseMs)
+				: Fs(fs)
+				, sma((int)(fs * 0.01))
+				, ema(AudioLib::Utils::ComputeLpAlpha(200.0, 1.0 / fs))
+				, movementLatch(0.005, 0.2)
+			{
+				double ts = 1.0 / fs;
+				hpFilter.SetFc(100.0 / (fs * 0.5));
+				inputFilter.Update(2000.0f, 1.0f, (int)fs);
+
+				double slowDbDecayPerSample = -60 / (3000 / 1000.0 * fs);
+				slowDecay = DB2gain(slowDbDecayPerSample);
+				SetRelease(releaseMs);
+
+				triggerCounterTimeoutSamples = (int)(fs * 0.01);
+				holdAlpha = AudioLib::Utils::ComputeLpAlpha(200.0, ts);
+			}
+
+			void SetRelease(double releaseMs)
+			{
+				double dbDecayPerSample = -60 / (releaseMs / 1000.0 * Fs);
+				fastDecay = DB2gain(dbDecayPerSample);
+			}
+
+			double GetOutput()
+			{
+				return holdFiltered;
+			}
+
+			void ProcessEnvelope(double val)
+			{
+				double combinedFiltered;
+				double decay;
+
+				val = std::abs(val);
+				val = hpFilter.Process(val);
+				auto lpValue = inputFilter.Process(val);
+				lpValue = std::abs(lpValue);
+
+				auto mainInput = lpValue;
+				auto emaValue = ema.Update(mainInput);
+				auto smaValue = sma.Update(mainInput);
+				auto movementValue = movementLatch.Update(sma.GetDbDecayPerSample() > 0);
+
+				if (movementValue > 0)
+					combinedFiltered = emaValue > smaValue ? emaValue : smaValue;
+				else
+					combinedFiltered = emaValue < smaValue ? emaValue : smaValue;
+
+				if (combinedFiltered > hold)
+				{
+					hold = combinedFiltered;
+					lastTriggerCounter = 0;
+				}
+
+				if (lastTriggerCounter > triggerCounterTimeoutSamples)
+					decay = fastDecay;
+				else
+					decay = DB2gain(sma.GetDbDecayPerSample() * 1.2);
+
+				if (decay > slowDecay)
+					decay = slowDecay;
+				if (decay < fastDecay)
+					decay = fastDecay;
+
+				hold = hold * decay;
+
+				h1 = holdAlpha * hold + (1 - holdAlpha) * h1;
+				h2 = holdAlpha * h1 + (1 - holdAlpha) * h2;
+				h3 = holdAlpha * h2 + (1 - holdAlpha) * h3;
+				h4 = holdAlpha * h3 + (1 - holdAlpha) * h4;
+
+				holdFiltered = h4;
+				if (lastTriggerCounter <= triggerCounterTimeoutSamples)
+					lastTriggerCounter++;
+			}
+		};
+
+		class Expander
+		{
+		private:
+			double prevInDb = -150.0;
+			double outputDb = -150.0;
+			double gainDb = 0.0;
+			double reductionDb;
+			double upperSlope;
+			double lowerSlope;
+			double thresholdDb;
+
+		public:
+			void Update(double thresholdDb, double reductionDb, double slope)
+			{
+				this->thresholdDb = thresholdDb;
+				this->reductionDb = reductionDb;
+				upperSlope = slope;
+				lowerSlope = slope * 2;
+			}
+
+			double GetOutput()
+			{
+				return gainDb;
+			}
+
+			void Expand(double dbVal)
+			{
+				if (std::isnan(outputDb) || std::isinf(outputDb))
+					outputDb = -150;
+				if (!(dbVal > -150))
+					dbVal = -150;
+
+				auto upperDb = Compress(dbVal, thresholdDb, upperSlope, 4, true);
+				auto lowerDb = Compress(dbVal, thresholdDb + 4, lowerSlope, 4, true);
+
+				auto dbChange = dbVal - prevInDb;
+				auto desiredDb = outputDb + dbChange;
+
+				if (desiredDb < lowerDb)
+					desiredDb = lowerDb;
+				else if (desiredDb > upperDb)
+					desiredDb = upperDb;
+
+				outputDb = desiredDb;
+				prevInDb = dbVal;
+
+				auto gainDiff = outputDb - dbVal;
+				if (gainDiff < reductionDb)
+					gainDiff = reductionDb;
+
+				gainDb = gainDiff;
+			}
+
+		private:
+			static double Compress(double x, double threshold, double ratio, double knee, bool expand)
+			{
+				double output;
+				auto kneeLow = threshold - knee;
+				auto kneeHigh = threshold + knee;
+
+				if (x <= kneeLow)
+				{
+					output = x;
+				}
+				else if (x >= kneeHigh)
+				{
+					auto diff = x - threshold;
+					output = threshold + diff / ratio;
+				}
+				else
+				{
+					auto positionOnLine = (x - kneeLow) / (kneeHigh - kneeLow);
+					auto kDiff = knee * positionOnLine;
+					auto xa = kneeLow + kDiff;
+					auto ya = xa;
+					auto yb = threshold + kDiff / ratio;
+					auto slope = (yb - ya) / (knee);
+					output = xa + slope * positionOnLine * knee;
+				}
+
+				if (expand)
+				{
+					auto modifiedThrehold = threshold * ratio;
+					auto yOffset = modifiedThrehold - threshold;
+					output = output * ratio - yOffset;
+				}
+
+				return output;
+			}
+		};
+
+		class SlewLimiter
+		{
+		private:
+			double fs;
+			double slewUp = 1;
+			double slewDown = 1;
+			double output = 0;
+
+		public:
+			SlewLimiter(double fs) : fs(fs) { }
+
+			void UpdateDb60(double slewUpMillis, double slewDownMillis)
+			{
+				auto upSamples = slewUpMillis / 1000.0 * fs;
+				auto downSamples = slewDownMillis / 1000.0 * fs;
+				slewUp = 60.0 / upSamples;
+				slewDown = 60.0 / downSamples;
+			}
+
+			double Process(double value)
+			{
+				if (value > output)
+				{
+					if (value > output + slewUp)
+						output = output + slewUp;
+					else
+						output = value;
+				}
+				else
+				{
+					if (value < output - slewDown)
+						output = output - slewDown;
+					else
+						output = value;
+				}
+
+				return output;
+			}
+		};
+
+		class ReferenceKernel
+		{
+		private:
+			EnvelopeFollower envelopeFollower;
+			Expander expander;
+			SlewLimiter slewLimiter;
+
+		public:
+			float DetectorGain;
+			double ReductionDb;
+			double ThresholdDb;
+			double Slope;
+			double ReleaseMs;
+
+			ReferenceKernel(int fs)
+				: envelopeFollower(fs, 100)
+				, slewLimiter(fs)
+			{
+				DetectorGain = 1.0f;
+				ReductionDb = -150;
+				ThresholdDb = -20;
+				Slope = 3;
+				ReleaseMs = 100;
+				UpdateAll();
+			}
+
+			void UpdateAll()
+			{
+				expander.Update(ThresholdDb, ReductionDb, Slope);
+				envelopeFollower.SetRelease(ReleaseMs);
+				slewLimiter.UpdateDb60(2.0, ReleaseMs);
+			}
+
+			void Process(
+				const float* inputL,
+				const float* inputR,
+				const float* detectorInput,
+				float* outputL,
+				float* outputR,
+				int len,
+				double* envelope,
+				double* expanderDb,
+				double* slewDb)
+			{
+				for (int i = 0; i < len; i++)
+				{
+					auto x = detectorInput[i] * DetectorGain;
+					envelopeFollower.ProcessEnvelope(x);
+					auto env = envelopeFollower.GetOutput();
+
+					expander.Expand(Gain2DB(env));
+					double gainDb = expander.GetOutput();
+					envelope[i] = env;
+					expanderDb[i] = gainDb;
+
+					gainDb = slewLimiter.Process(gainDb);
+					slewDb[i] = gainDb;
+
+					auto gain = DB2gain(gainDb);
+					outputL[i] = inputL[i] * gain;
+					outputR[i] = inputR[i] * gain;
+				}
+			}
+		};
+	}
+}
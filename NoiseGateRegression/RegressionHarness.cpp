@@ -0,0 +1,1110 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+
+#include "AudioLib/Biquad.h"
+#include "AudioLib/BiquadBank.h"
+#include "AudioLib/Butterworth.h"
+#include "AudioLib/Simd.h"
+#include "AudioLib/SlidingExtreme.h"
+#include "AudioLib/Sos.h"
+#include "AudioLib/Transfer.h"
+#include "AudioLib/VectorMath.h"
+#include "EnvelopeFollower.h"
+#include "FileProcessor.h"
+#include "GainRamp.h"
+#include "PeakDetector.h"
+#include "ReferenceKernel.h"
+#include "SlewLimiter.h"
+#include "RegressionHarness.h"
+
+namespace NoiseInvader
+{
+	namespace Regression
+	{
+		/// <summary>
+		/// Runs a bank over the interleaved input in blocks of varying size, handing its state over to a second bank
+		/// halfway, and counts the samples that differ from the scalar filter of each lane
+		/// </summary>
+		template<typename TBank, int Lanes, typename TScalar>
+		static int CountBankMismatches(const std::vector<float>& input, const AudioLib::SosCoefficients<float>* coefficients, TScalar* scalars)
+		{
+			int len = (int)input.size() / Lanes;
+			std::vector<float> output(input.size());
+			auto first = std::unique_ptr<TBank>(new TBank());
+			auto second = std::unique_ptr<TBank>(new TBank());
+			for (int l = 0; l < Lanes; l++)
+			{
+				first->SetCoefficients(l, coefficients[l]);
+				second->SetCoefficients(l, coefficients[l]);
+			}
+
+			typename TBank::State state;
+			int pos = 0, block = 1;
+			while (pos < len)
+			{
+				int count = std::min(block, len - pos);
+				auto bank = pos < len / 2 ? first.get() : second.get();
+				bank->Process(&input[pos * Lanes], &output[pos * Lanes], count);
+				pos += count;
+				block = block * 7 % 1031;
+
+				if (bank == first.get() && pos >= len / 2)
+				{
+					first->GetState(state);
+					second->SetState(state);
+				}
+			}
+
+			int mismatches = 0;
+			for (int l = 0; l < Lanes; l++)
+			{
+				for (int i = 0; i < len; i++)
+					mismatches += output[i * Lanes + l] != scalars[l].Process(input[i * Lanes + l]);
+			}
+
+			return mismatches;
+		}
+
+		void EngineTrace::Resize(int len)
+		{
+			OutputL.assign(len, 0.0f);
+			OutputR.assign(len, 0.0f);
+			Envelope.assign(len, 0.0);
+			ExpanderDb.assign(len, 0.0);
+			SlewDb.assign(len, 0.0);
+		}
+
+		RegressionHarness::RegressionHarness(double fs)
+		{
+			Signals = TestSignals::All(fs);
+			Verbose = false;
+
+			// plugin defaults, a hard fast gate and a gentle slow expander
+			Settings.push_back({ "Default", 1.0f, -50.0, -8.5, 5.5, 40.0 });
+			Settings.push_back({ "HardGate", 2.0f, -100.0, -40.0, 1.5, 20.0 });
+			Settings.push_back({ "Gentle", 0.5f, -20.0, -10.0, 10.0, 500.0 });
+		}
+
+		void RegressionHarness::RunReference(const TestSignal& signal, const GateSettings& settings, EngineTrace& trace)
+		{
+			Reference::ReferenceKernel kernel((int)signal.Fs);
+			kernel.DetectorGain = settings.DetectorGain;
+			kernel.ReductionDb = settings.ReductionDb;
+			kernel.ThresholdDb = settings.ThresholdDb;
+			kernel.Slope = settings.Slope;
+			kernel.ReleaseMs = settings.ReleaseMs;
+			kernel.UpdateAll();
+
+			trace.Resize(signal.Length());
+			kernel.Process(
+				&signal.Left[0], &signal.Right[0], &signal.Detector[0],
+				&trace.OutputL[0], &trace.OutputR[0], signal.Length(),
+				&trace.Envelope[0], &trace.ExpanderDb[0], &trace.SlewDb[0]);
+		}
+
+		static inline double EnvelopeDb(double x)
+		{
+			return x > 1e-15 ? std::max(20 * std::log10(x), -150.0) : -150.0;
+		}
+
+		StageErrors RegressionHarness::Compare(const EngineTrace& expected, const EngineTrace& actual, int window)
+		{
+			StageErrors e = { 0, 0, 0, 0 };
+			size_t len = std::min(expected.OutputL.size(), actual.OutputL.size());
+
+			// a NaN anywhere is an infinite error
+			auto diff = [](double a, double b) { auto d = std::abs(a - b); return d == d ? d : INFINITY; };
+
+			// Smallest error of actual sample i against the expected samples up to window away. Only searched when the
+			// error at i itself would raise the maximum, which keeps the window cheap where the traces agree
+			auto aligned = [&](double worst, size_t i, double direct, const std::function<double(size_t)>& error)
+			{
+				if (direct <= worst || window == 0)
+					return direct;
+
+				size_t from = i > (size_t)window ? i - window : 0;
+				size_t to = std::min(len - 1, i + window);
+				for (size_t k = from; k <= to && direct > worst; k++)
+					direct = std::min(direct, error(k));
+
+				return direct;
+			};
+
+			for (size_t i = 0; i < len; i++)
+			{
+				double envelope = EnvelopeDb(actual.Envelope[i]);
+				double expander = actual.ExpanderDb[i];
+				double slew = actual.SlewDb[i];
+
+				e.EnvelopeDb = std::max(e.EnvelopeDb, aligned(e.EnvelopeDb, i, diff(EnvelopeDb(expected.Envelope[i]), envelope),
+					[&](size_t k) { return diff(EnvelopeDb(expected.Envelope[k]), envelope); }));
+				e.ExpanderDb = std::max(e.ExpanderDb, aligned(e.ExpanderDb, i, diff(expected.ExpanderDb[i], expander),
+					[&](size_t k) { return diff(expected.ExpanderDb[k], expander); }));
+				e.SlewDb = std::max(e.SlewDb, aligned(e.SlewDb, i, diff(expected.SlewDb[i], slew),
+					[&](size_t k) { return diff(expected.SlewDb[k], slew); }));
+
+				// the audio itself isn't shifted, only the gain applied to it: the expected output with the gain of sample k
+				for (auto channel : { &EngineTrace::OutputL, &EngineTrace::OutputR })
+				{
+					double output = (actual.*channel)[i];
+					double expectedOutput = (expected.*channel)[i];
+					e.Output = std::max(e.Output, aligned(e.Output, i, diff(expectedOutput, output),
+						[&](size_t k) { return diff(expectedOutput * std::pow(10.0, (expected.SlewDb[k] - expected.SlewDb[i]) / 20), output); }));
+				}
+			}
+
+			if (expected.OutputL.size() != actual.OutputL.size())
+				e.Output = INFINITY;
+
+			return e;
+		}
+
+		template<typename T>
+		static bool SameBits(const std::vector<T>& a, const std::vector<T>& b)
+		{
+			return a.size() == b.size() && (a.empty() || std::memcmp(&a[0], &b[0], a.size() * sizeof(T)) == 0);
+		}
+
+		bool RegressionHarness::IsBitExact(const EngineTrace& expected, const EngineTrace& actual)
+		{
+			return SameBits(expected.OutputL, actual.OutputL)
+				&& SameBits(expected.OutputR, actual.OutputR)
+				&& SameBits(expected.Envelope, actual.Envelope)
+				&& SameBits(expected.ExpanderDb, actual.ExpanderDb)
+				&& SameBits(expected.SlewDb, actual.SlewDb);
+		}
+
+		bool RegressionHarness::Report(
+			const std::string& name,
+			const TestSignal& signal,
+			const GateSettings& settings,
+			const StageErrors& e,
+			const Tolerances& t)
+		{
+			bool pass = e.EnvelopeDb <= t.EnvelopeDb
+				&& e.ExpanderDb <= t.ExpanderDb
+				&& e.SlewDb <= t.SlewDb
+				&& e.Output <= t.Output;
+
+			if (Verbose || !pass)
+			{
+				std::printf("  %-4s %-24s %-12s %-9s fs=%-7.0f env %.3g dB, expander %.3g dB, slew %.3g dB, output %.3g\n",
+					pass ? "ok" : "FAIL", name.c_str(), signal.Name.c_str(), settings.Name.c_str(), signal.Fs,
+					e.EnvelopeDb, e.ExpanderDb, e.SlewDb, e.Output);
+			}
+
+			return pass;
+		}
+
+		bool RegressionHarness::CheckAgainstReference(const std::string& name, Engine candidate, const Tolerances& tolerances,
+			const SignalTolerances& signalTolerances)
+		{
+			return CheckAgainst(name, "reference", RunReference, candidate, tolerances, 0, signalTolerances);
+		}
+
+		bool RegressionHarness::CheckAgainst(const std::string& name, const std::string& expectedName, Engine expected, Engine actual, const Tolerances& tolerances,
+			double timingMs, const SignalTolerances& signalTolerances)
+		{
+			bool pass = true;
+			StageErrors worst = { 0, 0, 0, 0 };
+			EngineTrace a, b;
+
+			for (auto& signal : Signals)
+			{
+				for (auto& settings : Settings)
+				{
+					expected(signal, settings, a);
+					actual(signal, settings, b);
+					auto e = Compare(a, b, (int)(timingMs / 1000 * signal.Fs));
+					auto own = signalTolerances.find(signal.Name);
+					pass &= Report(name, signal, settings, e, own != signalTolerances.end() ? own->second : tolerances);
+
+					worst.EnvelopeDb = std::max(worst.EnvelopeDb, e.EnvelopeDb);
+					worst.ExpanderDb = std::max(worst.ExpanderDb, e.ExpanderDb);
+					worst.SlewDb = std::max(worst.SlewDb, e.SlewDb);
+					worst.Output = std::max(worst.Output, e.Output);
+				}
+			}
+
+			std::printf("%-4s %-24s vs %s: max env %.3g dB, expander %.3g dB, slew %.3g dB, output %.3g\n",
+				pass ? "PASS" : "FAIL", name.c_str(), expectedName.c_str(), worst.EnvelopeDb, worst.ExpanderDb, worst.SlewDb, worst.Output);
+
+			return pass;
+		}
+
+		bool RegressionHarness::CheckBitExact(const std::string& name, Engine expected, Engine actual)
+		{
+			bool pass = true;
+			EngineTrace a, b;
+
+			for (auto& signal : Signals)
+			{
+				for (auto& settings : Settings)
+				{
+					expected(signal, settings, a);
+					actual(signal, settings, b);
+					bool exact = IsBitExact(a, b);
+					pass &= exact;
+
+					if (Verbose || !exact)
+					{
+						std::printf("  %-4s %-24s %-12s %-9s fs=%-7.0f bit-exact\n",
+							exact ? "ok" : "FAIL", name.c_str(), signal.Name.c_str(), settings.Name.c_str(), signal.Fs);
+					}
+				}
+			}
+
+			std::printf("%-4s %-24s bit-exact\n", pass ? "PASS" : "FAIL", name.c_str());
+			return pass;
+		}
+
+		bool RegressionHarness::CheckSlewRates(const std::string& name, Engine engine, double attackMs)
+		{
+			// the rates are compared on rounded dB values, allow a few ulps of a float around -150dB
+			const double slack = 1e-4;
+
+			bool pass = true;
+			double worstRise = 0;
+			double worstFall = 0;
+			EngineTrace trace;
+
+			for (auto& signal : Signals)
+			{
+				for (auto& settings : Settings)
+				{
+					engine(signal, settings, trace);
+					double maxRise = 60.0 / (attackMs / 1000 * signal.Fs);
+					double maxFall = 60.0 / (settings.ReleaseMs / 1000 * signal.Fs);
+
+					// the largest step of each direction relative to its limit
+					double rise = 0;
+					double fall = 0;
+					for (size_t i = 1; i < trace.SlewDb.size(); i++)
+					{
+						double step = trace.SlewDb[i] - trace.SlewDb[i - 1];
+						rise = std::max(rise, (step - slack) / maxRise);
+						fall = std::max(fall, (-step - slack) / maxFall);
+					}
+
+					bool ok = rise <= 1 && fall <= 1;
+					pass &= ok;
+					worstRise = std::max(worstRise, rise);
+					worstFall = std::max(worstFall, fall);
+
+					if (Verbose || !ok)
+					{
+						std::printf("  %-4s %-24s %-12s %-9s fs=%-7.0f rise %.4g, fall %.4g of the limit\n",
+							ok ? "ok" : "FAIL", name.c_str(), signal.Name.c_str(), settings.Name.c_str(), signal.Fs, rise, fall);
+					}
+				}
+			}
+
+			std::printf("%-4s %-24s slew rates: max rise %.4g, fall %.4g of the limit\n", pass ? "PASS" : "FAIL", name.c_str(), worstRise, worstFall);
+			return pass;
+		}
+
+		bool RegressionHarness::CheckVectorMath()
+		{
+			using AudioLib::MathPrecision;
+			using AudioLib::VectorMath;
+
+			// gains from -160dB to +20dB, and dB values covering the whole range the kernel uses.
+			// Odd length, so the scalar tail is exercised as well
+			const int len = 100001;
+			std::vector<float> gains(len), dbs(len), out(len);
+			std::vector<double> gainsD(len), dbsD(len), outD(len);
+			for (int i = 0; i < len; i++)
+			{
+				dbs[i] = (float)(-160.0 + 180.0 * i / (len - 1));
+				gains[i] = (float)std::pow(10.0, dbs[i] / 20.0);
+				dbsD[i] = dbs[i];
+				gainsD[i] = gains[i];
+			}
+
+			struct { MathPrecision Precision; const char* Name; double LogDb; double ExpDb; } modes[] =
+			{
+				{ MathPrecision::Db001, "0.01dB", 0.0052, 0.0014 },
+				{ MathPrecision::Db01, "0.1dB", 0.035, 0.023 },
+			};
+
+			// integers, halves and large values for Floor, around the 2^23 limit of the SSE2 version and the int range
+			std::vector<float> mixed(len);
+			std::vector<int> ints(len);
+			for (int i = 0; i < len; i++)
+			{
+				float big[] = { 8388607.5f, 8388608.0f, -8388609.0f, 3e9f, -3e9f, 1e-30f, -1e-30f, -0.0f };
+				mixed[i] = i % 13 == 0 ? big[(i / 13) % 8] : (float)((i % 2001) - 1000) / 8.0f * (i % 3 == 0 ? -1 : 1);
+				ints[i] = (i * 2654435761u) >> 1;
+			}
+
+			bool pass = true;
+			AudioLib::SimdLevel original = AudioLib::Simd::GetLevel();
+			for (int l = 0; l <= (int)AudioLib::Simd::GetSupportedLevel(); l++)
+			{
+				AudioLib::SimdLevel level = AudioLib::Simd::SetLevel((AudioLib::SimdLevel)l);
+				const char* levelName = AudioLib::Simd::GetName(level);
+
+				for (auto& mode : modes)
+				{
+					double logErr = 0, expErr = 0;
+
+					VectorMath::Gain2Db(&gains[0], &out[0], len, mode.Precision);
+					for (int i = 0; i < len; i++)
+						logErr = std::max(logErr, std::abs(out[i] - 20 * std::log10((double)gains[i])));
+
+					VectorMath::Gain2Db(&gainsD[0], &out[0], len, mode.Precision);
+					for (int i = 0; i < len; i++)
+						logErr = std::max(logErr, std::abs(out[i] - 20 * std::log10(gainsD[i])));
+
+					VectorMath::Db2Gain(&dbs[0], &out[0], len, mode.Precision);
+					for (int i = 0; i < len; i++)
+						expErr = std::max(expErr, std::abs(20 * std::log10((double)out[i]) - dbs[i]));
+
+					VectorMath::Db2Gain(&dbsD[0], &outD[0], len, mode.Precision);
+					for (int i = 0; i < len; i++)
+						expErr = std::max(expErr, std::abs(20 * std::log10(outD[i]) - dbsD[i]));
+
+					bool ok = logErr <= mode.LogDb && expErr <= mode.ExpDb;
+					pass &= ok;
+					std::printf("%-4s VectorMath %-7s %-6s Gain2Db max error %.3g dB (limit %g), Db2Gain max error %.3g dB (limit %g)\n",
+						ok ? "PASS" : "FAIL", levelName, mode.Name, logErr, mode.LogDb, expErr, mode.ExpDb);
+				}
+
+				// every length up to a few AVX-512 registers, starting off the alignment as well
+				int mismatches = 0;
+				for (int offset = 0; offset < 2; offset++)
+				{
+					for (int n = 0; n <= 67; n++)
+					{
+						const float* x = &mixed[offset + n * 7];
+						const int* xi = &ints[offset + n * 7];
+						const double* xd = &gainsD[offset + n * 7];
+						float minOut[67], maxOut[67], floorOut[67], convertOut[67];
+						std::memcpy(minOut, x, n * sizeof(float));
+						std::memcpy(maxOut, x, n * sizeof(float));
+						std::memcpy(floorOut, x, n * sizeof(float));
+						AudioLib::Simd::Min(minOut, 3.0f, n);
+						AudioLib::Simd::Max(maxOut, -3.0f, n);
+						AudioLib::Simd::Floor(floorOut, n);
+						AudioLib::Simd::ConvertToFloats(xi, convertOut, n);
+
+						float maxAbs = 0;
+						double maxAbsD = 0;
+						for (int i = 0; i < n; i++)
+						{
+							mismatches += minOut[i] != std::min(x[i], 3.0f);
+							mismatches += maxOut[i] != std::max(x[i], -3.0f);
+							mismatches += floorOut[i] != std::floor(x[i]);
+							mismatches += convertOut[i] != (float)xi[i];
+							maxAbs = std::max(maxAbs, std::abs(x[i]));
+							maxAbsD = std::max(maxAbsD, std::abs(xd[i]));
+						}
+
+						mismatches += VectorMath::MaxAbs(x, n) != maxAbs;
+						mismatches += VectorMath::MaxAbs(xd, n) != maxAbsD;
+					}
+				}
+
+				bool ok = mismatches == 0;
+				pass &= ok;
+				std::printf("%-4s Simd %-7s Min, Max, Floor, ConvertToFloats, MaxAbs %d mismatches on lengths 0 to 67\n",
+					ok ? "PASS" : "FAIL", levelName, mismatches);
+			}
+
+			AudioLib::Simd::SetLevel(original);
+			return pass;
+		}
+
+		bool RegressionHarness::CheckSlidingExtreme()
+		{
+			// noise with runs of equal values and slow ramps, so ties and long monotonic stretches both occur
+			const int len = 50000;
+			std::vector<float> input(len);
+			unsigned int seed = 12345;
+			for (int i = 0; i < len; i++)
+			{
+				seed = seed * 1664525 + 1013904223;
+				float noise = (float)((seed >> 8) % 1000) / 1000.0f;
+				input[i] = (i / 3000) % 3 == 0 ? (float)((i / 7) % 5) : (i / 3000) % 3 == 1 ? noise * (float)i / len : noise;
+			}
+
+			bool pass = true;
+			int windows[] = { 1, 2, 17, 480, 4096 };
+			for (int window : windows)
+			{
+				AudioLib::SlidingMaxT<float, 4096> slidingMax(window);
+				AudioLib::SlidingMinT<float, 4096> slidingMin(window);
+				int mismatches = 0;
+				for (int i = 0; i < len; i++)
+				{
+					float max = input[i], min = input[i];
+					for (int j = i - window + 1 < 0 ? 0 : i - window + 1; j < i; j++)
+					{
+						max = std::max(max, input[j]);
+						min = std::min(min, input[j]);
+					}
+
+					mismatches += slidingMax.Process(input[i]) != max;
+					mismatches += slidingMin.Process(input[i]) != min;
+				}
+
+				bool ok = mismatches == 0;
+				pass &= ok;
+				std::printf("%-4s SlidingExtreme window %-6d %d mismatches against a full scan\n", ok ? "PASS" : "FAIL", window, mismatches);
+			}
+
+			// PeakDetector against the scan of every stored peak it replaced
+			double rates[] = { 44100, 192000 };
+			for (double fs : rates)
+			{
+				PeakDetector detector(fs);
+				int windowSize = (int)(10.0 / 1000.0 * fs);
+				std::deque<std::pair<int, float>> storedPeaks;
+				float prev = 0, current = 0;
+				int mismatches = 0;
+				for (int i = 0; i < len; i++)
+				{
+					float val = std::abs(input[i] - 0.5f);
+					if (val < prev)
+						storedPeaks.push_back(std::make_pair(i, prev));
+					prev = val;
+
+					while (!storedPeaks.empty() && storedPeaks.front().first < i - windowSize)
+						storedPeaks.pop_front();
+
+					bool found = false;
+					float maxPeak = 0;
+					for (auto& p : storedPeaks)
+					{
+						if (!found || p.second > maxPeak)
+						{
+							maxPeak = p.second;
+							found = true;
+						}
+					}
+
+					float fallback = std::max(current * 0.995f, val);
+					current = found && maxPeak > fallback ? maxPeak : fallback;
+					mismatches += detector.ProcessPeaks(val) != current;
+				}
+
+				bool ok = mismatches == 0;
+				pass &= ok;
+				std::printf("%-4s PeakDetector fs=%-9.0f %d mismatches against a full scan\n", ok ? "PASS" : "FAIL", fs, mismatches);
+			}
+
+			return pass;
+		}
+
+		bool RegressionHarness::CheckBiquadBank()
+		{
+			const int Lanes = 16;
+			const double fs = 48000;
+			const int len = 20000;
+
+			// a different filter and a differently scaled noise burst on every lane
+			AudioLib::SosCoefficients<float> coefficients[Lanes];
+			for (int l = 0; l < Lanes; l++)
+			{
+				AudioLib::Biquad design((AudioLib::Biquad::FilterType)(l % 3), (int)fs);
+				design.Frequency = (float)(30.0 * std::pow(1.5, l));
+				design.SetQ(0.5f + 0.25f * (l % 4));
+				design.Update();
+				coefficients[l] = design.GetCoefficients();
+			}
+
+			std::vector<float> input(len * Lanes);
+			unsigned int seed = 4321;
+			for (int i = 0; i < len; i++)
+			{
+				for (int l = 0; l < Lanes; l++)
+				{
+					seed = seed * 1664525 + 1013904223;
+					float noise = (float)((seed >> 8) % 2001) / 1000.0f - 1.0f;
+					input[i * Lanes + l] = (i / 2500 + l) % 3 == 0 ? 0.0f : noise * (l + 1) / Lanes;
+				}
+			}
+
+			bool pass = true;
+			auto report = [&pass](const char* name, int mismatches)
+			{
+				bool ok = mismatches == 0;
+				pass &= ok;
+				std::printf("%-4s %-40s %d mismatches against scalar filters\n", ok ? "PASS" : "FAIL", name, mismatches);
+			};
+
+			{
+				// BiquadT can't be given coefficients, so the lanes are compared with a copy of its block loop
+				struct DirectForm1
+				{
+					AudioLib::SosCoefficients<float> c;
+					float x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+					float Process(float x)
+					{
+						float y = ((c.B0 * x) + (c.B1 * x1) + (c.B2 * x2)) - (c.A1 * y1) - (c.A2 * y2);
+						x2 = x1;
+						y2 = y1;
+						x1 = x;
+						y1 = y;
+						return y;
+					}
+				};
+
+				DirectForm1 scalars[Lanes];
+				for (int l = 0; l < Lanes; l++)
+					scalars[l].c = coefficients[l];
+				report("BiquadBank<16> direct form I", CountBankMismatches<AudioLib::BiquadBankT<Lanes, float, AudioLib::BiquadForm::DirectForm1>, Lanes>(input, coefficients, scalars));
+			}
+
+			{
+				AudioLib::Tdf2BiquadT<float> scalars[Lanes];
+				for (int l = 0; l < Lanes; l++)
+					scalars[l].SetCoefficients(coefficients[l]);
+				report("BiquadBank<16> transposed", CountBankMismatches<AudioLib::BiquadBankT<Lanes, float>, Lanes>(input, coefficients, scalars));
+			}
+
+			{
+				AudioLib::Tdf2BiquadT<float, double> scalars[Lanes];
+				for (int l = 0; l < Lanes; l++)
+					scalars[l].SetCoefficients(coefficients[l]);
+				report("BiquadBank<16> transposed, double acc", CountBankMismatches<AudioLib::BiquadBankT<Lanes, double>, Lanes>(input, coefficients, scalars));
+			}
+
+			{
+				// the first 4 lanes through a 4 lane bank
+				std::vector<float> narrow(len * 4);
+				for (int i = 0; i < len; i++)
+					for (int l = 0; l < 4; l++)
+						narrow[i * 4 + l] = input[i * Lanes + l];
+
+				AudioLib::Tdf2BiquadT<float, double> scalars[4];
+				for (int l = 0; l < 4; l++)
+					scalars[l].SetCoefficients(coefficients[l]);
+				report("BiquadBank<4> transposed, double acc", CountBankMismatches<AudioLib::BiquadBankT<4, double>, 4>(narrow, coefficients, scalars));
+			}
+
+			// The cascade in blocks against its sections sample by sample, and the transposed form against
+			// direct form I in double precision: the same filter up to rounding
+			{
+				AudioLib::SosCascadeT<float, 4, double> cascade;
+				AudioLib::Tdf2BiquadT<float, double> sections[3];
+				AudioLib::SosCoefficients<float> cascadeCoefficients[3] = { coefficients[2], coefficients[3], coefficients[7] };
+				cascade.SetSections(cascadeCoefficients, 3);
+				for (int k = 0; k < 3; k++)
+					sections[k].SetCoefficients(cascadeCoefficients[k]);
+
+				std::vector<float> mono(len), output(len);
+				for (int i = 0; i < len; i++)
+					mono[i] = input[i * Lanes + 5];
+
+				for (int pos = 0; pos < len; pos += 333)
+					cascade.Process(&mono[pos], &output[pos], std::min(333, len - pos));
+
+				int mismatches = 0;
+				for (int i = 0; i < len; i++)
+					mismatches += output[i] != sections[2].Process(sections[1].Process(sections[0].Process(mono[i])));
+				report("SosCascade 3 sections", mismatches);
+
+				AudioLib::Tdf2BiquadT<double> transposed;
+				transposed.SetCoefficients(coefficients[3]);
+				auto& c = coefficients[3];
+				double x1 = 0, x2 = 0, y1 = 0, y2 = 0, maxError = 0;
+				for (int i = 0; i < len; i++)
+				{
+					double x = mono[i];
+					double y = c.B0 * x + c.B1 * x1 + c.B2 * x2 - c.A1 * y1 - c.A2 * y2;
+					x2 = x1;
+					y2 = y1;
+					x1 = x;
+					y1 = y;
+					maxError = std::max(maxError, std::abs(transposed.Process(x) - y));
+				}
+
+				bool ok = maxError < 1e-9;
+				pass &= ok;
+				std::printf("%-4s %-40s max error %.3g against direct form I\n", ok ? "PASS" : "FAIL", "Tdf2Biquad (double)", maxError);
+			}
+
+			return pass;
+		}
+
+		bool RegressionHarness::CheckButterworth()
+		{
+			const double rates[] = { 44100, 384000 };
+			const double cutoffs[] = { 20, 200, 5000, 18000 };
+			const double frequencies[] = { 10, 100, 1000, 5000, 15000, 21000 };
+
+			// the bilinear transform maps the analog response onto tan(pi f / fs), with the cutoff prewarped the same way.
+			// Low cutoffs at 384kHz put the poles next to z = 1, where the response is a small difference of large terms
+			double maxError = 0;
+			for (auto fs : rates)
+			{
+				AudioLib::Butterworth design(fs);
+				for (int order = 1; order <= AudioLib::Butterworth::MaxOrder; order++)
+				{
+					for (auto cutoff : cutoffs)
+					{
+						for (int highpass = 0; highpass < 2; highpass++)
+						{
+							design.Order = order;
+							design.CutoffHz = cutoff;
+							design.Type = highpass ? AudioLib::Butterworth::FilterType::HighPass : AudioLib::Butterworth::FilterType::LowPass;
+							design.Update();
+
+							for (auto freq : frequencies)
+							{
+								double ratio = std::tan(M_PI * freq / fs) / std::tan(M_PI * cutoff / fs);
+								if (highpass)
+									ratio = 1 / ratio;
+								double expected = 1 / std::sqrt(1 + std::pow(ratio, 2 * order));
+								maxError = std::max(maxError, std::abs(design.GetResponse(freq) - expected));
+							}
+						}
+					}
+				}
+			}
+
+			bool pass = maxError < 1e-6;
+			std::printf("%-4s %-40s max error %.3g against the analog response\n", pass ? "PASS" : "FAIL", "Butterworth orders 1-8", maxError);
+
+			// A sine through the hold smoother's design, a 4th order lowpass at 200Hz, against GetResponse
+			{
+				const double fs = 48000;
+				const double freq = 300;
+				AudioLib::Butterworth design(fs);
+				design.Order = 4;
+				design.CutoffHz = 200;
+				design.Update();
+
+				AudioLib::SosCascadeT<double, AudioLib::Butterworth::MaxSections> cascade;
+				cascade.SetSections(design.GetSections(), design.GetSectionCount());
+
+				// a whole number of periods after the transient has died out
+				int settle = (int)fs;
+				int periods = 30;
+				int len = (int)(periods * fs / freq);
+				double peak = 0;
+				for (int i = 0; i < settle + len; i++)
+				{
+					double y = cascade.Process(std::sin(2 * M_PI * freq * i / fs));
+					if (i >= settle)
+						peak = std::max(peak, std::abs(y));
+				}
+
+				double error = std::abs(peak - design.GetResponse(freq));
+				bool ok = error < 1e-3;
+				pass &= ok;
+				std::printf("%-4s %-40s gain %.5f, designed %.5f\n", ok ? "PASS" : "FAIL", "SosCascade Butterworth sine", peak, design.GetResponse(freq));
+
+				cascade.SetSteadyState(0.25);
+				double steady = 0;
+				for (int i = 0; i < 1000; i++)
+					steady = std::max(steady, std::abs(cascade.Process(0.25) - 0.25));
+
+				ok = steady < 1e-12;
+				pass &= ok;
+				std::printf("%-4s %-40s max error %.3g on a constant input\n", ok ? "PASS" : "FAIL", "SosCascade steady state", steady);
+			}
+
+			return pass;
+		}
+
+		/// <summary>
+		/// Follows a slew limited gain that jumps between open, closed and wandering levels with GainRampT in blocks of
+		/// varying size. Returns the largest error in dB and counts the steady samples whose gain isn't exactly DB2gain
+		/// </summary>
+		template<typename T>
+		static double GainRampError(double fs, int& inexact)
+		{
+			const int len = 200000;
+			SlewLimiterT<T> slew(fs);
+			slew.UpdateDb60(2.0, 50.0);
+			GainRampT<T> ramp;
+			std::vector<T> target(len), levels(len), gains(len);
+
+			unsigned int seed = 4711;
+			for (int i = 0; i < len; i++)
+			{
+				seed = seed * 1664525 + 1013904223;
+				int segment = (i / 5000) % 4;
+				double noise = (double)((seed >> 8) % 1000) / 1000.0;
+				target[i] = (T)(segment == 0 ? 0.0 : segment == 1 ? -80.0 : segment == 2 ? -30.0 + 10 * std::sin(i * 0.001) : -150.0 + 20 * noise);
+			}
+
+			slew.Process(&target[0], &levels[0], len);
+			for (int pos = 0; pos < len;)
+			{
+				seed = seed * 1664525 + 1013904223;
+				int count = std::min(len - pos, 1 + (int)((seed >> 8) % 700));
+				ramp.Follow(&levels[pos], &gains[pos], count);
+				pos += count;
+			}
+
+			double worst = 0;
+			inexact = 0;
+			for (int i = 0; i < len; i++)
+			{
+				T exact = (T)AudioLib::Utils::DB2gain(levels[i]);
+				worst = std::max(worst, std::abs(20 * std::log10((double)gains[i] / (double)exact)));
+				if (i > 0 && levels[i] == levels[i - 1] && gains[i] != exact)
+					inexact++;
+			}
+
+			return worst;
+		}
+
+		// Steps of MaxInterval samples towards random levels at up to 1dB per sample, split into calls of random length, against the exact gain
+		// of every sample's level
+		template<typename T>
+		static double GainRampStepError()
+		{
+			const int len = 200000;
+			GainRampT<T> ramp;
+			ramp.SetInterval(GainRampT<T>::MaxInterval);
+			std::vector<T> levels(len), gains(len);
+
+			unsigned int seed = 4711;
+			T level = 0;
+			for (int pos = 0; pos < len;)
+			{
+				if (ramp.IsStepDone())
+				{
+					seed = seed * 1664525 + 1013904223;
+					T target = -(T)((seed >> 8) % 100);
+					T deltaDb = std::max((T)-1, std::min((T)1, (target - level) / GainRampT<T>::MaxInterval));
+					ramp.Start(deltaDb, level + GainRampT<T>::MaxInterval * deltaDb);
+					level = ramp.GetLevel();
+				}
+
+				seed = seed * 1664525 + 1013904223;
+				int count = std::min(len - pos, 1 + (int)((seed >> 8) % 100));
+				pos += ramp.Process(&levels[pos], &gains[pos], count);
+			}
+
+			double worst = 0;
+			for (int i = 0; i < len; i++)
+			{
+				double exact = AudioLib::Utils::DB2gain((double)levels[i]);
+				worst = std::max(worst, std::abs(20 * std::log10((double)gains[i] / exact)));
+			}
+
+			return worst;
+		}
+
+		bool RegressionHarness::CheckGainRamp()
+		{
+			bool pass = true;
+			double rates[] = { 8000, 44100, 192000 };
+			for (double fs : rates)
+			{
+				int inexactFloat, inexactDouble;
+				double errorFloat = GainRampError<float>(fs, inexactFloat);
+				double errorDouble = GainRampError<double>(fs, inexactDouble);
+				// float rounds on each of up to MaxInterval multiplies, double is limited by the series alone
+				bool ok = errorFloat < 1e-4 && errorDouble < 1e-5 && inexactFloat == 0 && inexactDouble == 0;
+				pass &= ok;
+				std::printf("%-4s GainRamp::Follow fs=%-7.0f max error %.3g dB float, %.3g dB double, %d steady samples inexact\n",
+					ok ? "PASS" : "FAIL", fs, errorFloat, errorDouble, inexactFloat + inexactDouble);
+			}
+
+			// a step's ratio and its powers are in double, the float gain only rounds once per Lanes samples
+			double stepFloat = GainRampStepError<float>();
+			double stepDouble = GainRampStepError<double>();
+			bool ok = stepFloat < 1e-5 && stepDouble < 1e-7;
+			pass &= ok;
+			std::printf("%-4s GainRamp::Process max error %.3g dB float, %.3g dB double\n", ok ? "PASS" : "FAIL", stepFloat, stepDouble);
+
+			return pass;
+		}
+
+		bool RegressionHarness::CheckOfflineSegments()
+		{
+			auto directory = std::filesystem::temp_directory_path();
+			std::string inputPath = (directory / "NoiseGateRegression_in.wav").string();
+			std::string serialPath = (directory / "NoiseGateRegression_serial.wav").string();
+			std::string segmentedPath = (directory / "NoiseGateRegression_segmented.wav").string();
+			Offline::WavFormat format = { 2, 48000, Offline::SampleFormat::Float32 };
+
+			// noise bursts, so the gate opens and closes within the file
+			auto writeInput = [&](int frames)
+			{
+				std::vector<float> left(frames), right(frames);
+				unsigned int seed = 1357;
+				for (int i = 0; i < frames; i++)
+				{
+					seed = seed * 1664525 + 1013904223;
+					left[i] = (i / 4000) % 2 == 0 ? (float)((seed >> 8) % 2001) / 2000.0f - 0.5f : 0.0f;
+					right[i] = left[i] * 0.5f;
+				}
+
+				const float* channels[] = { left.data(), right.data() };
+				std::string error;
+				Offline::WavWriter writer;
+				return writer.Open(inputPath, format, error) && writer.Write(channels, frames) && writer.Close();
+			};
+
+			auto readOutput = [&](const std::string& path, std::vector<float>& samples)
+			{
+				Offline::WavReader reader;
+				std::string error;
+				if (!reader.Open(path, error))
+					return false;
+
+				int frames = (int)reader.GetFrameCount();
+				std::vector<float> left(frames), right(frames);
+				float* channels[] = { left.data(), right.data() };
+				reader.Read(0, frames, channels);
+				samples = left;
+				samples.insert(samples.end(), right.begin(), right.end());
+				return true;
+			};
+
+			bool pass = true;
+			for (int frames : { 0, 1, 100, 4000, 60000, 200000 })
+			{
+				for (int segments : { 2, 8 })
+				{
+					Offline::Settings settings;
+					Offline::Scratch scratch;
+					Offline::FileStats serialStats, segmentedStats;
+					std::string error;
+					std::vector<float> serial, segmented;
+
+					settings.ThresholdDb = -30;
+					bool ok = writeInput(frames)
+						&& Offline::ProcessFile(settings, inputPath, serialPath, scratch, nullptr, serialStats, error)
+						&& readOutput(serialPath, serial);
+
+					settings.Segments = segments;
+					Offline::IoLimiter io(2);
+					ok = ok
+						&& Offline::ProcessFile(settings, inputPath, segmentedPath, scratch, &io, segmentedStats, error)
+						&& readOutput(segmentedPath, segmented);
+
+					// the segments actually used, none shorter than the warm-up
+					double warmupFrames = segmentedStats.WarmupSeconds * format.SampleRate;
+					int used = segmentedStats.Segments;
+					ok = ok && serial.size() == (size_t)frames * 2 && segmented.size() == serial.size() && used <= segments
+						&& (used == 1 || frames / used >= warmupFrames);
+
+					// the seams are re-run until the kernels converged, so only a serial fallback is bit-exact
+					double maxError = 0;
+					for (size_t i = 0; ok && i < serial.size(); i++)
+						maxError = std::max(maxError, (double)std::abs(serial[i] - segmented[i]));
+
+					ok = ok && (used > 1 || maxError == 0) && maxError < 1e-3;
+					pass &= ok;
+					std::printf("%-4s NoiseGateOffline %6d frames, --segments %d: %d segments used, max error %.3g against serial%s\n",
+						ok ? "PASS" : "FAIL", frames, segments, used, maxError, error.empty() ? "" : (", " + error).c_str());
+				}
+			}
+
+			std::error_code ignored;
+			for (auto& path : { inputPath, serialPath, segmentedPath })
+				std::filesystem::remove(path, ignored);
+
+			return pass;
+		}
+
+		/// <summary>
+		/// Runs the block version of EnvelopeFollowerT in blocks of varying size next to the per sample version, over
+		/// noise bursts, a swept sine and silence, and counts the samples whose envelopes differ
+		/// </summary>
+		template<typename T>
+		static int CountEnvelopeMismatches(double fs, AudioLib::MathPrecision precision, int decimation, HoldSmootherMode smoother)
+		{
+			const int len = 60000;
+			EnvelopeFollowerT<T> scalar(fs, 100), block(fs, 100);
+			for (auto follower : { &scalar, &block })
+			{
+				follower->SetPrecision(precision);
+				follower->SetDecimation(decimation);
+				follower->SetHoldSmoother(smoother);
+			}
+
+			std::vector<T> input(len), output(len);
+			unsigned int seed = 2468;
+			for (int i = 0; i < len; i++)
+			{
+				seed = seed * 1664525 + 1013904223;
+				int segment = (i / 6000) % 4;
+				double noise = (double)((seed >> 8) % 2001) / 1000.0 - 1.0;
+				double level = std::pow(10.0, -3.0 * (i % 6000) / 6000.0);
+				input[i] = (T)(segment == 0 ? noise * level : segment == 1 ? 0.0 : segment == 2 ? level * std::sin(i * i * 1e-6) : noise * 1e-4);
+			}
+
+			for (int pos = 0; pos < len;)
+			{
+				seed = seed * 1664525 + 1013904223;
+				int count = std::min(len - pos, 1 + (int)((seed >> 8) % 700));
+				block.ProcessEnvelope(&input[pos], &output[pos], count);
+				pos += count;
+			}
+
+			int mismatches = 0;
+			for (int i = 0; i < len; i++)
+			{
+				scalar.ProcessEnvelope(input[i]);
+				mismatches += scalar.GetOutput() != output[i];
+			}
+
+			return mismatches;
+		}
+
+		bool RegressionHarness::CheckEnvelopeFollower()
+		{
+			bool pass = true;
+			AudioLib::SimdLevel original = AudioLib::Simd::GetLevel();
+			for (int l = 0; l <= (int)AudioLib::Simd::GetSupportedLevel(); l++)
+			{
+				AudioLib::SimdLevel level = AudioLib::Simd::SetLevel((AudioLib::SimdLevel)l);
+				for (auto precision : { AudioLib::MathPrecision::Exact, AudioLib::MathPrecision::Db001, AudioLib::MathPrecision::Db01 })
+				{
+					int mismatchesFloat = 0, mismatchesDouble = 0;
+					for (int decimation : { 1, 4 })
+					{
+						for (auto smoother : { HoldSmootherMode::Butterworth, HoldSmootherMode::OnePoleCascade })
+						{
+							mismatchesFloat += CountEnvelopeMismatches<float>(48000, precision, decimation, smoother);
+							mismatchesDouble += CountEnvelopeMismatches<double>(48000, precision, decimation, smoother);
+						}
+					}
+
+					const char* precisionName = precision == AudioLib::MathPrecision::Exact ? "exact" : precision == AudioLib::MathPrecision::Db001 ? "0.01dB" : "0.1dB";
+					bool ok = mismatchesFloat == 0 && mismatchesDouble == 0;
+					pass &= ok;
+					std::printf("%-4s EnvelopeFollower block %-7s %-7s %d float, %d double samples differ from per sample\n",
+						ok ? "PASS" : "FAIL", AudioLib::Simd::GetName(level), precisionName, mismatchesFloat, mismatchesDouble);
+				}
+			}
+
+			AudioLib::Simd::SetLevel(original);
+			return pass;
+		}
+
+		bool RegressionHarness::CheckTransfer()
+		{
+			const double fs = 48000;
+			const int len = 20000;
+
+			std::vector<double> input(len);
+			unsigned int seed = 2468;
+			for (int i = 0; i < len; i++)
+			{
+				seed = seed * 1664525 + 1013904223;
+				input[i] = (i / 3000) % 2 == 0 ? (double)((seed >> 8) % 2001) / 1000.0 - 1.0 : 0.0;
+			}
+
+			bool pass = true;
+			auto report = [&pass](const char* name, double maxError, double limit, int mismatches)
+			{
+				bool ok = maxError < limit && mismatches == 0;
+				pass &= ok;
+				std::printf("%-4s %-40s max error %.3g against Transfer, %d block mismatches\n", ok ? "PASS" : "FAIL", name, maxError, mismatches);
+			};
+
+			// runs the fixed order filter in blocks of 333 against itself sample by sample and against Transfer
+			auto compare = [&](auto& fixed, auto& single, AudioLib::Transfer& dynamic, double& maxError, int& mismatches)
+			{
+				std::vector<double> output(len);
+				for (int pos = 0; pos < len; pos += 333)
+					fixed.Process(&input[pos], &output[pos], std::min(333, len - pos));
+
+				maxError = 0;
+				mismatches = 0;
+				for (int i = 0; i < len; i++)
+				{
+					mismatches += output[i] != single.Process(input[i]);
+					maxError = std::max(maxError, std::abs(output[i] - dynamic.Process(input[i])));
+				}
+			};
+
+			// a 4th order Butterworth lowpass, also against its own sections
+			{
+				AudioLib::Butterworth design(fs);
+				design.CutoffHz = 1000;
+				design.Order = 4;
+				design.Update();
+
+				double b[5], a[5];
+				design.GetTransfer(b, a);
+
+				AudioLib::TransferT<double, 4> fixed, single;
+				fixed.SetB(b);
+				fixed.SetA(a);
+				single.SetB(b);
+				single.SetA(a);
+
+				AudioLib::Transfer dynamic;
+				dynamic.SetB(std::vector<double>(b, b + 5));
+				dynamic.SetA(std::vector<double>(a, a + 5));
+
+				double maxError;
+				int mismatches;
+				compare(fixed, single, dynamic, maxError, mismatches);
+				report("TransferT<4> Butterworth", maxError, 1e-9, mismatches);
+
+				AudioLib::SosCascadeT<double, 2> cascade;
+				AudioLib::TransferT<double, 4> check;
+				cascade.SetSections(design.GetSections(), design.GetSectionCount());
+				check.SetB(b);
+				check.SetA(a);
+				double sectionError = 0;
+				for (int i = 0; i < len; i++)
+					sectionError = std::max(sectionError, std::abs(cascade.Process(input[i]) - check.Process(input[i])));
+
+				bool ok = sectionError < 1e-9;
+				pass &= ok;
+				std::printf("%-4s %-40s max error %.3g against the sections\n", ok ? "PASS" : "FAIL", "TransferT<4> Butterworth", sectionError);
+			}
+
+			// unnormalised, with a longer numerator than denominator
+			{
+				const double b[] = { 0.5, -0.2, 0.3, 0.1 };
+				const double a[] = { 2.0, -1.2, 0.4 };
+				AudioLib::TransferT<double, 3, 2> fixed, single;
+				fixed.SetB(b);
+				fixed.SetA(a);
+				single.SetB(b);
+				single.SetA(a);
+
+				AudioLib::Transfer dynamic;
+				dynamic.SetB(std::vector<double>(b, b + 4));
+				dynamic.SetA(std::vector<double>(a, a + 3));
+
+				double maxError;
+				int mismatches;
+				compare(fixed, single, dynamic, maxError, mismatches);
+				report("TransferT<3, 2> a[0] = 2", maxError, 1e-12, mismatches);
+			}
+
+			// a 16 tap FIR
+			{
+				double b[17];
+				for (int j = 0; j <= 16; j++)
+					b[j] = std::sin(0.3 * (j + 1)) / (j + 1);
+				const double a[] = { 1.0 };
+
+				AudioLib::TransferT<double, 16, 0> fixed, single;
+				fixed.SetB(b);
+				single.SetB(b);
+
+				AudioLib::Transfer dynamic;
+				dynamic.SetB(std::vector<double>(b, b + 17));
+				dynamic.SetA(std::vector<double>(a, a + 1));
+
+				double maxError;
+				int mismatches;
+				compare(fixed, single, dynamic, maxError, mismatches);
+				report("TransferT<16, 0> FIR", maxError, 1e-12, mismatches);
+			}
+
+			return pass;
+		}
+	}
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "TestSignals.h"
+
+namespace NoiseInvader
+{
+	namespace Regression
+	{
+		struct GateSettings
+		{
+			std::string Name;
+			float DetectorGain;
+			double ReductionDb;
+			double ThresholdDb;
+			double Slope;
+			double ReleaseMs;
+		};
+
+		/// <summary>
+		/// Everything an engine produced for one test signal: the final output plus the per-sample
+		/// value of each stage of the gain computer
+		/// </summary>
+		struct EngineTrace
+		{
+			std::vector<float> OutputL;
+			std::vector<float> OutputR;
+			std::vector<double> Envelope;
+			std::vector<double> ExpanderDb;
+			std::vector<double> SlewDb;
+
+			void Resize(int len);
+		};
+
+		// Maximum absolute error per stage. Envelope is compared in dB (floored at -150dB), output as linear sample values
+		struct StageErrors
+		{
+			double EnvelopeDb;
+			double ExpanderDb;
+			double SlewDb;
+			double Output;
+		};
+
+		typedef StageErrors Tolerances;
+
+		// Tolerances for single test signals by name, in place of the ones of the whole check
+		typedef std::map<std::string, Tolerances> SignalTolerances;
+
+		// Runs one engine over a test signal with the given settings, filling every field of the trace
+		typedef std::function<void(const TestSignal& signal, const GateSettings& settings, EngineTrace& trace)> Engine;
+
+		class RegressionHarness
+		{
+		public:
+			std::vector<TestSignal> Signals;
+			std::vector<GateSettings> Settings;
+			bool Verbose;
+
+			RegressionHarness(double fs);
+
+			// Runs the frozen reference chain
+			static void RunReference(const TestSignal& signal, const GateSettings& settings, EngineTrace& trace);
+
+			/// <summary>
+			/// Largest error of each stage. With a window, every actual sample is held to the closest expected one up to
+			/// window samples earlier or later, so a difference in timing within the window isn't counted as an error
+			/// </summary>
+			static StageErrors Compare(const EngineTrace& expected, const EngineTrace& actual, int window = 0);
+			static bool IsBitExact(const EngineTrace& expected, const EngineTrace& actual);
+
+			/// <summary>
+			/// Compares a candidate against the frozen reference for every signal and setting.
+			/// Returns false if any stage exceeds its tolerance, or that of signalTolerances for the signals listed there
+			/// </summary>
+			bool CheckAgainstReference(const std::string& name, Engine candidate, const Tolerances& tolerances,
+				const SignalTolerances& signalTolerances = {});
+
+			/// <summary>
+			/// Same comparison against another engine instead of the reference, expectedName labels it in the report.
+			/// timingMs is the window of Compare, for engines that may act a little earlier or later than the expected one
+			/// </summary>
+			bool CheckAgainst(const std::string& name, const std::string& expectedName, Engine expected, Engine actual, const Tolerances& tolerances,
+				double timingMs = 0, const SignalTolerances& signalTolerances = {});
+
+			/// <summary>
+			/// Bit-exact mode. Runs both engines on every signal and setting and requires identical output and stage
+			/// values down to the last bit. Used to show that segmented or threaded processing is deterministic
+			/// </summary>
+			bool CheckBitExact(const std::string& name, Engine expected, Engine actual);
+
+			/// <summary>
+			/// Checks that the gain in dB (the slew limiter stage) never rises faster than 60dB in attackMs or falls faster
+			/// than 60dB in the release of the settings, from one sample to the next, for every signal and setting
+			/// </summary>
+			bool CheckSlewRates(const std::string& name, Engine engine, double attackMs);
+
+			/// <summary>
+			/// Sweeps the VectorMath dB conversions against the standard library and checks the
+			/// documented maximum error of each precision mode, on every SimdLevel the CPU supports. The Simd array
+			/// functions and MaxAbs are checked for exact results on lengths that leave every possible tail
+			/// </summary>
+			static bool CheckVectorMath();
+
+			/// <summary>
+			/// Checks SlidingExtreme and the PeakDetector built on it sample for sample against a full scan of the window
+			/// </summary>
+			static bool CheckSlidingExtreme();
+
+			/// <summary>
+			/// Checks every form of BiquadBank lane by lane against the scalar filters, across a state handover, and the
+			/// transposed direct form II filters and cascade against direct form I
+			/// </summary>
+			static bool CheckBiquadBank();
+
+			/// <summary>
+			/// Checks the Butterworth designs of every order against the prewarped analog response, and a cascade of
+			/// the designed sections against the designer's response and its own steady state
+			/// </summary>
+			static bool CheckButterworth();
+
+			/// <summary>
+			/// Checks the fixed order TransferT against the dynamic Transfer and the same filter as sections, in
+			/// blocks and sample by sample, IIR and FIR
+			/// </summary>
+			static bool CheckTransfer();
+
+			/// <summary>
+			/// Checks the incremental gain factor of GainRampT::Follow against the exact DB2gain of a slew limited gain, in
+			/// both sample types: within 1e-4 dB (float) and 1e-5 dB (double) while moving, and exact once the gain holds still
+			/// </summary>
+			static bool CheckGainRamp();
+
+			/// <summary>
+			/// Runs the offline file processor on an empty, a very short and a long file, serially and in segments. A file
+			/// too short for two segments of at least the warm-up must come out like the serial run, a long one with the
+			/// segment count cut down to what its length allows
+			/// </summary>
+			static bool CheckOfflineSegments();
+
+			/// <summary>
+			/// Checks the block version of the envelope follower sample for sample against the per sample version, at
+			/// every precision and SIMD level, with and without decimation and with both hold smoothers: they must agree exactly
+			/// </summary>
+			static bool CheckEnvelopeFollower();
+
+		private:
+			bool Report(const std::string& name, const TestSignal& signal, const GateSettings& settings, const StageErrors& errors, const Tolerances& tolerances);
+		};
+	}
+}
@@ -0,0 +1,177 @@
+#include <cmath>
+
+#include "AudioLib/MathDefs.h"
+#include "TestSignals.h"
+
+namespace NoiseInvader
+{
+	namespace Regression
+	{
+		// Small LCG, returns -1...1
+		class Random
+		{
+		private:
+			unsigned int seed;
+
+		public:
+			Random(unsigned int seed) : seed(seed) { }
+
+			double Next()
+			{
+				seed = seed * 1664525 + 1013904223;
+				return (seed >> 8) / (double)(1 << 24) * 2 - 1;
+			}
+		};
+
+		static TestSignal Create(const std::string& name, double fs, int len)
+		{
+			TestSignal s;
+			s.Name = name;
+			s.Fs = fs;
+			s.Left.assign(len, 0.0f);
+			s.Right.assign(len, 0.0f);
+			s.Detector.assign(len, 0.0f);
+			return s;
+		}
+
+		TestSignal TestSignals::Analysis(double fs)
+		{
+			// the original is 20000 samples at 48Khz, scale the timing to the samplerate
+			auto scale = fs / 48000.0;
+			auto s = Create("Analysis", fs, (int)(20000 * scale));
+			auto leadIn = (int)(1000 * scale);
+			auto tail = (int)(12000 * scale);
+			auto decayPerSample = std::pow(0.9998, 1.0 / scale);
+
+			Random random(1);
+			double decay = 1.0;
+
+			for (int i = 0; i < s.Length(); i++)
+			{
+				auto x = (std::sin(i / fs * 2 * M_PI * 300) + random.Next() * 0.4) * decay;
+				decay *= decayPerSample;
+				if (i < leadIn)
+					x = random.Next() * 0.001;
+				else if (i > tail)
+					x = random.Next() * 0.001;
+
+				s.Left[i] = (float)x;
+				s.Right[i] = (float)(x * 0.8);
+				s.Detector[i] = (float)x;
+			}
+
+			return s;
+		}
+
+		TestSignal TestSignals::NoiseBursts(double fs)
+		{
+			auto s = Create("NoiseBursts", fs, (int)(4.0 * fs));
+			Random random(2);
+
+			const double levelsDb[] = { -6, -60, -24, -40, -12, -80, -30, -3 };
+			const double lengthsMs[] = { 200, 5, 50, 120, 10, 300, 20, 80 };
+			int pos = (int)(0.05 * fs);
+
+			for (int burst = 0; burst < 8; burst++)
+			{
+				auto gain = std::pow(10, levelsDb[burst] / 20);
+				auto len = (int)(lengthsMs[burst] / 1000 * fs);
+
+				for (int i = 0; i < len && pos + i < s.Length(); i++)
+					s.Left[pos + i] = (float)(random.Next() * gain);
+
+				// gaps of 100...400ms with a -100dB floor
+				pos += len + (int)((0.25 + 0.15 * random.Next()) * fs);
+			}
+
+			for (int i = 0; i < s.Length(); i++)
+			{
+				if (s.Left[i] == 0.0f)
+					s.Left[i] = (float)(random.Next() * 1e-5);
+
+				s.Right[i] = -s.Left[i];
+				// aux detector: the same bursts, slightly louder and with some extra noise on top
+				s.Detector[i] = (float)(s.Left[i] * 1.5 + random.Next() * 1e-4);
+			}
+
+			return s;
+		}
+
+		TestSignal TestSignals::Impulses(double fs)
+		{
+			auto s = Create("Impulses", fs, (int)(3.0 * fs));
+			Random random(3);
+
+			// isolated impulses with growing spacing
+			int pos = (int)(0.01 * fs);
+			double spacingMs = 1;
+			while (pos < s.Length() / 2)
+			{
+				s.Left[pos] = (float)(0.1 + 0.9 * std::abs(random.Next()));
+				pos += (int)(spacingMs / 1000 * fs) + 1;
+				spacingMs *= 1.6;
+			}
+
+			// impulse trains, 2ms spacing, bursts of 20
+			pos = s.Length() / 2;
+			for (int train = 0; train < 5; train++)
+			{
+				auto amp = std::pow(10, -6.0 * train / 20);
+				for (int i = 0; i < 20; i++)
+				{
+					auto idx = pos + (int)(i * 0.002 * fs);
+					if (idx < s.Length())
+						s.Left[idx] = (float)(i % 2 == 0 ? amp : -amp);
+				}
+
+				pos += (int)(0.25 * fs);
+			}
+
+			for (int i = 0; i < s.Length(); i++)
+			{
+				s.Right[i] = s.Left[i];
+				s.Detector[i] = s.Left[i];
+			}
+
+			return s;
+		}
+
+		TestSignal TestSignals::LongSilence(double fs)
+		{
+			auto s = Create("LongSilence", fs, (int)(45.0 * fs));
+			Random random(4);
+
+			auto tone = [&](double startSec, double lenSec, double amp)
+			{
+				auto start = (int)(startSec * fs);
+				auto len = (int)(lenSec * fs);
+				for (int i = 0; i < len && start + i < s.Length(); i++)
+					s.Left[start + i] = (float)(amp * std::sin(2 * M_PI * 440 * i / fs));
+			};
+
+			// 0.5s tone, 30s digital silence, tone, 10s of -90dB noise, tone, then silence to the end
+			tone(0.0, 0.5, 0.5);
+			tone(30.5, 0.5, 0.3);
+
+			auto noiseStart = (int)(31.0 * fs);
+			auto noiseEnd = (int)(41.0 * fs);
+			for (int i = noiseStart; i < noiseEnd; i++)
+				s.Left[i] = (float)(random.Next() * 3e-5);
+
+			tone(41.0, 0.5, 0.5);
+
+			for (int i = 0; i < s.Length(); i++)
+			{
+				s.Right[i] = s.Left[i];
+				s.Detector[i] = s.Left[i];
+			}
+
+			return s;
+		}
+
+		std::vector<TestSignal> TestSignals::All(double fs)
+		{
+			return { Analysis(fs), NoiseBursts(fs), Impulses(fs), LongSilence(fs) };
+		}
+	}
+}
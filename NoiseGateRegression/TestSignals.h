@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace NoiseInvader
+{
+	namespace Regression
+	{
+		struct TestSignal
+		{
+			std::string Name;
+			double Fs;
+			std::vector<float> Left;
+			std::vector<float> Right;
+			std::vector<float> Detector;
+
+			int Length() const { return (int)Left.size(); }
+		};
+
+		/// <summary>
+		/// Deterministic test signals. All generators use their own fixed-seed random source,
+		/// so the same signal is produced on every run and every platform
+		/// </summary>
+		class TestSignals
+		{
+		public:
+			// Port of the NoiseGateAnalysis signal: 300Hz sine plus noise with a slow decay, low-level noise lead-in and tail
+			static TestSignal Analysis(double fs);
+
+			// White noise bursts of varying level and length separated by near-silence, detector on the aux input
+			static TestSignal NoiseBursts(double fs);
+
+			// Single-sample impulses and short impulse trains at varying spacing and amplitude
+			static TestSignal Impulses(double fs);
+
+			// Tone bursts separated by long stretches of digital silence and -90dB noise
+			static TestSignal LongSilence(double fs);
+
+			static std::vector<TestSignal> All(double fs);
+		};
+	}
+}
@@ -5,55 +5,64 @@
 
 namespace AudioLib
 {
-	Biquad::Biquad()
+	template<typename T>
+	BiquadT<T>::BiquadT()
 	{
 		ClearBuffers();
 	}
 
-	Biquad::Biquad(FilterType filterType, int samplerate)
+	template<typename T>
+	BiquadT<T>::BiquadT(FilterType filterType, int samplerate)
 	{
 		Type = filterType;
 		SetSamplerate(samplerate);
 
 		SetGainDb(0.0);
-		Frequency = (float)(samplerate / 4.0);
+		Frequency = (T)(samplerate / 4.0);
 		SetQ(0.5);
 		ClearBuffers();
 	}
 
-	Biquad::~Biquad() 
+	template<typename T>
+	BiquadT<T>::~BiquadT() 
 	{
 
 	}
 
 
-	int Biquad::GetSamplerate() 
+	template<typename T>
+	int BiquadT<T>::GetSamplerate() 
 	{
 		return samplerate;
 	}
 
-	void Biquad::SetSamplerate(int value)
+	template<typename T>
+	void BiquadT<T>::SetSamplerate(int value)
 	{
 		samplerate = value; 
 		Update();
 	}
 
-	float Biquad::GetGainDb()
+	template<typename T>
+	T BiquadT<T>::GetGainDb()
 	{
 		return std::log10(gain) * 20;
 	}
 
-	void Biquad::SetGainDb(float value)
+	template<typename T>
+	void BiquadT<T>::SetGainDb(T value)
 	{
 		SetGain(std::pow(10.0f, value / 20.0f));
 	}
 
-	float Biquad::GetGain()
+	template<typename T>
+	T BiquadT<T>::GetGain()
 	{
 		return gain;
 	}
 
-	void Biquad::SetGain(float value)
+	template<typename T>
+	void BiquadT<T>::SetGain(T value)
 	{
 		if (value < 0.001f)
 			value = 0.001f; // -60dB
@@ -61,37 +70,42 @@ namespace AudioLib
 		gain = value;
 	}
 
-	float Biquad::GetQ()
+	template<typename T>
+	T BiquadT<T>::GetQ()
 	{
 		return _q;
 	}
 
-	void Biquad::SetQ(float value)
+	template<typename T>
+	void BiquadT<T>::SetQ(T value)
 	{
 		if (value < 0.001f)
 			value = 0.001f;
 		_q = value;
 	}
 
-	vector<float> Biquad::GetA()
+	template<typename T>
+	vector<T> BiquadT<T>::GetA()
 	{
-		return vector<float>({ 1, a1, a2 });
+		return vector<T>({ 1, a1, a2 });
 	}
 
-	vector<float> Biquad::GetB()
+	template<typename T>
+	vector<T> BiquadT<T>::GetB()
 	{
-		return vector<float>({ b0, b1, b2 });
+		return vector<T>({ b0, b1, b2 });
 	}
 
 
-	void Biquad::Update()
+	template<typename T>
+	void BiquadT<T>::Update()
 	{
-		float omega = (float)(2 * M_PI * Frequency / samplerate);
-		float sinOmega = Utils::FastSin(omega);
-		float cosOmega = Utils::FastCos(omega);
+		T omega = (T)(2 * M_PI * Frequency / samplerate);
+		T sinOmega = Utils::FastSin((float)omega);
+		T cosOmega = Utils::FastCos((float)omega);
 
-		float sqrtGain = 0.0;
-		float alpha = 0.0;
+		T sqrtGain = 0.0;
+		T alpha = 0.0;
 
 		if (Type == FilterType::LowShelf || Type == FilterType::HighShelf)
 		{
@@ -163,7 +177,7 @@ namespace AudioLib
 			break;
 		}
 
-		float g = 1 / a0;
+		T g = 1 / a0;
 
 		b0 = b0 * g;
 		b1 = b1 * g;
@@ -172,13 +186,15 @@ namespace AudioLib
 		a2 = a2 * g;
 	}
 
-	float Biquad::GetResponse(float freq) const
+	template<typename T>
+	T BiquadT<T>::GetResponse(T freq) const
 	{
 		double phi = std::pow((std::sin(2 * M_PI * freq / (2.0 * samplerate))), 2);
-		return (float)((std::pow(b0 + b1 + b2, 2.0) - 4.0 * (b0 * b1 + 4.0 * b0 * b2 + b1 * b2) * phi + 16.0 * b0 * b2 * phi * phi) / (std::pow(1.0 + a1 + a2, 2.0) - 4.0 * (a1 + 4.0 * a2 + a1 * a2) * phi + 16.0 * a2 * phi * phi));
+		return (T)((std::pow(b0 + b1 + b2, 2.0) - 4.0 * (b0 * b1 + 4.0 * b0 * b2 + b1 * b2) * phi + 16.0 * b0 * b2 * phi * phi) / (std::pow(1.0 + a1 + a2, 2.0) - 4.0 * (a1 + 4.0 * a2 + a1 * a2) * phi + 16.0 * a2 * phi * phi));
 	}
 
-	void Biquad::ClearBuffers()
+	template<typename T>
+	void BiquadT<T>::ClearBuffers()
 	{
 		y = 0;
 		x2 = 0;
@@ -187,56 +203,63 @@ namespace AudioLib
 		y1 = 0;
 	}
 
-	std::vector<float> Biquad::GetSystemResponse(const Biquad& b)
+	template<typename T>
+	std::vector<T> BiquadT<T>::GetSystemResponse(const BiquadT& b)
 	{
-		std::vector<float> output;
+		std::vector<T> output;
 		
 		for (int i = 0; i < 220; i++)
 		{
 			double f = 10 * std::pow(2, i * 0.1 * 0.5); // 10...20 Khz roughly
-			float response = b.GetResponse((float)f) * b.GetResponse((float)f);
+			T response = b.GetResponse((T)f) * b.GetResponse((T)f);
 			output.push_back(response);
 		}
 
 		return output;
 	}
 
-	std::vector<float> Biquad::GetLowpassMagnitude(float cutoff, float resonance)
+	template<typename T>
+	std::vector<T> BiquadT<T>::GetLowpassMagnitude(T cutoff, T resonance)
 	{
-		Biquad b;
-		std::vector<float> output;
+		BiquadT b;
+		std::vector<T> output;
 		b.Type = FilterType::LowPass;
 		b.SetSamplerate(96000);
 		b.Frequency = cutoff;
-		float d = (1.0f - (resonance * 0.999f)) * 2.0f;
+		T d = (1.0f - (resonance * 0.999f)) * 2.0f;
 		b.SetQ(1.0f / d);
 		b.Update();
 		return GetSystemResponse(b);
 	}
 
-	std::vector<float> Biquad::GetBandpassMagnitude(float cutoff, float resonance)
+	template<typename T>
+	std::vector<T> BiquadT<T>::GetBandpassMagnitude(T cutoff, T resonance)
 	{
-		Biquad b;
-		std::vector<float> output;
+		BiquadT b;
+		std::vector<T> output;
 		b.Type = FilterType::BandPass;
 		b.SetSamplerate(96000);
 		b.Frequency = cutoff;
-		float d = (1.0f - (resonance * 0.999f)) * 2.0f;
+		T d = (1.0f - (resonance * 0.999f)) * 2.0f;
 		b.SetQ(1.0f / d);
 		b.Update();
 		return GetSystemResponse(b);
 	}
 
-	std::vector<float> Biquad::GetHighpassMagnitude(float cutoff, float resonance)
+	template<typename T>
+	std::vector<T> BiquadT<T>::GetHighpassMagnitude(T cutoff, T resonance)
 	{
-		Biquad b;
-		std::vector<float> output;
+		BiquadT b;
+		std::vector<T> output;
 		b.Type = FilterType::HighPass;
 		b.SetSamplerate(96000);
 		b.Frequency = cutoff;
-		float d = (1.0f - (resonance * 0.999f)) * 2.0f;
+		T d = (1.0f - (resonance * 0.999f)) * 2.0f;
 		b.SetQ(1.0f / d);
 		b.Update();
 		return GetSystemResponse(b);
 	}
-}
\ No newline at end of file
+
+	template class BiquadT<float>;
+	template class BiquadT<double>;
+}
@@ -2,11 +2,17 @@
 #define BIQUAD
 
 #include <vector>
+#include "Sos.h"
 using namespace std;
 
 namespace AudioLib
 {
-	class Biquad
+	/// <summary>
+	/// Biquad filter over sample type T. Explicitly instantiated for float and double in Biquad.cpp.
+	/// Both versions design their coefficients with the Utils sine table, so they implement the same filter
+	/// </summary>
+	template<typename T>
+	class BiquadT
 	{
 	public:
 		enum class FilterType
@@ -22,37 +28,49 @@ namespace AudioLib
 
 	private:
 		int samplerate;
-		float _gainDb;
-		float _q;
-		float a0, a1, a2, b0, b1, b2;
-		float x1, x2, y, y1, y2;
-		float gain;
+		T _gainDb;
+		T _q;
+		T a0, a1, a2, b0, b1, b2;
+		T x1, x2, y, y1, y2;
+		T gain;
 
 	public:
+		// The filter memory, plain data so it can be part of a snapshot of the processor using the filter
+		struct State
+		{
+			T X1, X2, Y1, Y2;
+		};
+
 		FilterType Type;
-		float Output;
-		float Frequency;
-		float Slope;
+		T Output;
+		T Frequency;
+		T Slope;
 
-		Biquad();
-		Biquad(FilterType filterType, int samplerate);
-		~Biquad();
+		BiquadT();
+		BiquadT(FilterType filterType, int samplerate);
+		~BiquadT();
 
 		int GetSamplerate();
 		void SetSamplerate(int samplerate);
-		float GetGainDb();
-		void SetGainDb(float value);
-		float GetGain();
-		void SetGain(float value);
-		float GetQ();
-		void SetQ(float value);
-		vector<float> GetA();
-		vector<float> GetB();
+		T GetGainDb();
+		void SetGainDb(T value);
+		T GetGain();
+		void SetGain(T value);
+		T GetQ();
+		void SetQ(T value);
+		vector<T> GetA();
+		vector<T> GetB();
+
+		// The normalised coefficients, for the transposed direct form II filters and banks. Doesn't allocate
+		inline SosCoefficients<T> GetCoefficients() const
+		{
+			return { b0, b1, b2, a1, a2 };
+		}
 
 		void Update();
-		float GetResponse(float freq) const;
+		T GetResponse(T freq) const;
 		
-		float inline Process(float x)
+		T inline Process(T x)
 		{
 			y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
 			x2 = x1;
@@ -64,11 +82,11 @@ namespace AudioLib
 			return Output;
 		}
 
-		void inline Process(float* input, float* output, int len)
+		void inline Process(T* input, T* output, int len)
 		{
 			for (int i = 0; i < len; i++)
 			{
-				float x = input[i];
+				T x = input[i];
 				y = ((b0 * x) + (b1 * x1) + (b2 * x2)) - (a1 * y1) - (a2 * y2);
 				x2 = x1;
 				y2 = y1;
@@ -83,13 +101,37 @@ namespace AudioLib
 
 		void ClearBuffers();
 
-		static std::vector<float> GetLowpassMagnitude(float cutoff, float resonance);
-		static std::vector<float> GetBandpassMagnitude(float cutoff, float resonance);
-		static std::vector<float> GetHighpassMagnitude(float cutoff, float resonance);
+		inline void GetState(State& state) const
+		{
+			state.X1 = x1;
+			state.X2 = x2;
+			state.Y1 = y1;
+			state.Y2 = y2;
+		}
+
+		// Coefficients are not part of the state and stay as they are
+		inline void SetState(const State& state)
+		{
+			x1 = state.X1;
+			x2 = state.X2;
+			y1 = state.Y1;
+			y2 = state.Y2;
+			y = y1;
+			Output = y1;
+		}
+
+		static std::vector<T> GetLowpassMagnitude(T cutoff, T resonance);
+		static std::vector<T> GetBandpassMagnitude(T cutoff, T resonance);
+		static std::vector<T> GetHighpassMagnitude(T cutoff, T resonance);
 
 	private:
-		static std::vector<float> GetSystemResponse(const Biquad& biquad);
+		static std::vector<T> GetSystemResponse(const BiquadT& biquad);
 	};
+
+	extern template class BiquadT<float>;
+	extern template class BiquadT<double>;
+
+	typedef BiquadT<float> Biquad;
 }
 
 #endif
\ No newline at end of file
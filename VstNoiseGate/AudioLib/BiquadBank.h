@@ -0,0 +1,247 @@
+#ifndef AUDIOLIB_BIQUADBANK
+#define AUDIOLIB_BIQUADBANK
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#include "Sos.h"
+
+namespace AudioLib
+{
+	enum class BiquadForm
+	{
+		// x1, x2, y1, y2 history, the same arithmetic as BiquadT
+		DirectForm1 = 0,
+		// s1 split into its feedforward part and the last output, and s2, see Tdf2BiquadT
+		TransposedDirectForm2
+	};
+
+	/// <summary>
+	/// Lanes independent biquads, one per channel or per gate instance, processed in lockstep with SSE2.
+	/// Samples are float, TAcc is float (four lanes per register) or double (two lanes per register, the
+	/// samples are widened on load and narrowed on store). Every lane has its own coefficients and state, stored
+	/// as structure-of-arrays. The recurrences are latency bound, so up to four registers of lanes are run
+	/// side by side and the bank costs little more per sample than a single biquad.
+	/// The DirectForm1 bank with float accumulation does the same operations in the same order as BiquadT,
+	/// so each lane is bit-exact with a scalar filter
+	/// </summary>
+	template<int Lanes, typename TAcc = float, BiquadForm Form = BiquadForm::TransposedDirectForm2>
+	class BiquadBankT
+	{
+		static_assert(Lanes > 0 && Lanes % 4 == 0, "BiquadBank needs a multiple of four lanes");
+
+	public:
+		// The planar Process() interleaves the channels in chunks of this many samples
+		static const int BlockSize = 64;
+
+		/// <summary>
+		/// The memory of every lane, plain data for snapshots. DirectForm1 uses all four rows as x1, x2, y1, y2,
+		/// TransposedDirectForm2 the first three as s1, s2, y1
+		/// </summary>
+		struct State
+		{
+			TAcc Z[4][Lanes];
+		};
+
+	private:
+		// Lane arithmetic on one SSE2 register of TAcc values
+		template<typename TReg, int Dummy = 0>
+		struct Ops;
+
+		template<int Dummy>
+		struct Ops<float, Dummy>
+		{
+			typedef __m128 V;
+			static const int Width = 4;
+			static inline V Load(const float* p) { return _mm_load_ps(p); }
+			static inline void Store(float* p, V v) { _mm_store_ps(p, v); }
+			static inline V LoadSamples(const float* p) { return _mm_loadu_ps(p); }
+			static inline void StoreSamples(float* p, V v) { _mm_storeu_ps(p, v); }
+			static inline V Add(V a, V b) { return _mm_add_ps(a, b); }
+			static inline V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+			static inline V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+		};
+
+		template<int Dummy>
+		struct Ops<double, Dummy>
+		{
+			typedef __m128d V;
+			static const int Width = 2;
+			static inline V Load(const double* p) { return _mm_load_pd(p); }
+			static inline void Store(double* p, V v) { _mm_store_pd(p, v); }
+			static inline V LoadSamples(const float* p) { return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)p))); }
+			static inline void StoreSamples(float* p, V v) { _mm_storel_pi((__m64*)p, _mm_cvtpd_ps(v)); }
+			static inline V Add(V a, V b) { return _mm_add_pd(a, b); }
+			static inline V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+			static inline V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+		};
+
+		typedef Ops<TAcc> Op;
+		typedef typename Op::V V;
+
+		static const int Registers = Lanes / Op::Width;
+		// registers processed side by side, enough independent chains to hide the latency without running out of registers
+		static const int Chunk = Registers < 4 ? Registers : 4;
+
+		alignas(64) TAcc b0[Lanes];
+		alignas(64) TAcc b1[Lanes];
+		alignas(64) TAcc b2[Lanes];
+		alignas(64) TAcc a1[Lanes];
+		alignas(64) TAcc a2[Lanes];
+		alignas(64) TAcc z[4][Lanes];
+
+		// interleave buffer of the planar Process(), sample major
+		alignas(64) float scratch[BlockSize * Lanes];
+
+	public:
+		BiquadBankT()
+		{
+			SetCoefficients(SosCoefficients<TAcc>::Identity());
+			ClearBuffers();
+		}
+
+		// Sets the coefficients of one lane and keeps its state
+		template<typename TCoeff>
+		void SetCoefficients(int lane, const SosCoefficients<TCoeff>& c)
+		{
+			b0[lane] = (TAcc)c.B0;
+			b1[lane] = (TAcc)c.B1;
+			b2[lane] = (TAcc)c.B2;
+			a1[lane] = (TAcc)c.A1;
+			a2[lane] = (TAcc)c.A2;
+		}
+
+		// Sets the same coefficients for every lane
+		template<typename TCoeff>
+		void SetCoefficients(const SosCoefficients<TCoeff>& c)
+		{
+			for (int l = 0; l < Lanes; l++)
+				SetCoefficients(l, c);
+		}
+
+		void ClearBuffers()
+		{
+			for (int k = 0; k < 4; k++)
+				for (int l = 0; l < Lanes; l++)
+					z[k][l] = 0;
+		}
+
+		void GetState(State& state) const
+		{
+			for (int k = 0; k < 4; k++)
+				for (int l = 0; l < Lanes; l++)
+					state.Z[k][l] = z[k][l];
+		}
+
+		// Coefficients are not part of the state and stay as they are
+		void SetState(const State& state)
+		{
+			for (int k = 0; k < 4; k++)
+				for (int l = 0; l < Lanes; l++)
+					z[k][l] = state.Z[k][l];
+		}
+
+		/// <summary>
+		/// Processes len samples of interleaved data, sample major: input[i * Lanes + lane].
+		/// input and output may be the same buffer
+		/// </summary>
+		void Process(const float* input, float* output, int len)
+		{
+			for (int r = 0; r < Registers; r += Chunk)
+				ProcessChunk(r * Op::Width, input, output, len);
+		}
+
+		/// <summary>
+		/// Processes len samples of every lane, input[lane] and output[lane] point to the signal of each lane.
+		/// The lanes are interleaved through a scratch buffer, a block at a time
+		/// </summary>
+		void Process(const float* const* input, float* const* output, int len)
+		{
+			for (int pos = 0; pos < len; pos += BlockSize)
+			{
+				int count = len - pos < BlockSize ? len - pos : BlockSize;
+
+				for (int l = 0; l < Lanes; l++)
+				{
+					auto src = &input[l][pos];
+					for (int i = 0; i < count; i++)
+						scratch[i * Lanes + l] = src[i];
+				}
+
+				Process(scratch, scratch, count);
+
+				for (int l = 0; l < Lanes; l++)
+				{
+					auto dst = &output[l][pos];
+					for (int i = 0; i < count; i++)
+						dst[i] = scratch[i * Lanes + l];
+				}
+			}
+		}
+
+	private:
+		// Runs Chunk registers of lanes, starting at lane first, over the whole block with the state in registers
+		void ProcessChunk(int first, const float* input, float* output, int len)
+		{
+			V cb0[Chunk], cb1[Chunk], cb2[Chunk], ca1[Chunk], ca2[Chunk];
+			V s[4][Chunk];
+
+			for (int j = 0; j < Chunk; j++)
+			{
+				int l = first + j * Op::Width;
+				cb0[j] = Op::Load(&b0[l]);
+				cb1[j] = Op::Load(&b1[l]);
+				cb2[j] = Op::Load(&b2[l]);
+				ca1[j] = Op::Load(&a1[l]);
+				ca2[j] = Op::Load(&a2[l]);
+				for (int k = 0; k < 4; k++)
+					s[k][j] = Op::Load(&z[k][l]);
+			}
+
+			for (int i = 0; i < len; i++)
+			{
+				for (int j = 0; j < Chunk; j++)
+				{
+					int k = i * Lanes + first + j * Op::Width;
+					V x = Op::LoadSamples(&input[k]);
+					V y;
+
+					if (Form == BiquadForm::DirectForm1)
+					{
+						y = Op::Add(Op::Add(Op::Mul(cb0[j], x), Op::Mul(cb1[j], s[0][j])), Op::Mul(cb2[j], s[1][j]));
+						y = Op::Sub(Op::Sub(y, Op::Mul(ca1[j], s[2][j])), Op::Mul(ca2[j], s[3][j]));
+						s[1][j] = s[0][j];
+						s[3][j] = s[2][j];
+						s[0][j] = x;
+						s[2][j] = y;
+					}
+					else
+					{
+						y = Op::Sub(Op::Add(Op::Mul(cb0[j], x), s[0][j]), Op::Mul(ca1[j], s[2][j]));
+						s[0][j] = Op::Add(Op::Mul(cb1[j], x), s[1][j]);
+						s[1][j] = Op::Sub(Op::Mul(cb2[j], x), Op::Mul(ca2[j], y));
+						s[2][j] = y;
+					}
+
+					Op::StoreSamples(&output[k], y);
+				}
+			}
+
+			for (int j = 0; j < Chunk; j++)
+			{
+				int l = first + j * Op::Width;
+				for (int k = 0; k < 4; k++)
+					Op::Store(&z[k][l], s[k][j]);
+			}
+		}
+	};
+
+	typedef BiquadBankT<4> BiquadBank4;
+	typedef BiquadBankT<8> BiquadBank8;
+	typedef BiquadBankT<16> BiquadBank16;
+}
+
+#endif
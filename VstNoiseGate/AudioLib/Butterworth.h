@@ -1,76 +1,172 @@
-#pragma once
+#ifndef AUDIOLIB_BUTTERWORTH
+#define AUDIOLIB_BUTTERWORTH
 
-#include "Transfer.h"
 #include "MathDefs.h"
+#include "Sos.h"
 #include <cmath>
 
-// TODO: Port Bilinear code to C++
-/*
 namespace AudioLib
 {
-	class Butterworth : Transfer
+	/// <summary>
+	/// Butterworth lowpass and highpass designer, orders 1 to 8, by the bilinear transform with the cutoff prewarped.
+	/// The filter is designed directly as second order sections, one per conjugate pole pair of the analog prototype
+	/// plus a first order section for odd orders, instead of expanding and transforming one polynomial, which loses
+	/// precision at high orders and low cutoffs. The sections are ordered from the lowest to the highest Q, so the
+	/// resonant sections come last, and are meant for Tdf2BiquadT, SosCascadeT or a BiquadBank.
+	/// Everything is held by value, Update() doesn't allocate
+	/// </summary>
+	class Butterworth
 	{
 	public:
-		
+		enum class FilterType
+		{
+			LowPass = 0,
+			HighPass
+		};
+
+		static const int MaxOrder = 8;
+		static const int MaxSections = (MaxOrder + 1) / 2;
+
 		double Fs;
 		double CutoffHz;
 		int Order;
+		FilterType Type;
 
+	private:
+		SosCoefficients<double> sections[MaxSections];
+		int sectionCount;
+		int designOrder;
+
+	public:
 		Butterworth(double fs)
-		{ 
-			this->Fs = fs;
+		{
+			Fs = fs;
+			CutoffHz = fs / 4;
+			Order = 2;
+			Type = FilterType::LowPass;
+			Update();
 		}
 
+		// Order is clamped to 1...MaxOrder, the cutoff to 10Hz below Nyquist
 		void Update()
 		{
-			auto T = 1.0 / Fs;
-			auto warpedWc = 2 / T * std::tan(CutoffHz * 2 * M_PI * T / 2);
+			int order = Order < 1 ? 1 : Order > MaxOrder ? MaxOrder : Order;
+			double cutoff = CutoffHz;
 
 			// don't go over nyquist, with 10 hz safety buffer
-			if (warpedWc >= Fs / 2 * 2 * M_PI)
-				warpedWc = (Fs - 10) / 2 * 2 * M_PI;
-
-			double[] sb = { 1 };
-			double[] sa = null;
-			Func<double, double> ScaleFreq = (power) = > Math.Pow(1.0 / warpedWc, power);
+			if (cutoff > Fs / 2 - 10)
+				cutoff = Fs / 2 - 10;
 
-			var order = (int)Math.Round(Parameters[P_ORDER]);
+			// prewarped analog cutoff, normalised by 2 * Fs: s = (1 - z^-1) / (1 + z^-1) / k
+			double k = std::tan(M_PI * cutoff / Fs);
+			bool highpass = Type == FilterType::HighPass;
+			designOrder = order;
+			sectionCount = 0;
 
-			if (order == 1)
-			{
-				sa = new [] { 1.0, ScaleFreq(1) };
-			}
-			else if (order == 2)
+			if (order % 2 == 1)
 			{
-				sa = new[] { 1.0, 1.4142 * ScaleFreq(1), 1 * ScaleFreq(2) };
+				// the real pole at s = -1
+				double norm = 1 / (1 + k);
+				auto& s = sections[sectionCount++];
+				s.B0 = highpass ? norm : k * norm;
+				s.B1 = highpass ? -norm : k * norm;
+				s.B2 = 0;
+				s.A1 = (k - 1) * norm;
+				s.A2 = 0;
 			}
-			else if (order == 3)
-			{
-				sa = new[] { 1, 2 * ScaleFreq(1), 2 * ScaleFreq(2), 1 * ScaleFreq(3) };
-			}
-			else if (order == 4)
-			{
-				sa = new[] { 1, 2.613 * ScaleFreq(1), 3.414 * ScaleFreq(2), 2.613 * ScaleFreq(3), 1 * ScaleFreq(4) };
-			}
-			else if (order == 5)
-			{
-				sa = new[] { 1, 3.236 * ScaleFreq(1), 5.236 * ScaleFreq(2), 5.236 * ScaleFreq(3), 3.236 * ScaleFreq(4), 1 * ScaleFreq(5) };
-			}
-			else if (order == 6)
+
+			// Pole pair p of the prototype is s^2 + 2 sin(theta) s + 1, theta = (2p + 1) pi / (2 order).
+			// The largest damping, the lowest Q, comes first
+			for (int p = order / 2 - 1; p >= 0; p--)
 			{
-				sa = new[] { 1, 3.864 * ScaleFreq(1), 7.464 * ScaleFreq(2), 9.142 * ScaleFreq(3), 7.464 * ScaleFreq(4), 3.864 * ScaleFreq(5), 1 * ScaleFreq(6) };
+				double damping = 2 * std::sin((2 * p + 1) * M_PI / (2 * order));
+				double norm = 1 / (1 + damping * k + k * k);
+				auto& s = sections[sectionCount++];
+				s.B0 = highpass ? norm : k * k * norm;
+				s.B1 = highpass ? -2 * norm : 2 * k * k * norm;
+				s.B2 = s.B0;
+				s.A1 = 2 * (k * k - 1) * norm;
+				s.A2 = (1 - damping * k + k * k) * norm;
 			}
-			else
+		}
+
+		int GetSectionCount() const
+		{
+			return sectionCount;
+		}
+
+		const SosCoefficients<double>* GetSections() const
+		{
+			return sections;
+		}
+
+		/// <summary>
+		/// Expands the sections into one numerator and one denominator polynomial of GetOrder() + 1 coefficients each,
+		/// highest power of z^-1 last, for a TransferT or Transfer filter. Fine for low orders; the sections keep
+		/// their precision better at high orders and low cutoffs
+		/// </summary>
+		void GetTransfer(double* b, double* a) const
+		{
+			int order = 0;
+			b[0] = 1;
+			a[0] = 1;
+
+			for (int i = 0; i < sectionCount; i++)
 			{
-				throw new Exception("Orders higher than 6 are not supported");
+				auto& s = sections[i];
+				int sectionOrder = s.A2 == 0 && s.B2 == 0 ? 1 : 2;
+				double sb[3] = { s.B0, s.B1, s.B2 };
+				double sa[3] = { 1, s.A1, s.A2 };
+
+				// multiply in place, from the highest power down so every term is read before it is overwritten
+				for (int k = order + sectionOrder; k >= 0; k--)
+				{
+					double nb = 0, na = 0;
+					for (int j = 0; j <= sectionOrder; j++)
+					{
+						if (k - j >= 0 && k - j <= order)
+						{
+							nb += sb[j] * b[k - j];
+							na += sa[j] * a[k - j];
+						}
+					}
+					b[k] = nb;
+					a[k] = na;
+				}
+
+				order += sectionOrder;
 			}
+		}
 
-			double[] zb, za;
+		// The order of the current design, Order as clamped by the last Update()
+		int GetOrder() const
+		{
+			return designOrder;
+		}
 
-			Bilinear.Transform(sb, sa, out zb, out za, this.Fs);
+		/// <summary>
+		/// Magnitude response at the given frequency, the product of the magnitudes of all sections
+		/// </summary>
+		double GetResponse(double freq) const
+		{
+			double w = 2 * M_PI * freq / Fs;
+			double c1 = std::cos(w), s1 = std::sin(w);
+			double c2 = std::cos(2 * w), s2 = std::sin(2 * w);
+			double magnitude = 1;
 
-			this.B = zb;
-			this.A = za;
+			for (int i = 0; i < sectionCount; i++)
+			{
+				auto& s = sections[i];
+				double bRe = s.B0 + s.B1 * c1 + s.B2 * c2;
+				double bIm = -(s.B1 * s1 + s.B2 * s2);
+				double aRe = 1 + s.A1 * c1 + s.A2 * c2;
+				double aIm = -(s.A1 * s1 + s.A2 * s2);
+				magnitude *= std::sqrt((bRe * bRe + bIm * bIm) / (aRe * aRe + aIm * aIm));
+			}
+
+			return magnitude;
 		}
 	};
-}*/
\ No newline at end of file
+}
+
+#endif
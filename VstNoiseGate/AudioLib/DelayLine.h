@@ -0,0 +1,97 @@
+#ifndef AUDIOLIB_DELAYLINE
+#define AUDIOLIB_DELAYLINE
+
+namespace AudioLib
+{
+	/// <summary>
+	/// Fixed capacity delay line. The ring buffer is part of the object and sized for MaxDelay samples,
+	/// so changing the delay (or the samplerate it was computed from) never allocates.
+	/// Changing the delay at runtime jumps to the new read position, the history is kept
+	/// </summary>
+	class DelayLine
+	{
+	public:
+		// Power of two, enough for 10ms at 384kHz
+		static const int MaxDelay = 4096;
+
+		/// <summary>
+		/// The most recent Length input samples, oldest first. Plain data for snapshots; only the first Length entries are used
+		/// </summary>
+		struct State
+		{
+			int Length;
+			float History[MaxDelay];
+		};
+
+	private:
+		static const int Mask = MaxDelay - 1;
+
+		float buffer[MaxDelay];
+		int writePos;
+		int delay;
+
+	public:
+		DelayLine()
+		{
+			delay = 0;
+			Reset();
+		}
+
+		inline void Reset()
+		{
+			for (int i = 0; i < MaxDelay; i++)
+				buffer[i] = 0;
+
+			writePos = 0;
+		}
+
+		// Clamped to 0...MaxDelay - 1
+		inline void SetDelay(int samples)
+		{
+			delay = samples < 0 ? 0 : samples > MaxDelay - 1 ? MaxDelay - 1 : samples;
+		}
+
+		inline int GetDelay() const
+		{
+			return delay;
+		}
+
+		/// <summary>
+		/// Takes the last length samples, clamped to MaxDelay - 1. Later delays up to length read the same values as here
+		/// </summary>
+		inline void GetState(State& state, int length) const
+		{
+			length = length < 0 ? 0 : length > MaxDelay - 1 ? MaxDelay - 1 : length;
+			state.Length = length;
+			for (int i = 0; i < length; i++)
+				state.History[i] = buffer[(writePos - length + i) & Mask];
+		}
+
+		/// <summary>
+		/// Continues from the state. The history older than state.Length is left as it is, so the delay must not be
+		/// set longer than that until as many samples have been processed again
+		/// </summary>
+		inline void SetState(const State& state)
+		{
+			int length = state.Length < 0 ? 0 : state.Length > MaxDelay - 1 ? MaxDelay - 1 : state.Length;
+			for (int i = 0; i < length; i++)
+				buffer[i] = state.History[i];
+			writePos = length & Mask;
+		}
+
+		// input and output may be the same buffer
+		inline void Process(const float* input, float* output, int len)
+		{
+			int w = writePos;
+			for (int i = 0; i < len; i++)
+			{
+				buffer[w] = input[i];
+				output[i] = buffer[(w - delay) & Mask];
+				w = (w + 1) & Mask;
+			}
+			writePos = w;
+		}
+	};
+}
+
+#endif
@@ -1,6 +1,9 @@
 
 
 // shitty _USE_MATH_DEFINES is impossible to track!
+// (glibc defines these unconditionally, so only fill in what's missing)
+
+#ifndef M_PI
 
 #define M_E        2.71828182845904523536   // e
 #define M_LOG2E    1.44269504088896340736   // log2(e)
@@ -15,3 +18,5 @@
 #define M_2_SQRTPI 1.12837916709551257390   // 2/sqrt(pi)
 #define M_SQRT2    1.41421356237309504880   // sqrt(2)
 #define M_SQRT1_2  0.707106781186547524401  // 1/sqrt(2)
+
+#endif
@@ -6,57 +6,103 @@
 
 namespace AudioLib
 {
-	class Lp1
+	// One pole lowpass, T is the sample type (float or double)
+	template<typename T>
+	class Lp1T
 	{
 	private:
-		float z1_state;
+		T z1_state;
 		//float g;
-		float g2;
+		T g2;
 	public:
-		inline float Process(float x)
+		Lp1T() : z1_state(0), g2(0) { }
+
+		inline T Process(T x)
 		{
 			// perform one sample tick of the lowpass filter
 			//float v = (x - z1_state) * g / (1 + g);
-			float v = (x - z1_state) * g2;
-			float y = v + z1_state;
+			T v = (x - z1_state) * g2;
+			T y = v + z1_state;
 			z1_state = y + v;
 			return y;
 		}
 
+		inline void Process(const T* input, T* output, int len)
+		{
+			T z = z1_state;
+			for (int i = 0; i < len; i++)
+			{
+				T v = (input[i] - z) * g2;
+				T y = v + z;
+				z = y + v;
+				output[i] = y;
+			}
+			z1_state = z;
+		}
+
+		// The filter memory, for snapshots of the processor it is part of
+		inline T GetState() const { return z1_state; }
+		inline void SetState(T state) { z1_state = state; }
+
 		// 0...1
-		inline void SetFc(float fcRel)
+		inline void SetFc(T fcRel)
 		{
 			//this->g = fcRel * M_PI;
-			float g = (float)(fcRel * M_PI);
+			T g = (T)(fcRel * M_PI);
 			g2 = g / (1 + g);
 		}
 	};
 
-	class Hp1
+	// One pole highpass, T is the sample type (float or double)
+	template<typename T>
+	class Hp1T
 	{
 	private:
-		float z1_state;
+		T z1_state;
 		//float g;
-		float g2;
+		T g2;
 	public:
-		inline float Process(float x)
+		Hp1T() : z1_state(0), g2(0) { }
+
+		inline T Process(T x)
 		{
 			// perform one sample tick of the lowpass filter
 			//float v = (x - z1_state) * g / (1 + g);
-			float v = (x - z1_state) * g2;
-			float y = v + z1_state;
+			T v = (x - z1_state) * g2;
+			T y = v + z1_state;
 			z1_state = y + v;
 			return x - y;
 		}
 
+		inline void Process(const T* input, T* output, int len)
+		{
+			T z = z1_state;
+			for (int i = 0; i < len; i++)
+			{
+				T x = input[i];
+				T v = (x - z) * g2;
+				T y = v + z;
+				z = y + v;
+				output[i] = x - y;
+			}
+			z1_state = z;
+		}
+
+		// The filter memory, for snapshots of the processor it is part of
+		inline T GetState() const { return z1_state; }
+		inline void SetState(T state) { z1_state = state; }
+
 		// 0...1
-		inline void SetFc(float fcRel)
+		inline void SetFc(T fcRel)
 		{
 			//this->g = fcRel * M_PI;
-			float g = (float)(fcRel * M_PI);
+			T g = (T)(fcRel * M_PI);
 			g2 = g / (1 + g);
 		}
 	};
+
+	typedef Lp1T<float> Lp1;
+	typedef Hp1T<float> Hp1;
 }
 
 #endif
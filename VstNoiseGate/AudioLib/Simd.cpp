@@ -0,0 +1,195 @@
+#include <atomic>
+
+#include "SimdKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define AUDIOLIB_SIMD_X86
+#include <xmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace AudioLib
+{
+	namespace
+	{
+#ifdef AUDIOLIB_SIMD_X86
+
+		// eax, ebx, ecx, edx of cpuid
+		void Cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+		{
+#ifdef _MSC_VER
+			int r[4];
+			__cpuidex(r, (int)leaf, (int)subleaf);
+			for (int i = 0; i < 4; i++)
+				regs[i] = (unsigned int)r[i];
+#else
+			__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+		}
+
+		// The register state the OS saves on a context switch, only valid when cpuid reports OSXSAVE
+		unsigned long long GetXcr0()
+		{
+#ifdef _MSC_VER
+			return _xgetbv(0);
+#else
+			unsigned int low, high;
+			__asm__ __volatile__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+			return ((unsigned long long)high << 32) | low;
+#endif
+		}
+
+#endif
+
+		SimdLevel DetectLevel()
+		{
+			SimdLevel level = SimdLevel::Scalar;
+
+#ifdef AUDIOLIB_SIMD_X86
+			unsigned int regs[4];
+			Cpuid(0, 0, regs);
+			unsigned int maxLeaf = regs[0];
+
+			Cpuid(1, 0, regs);
+			bool sse2 = (regs[3] & (1u << 26)) != 0;
+			bool fma = (regs[2] & (1u << 12)) != 0;
+			bool osxsave = (regs[2] & (1u << 27)) != 0;
+			bool avx = (regs[2] & (1u << 28)) != 0;
+
+			if (sse2 && GetSse2Kernels() != nullptr)
+				level = SimdLevel::Sse2;
+
+			if (level == SimdLevel::Sse2 && maxLeaf >= 7 && fma && osxsave && avx)
+			{
+				// the OS must save the ymm registers, and for AVX-512 the opmask and zmm registers as well
+				unsigned long long xcr0 = GetXcr0();
+				bool ymmState = (xcr0 & 0x06) == 0x06;
+				bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+				Cpuid(7, 0, regs);
+				bool avx2 = (regs[1] & (1u << 5)) != 0;
+				bool avx512f = (regs[1] & (1u << 16)) != 0;
+
+				if (ymmState && avx2 && GetAvx2Kernels() != nullptr)
+					level = SimdLevel::Avx2;
+				if (level == SimdLevel::Avx2 && zmmState && avx512f && GetAvx512Kernels() != nullptr)
+					level = SimdLevel::Avx512;
+			}
+#endif
+
+			return level;
+		}
+
+		const SimdKernels* GetKernelsOf(SimdLevel level)
+		{
+			switch (level)
+			{
+			case SimdLevel::Avx512: return GetAvx512Kernels();
+			case SimdLevel::Avx2: return GetAvx2Kernels();
+			case SimdLevel::Sse2: return GetSse2Kernels();
+			default: return GetScalarKernels();
+			}
+		}
+
+		std::atomic<const SimdKernels*> current(nullptr);
+	}
+
+	const SimdKernels* GetScalarKernels()
+	{
+		static const SimdKernels kernels = MakeKernels<ScalarOps>(SimdLevel::Scalar);
+		return &kernels;
+	}
+
+	const SimdKernels* GetSse2Kernels()
+	{
+#ifdef AUDIOLIB_SIMD_SSE2
+		static const SimdKernels kernels = MakeKernels<Sse2Ops>(SimdLevel::Sse2);
+		return &kernels;
+#else
+		return nullptr;
+#endif
+	}
+
+	SimdLevel Simd::GetSupportedLevel()
+	{
+		static const SimdLevel level = DetectLevel();
+		return level;
+	}
+
+	SimdLevel Simd::GetLevel()
+	{
+		return GetKernels().Level;
+	}
+
+	SimdLevel Simd::SetLevel(SimdLevel level)
+	{
+		if ((int)level > (int)GetSupportedLevel())
+			level = GetSupportedLevel();
+
+		current.store(GetKernelsOf(level), std::memory_order_release);
+		return level;
+	}
+
+	const char* Simd::GetName(SimdLevel level)
+	{
+		switch (level)
+		{
+		case SimdLevel::Avx512: return "AVX-512";
+		case SimdLevel::Avx2: return "AVX2";
+		case SimdLevel::Sse2: return "SSE2";
+		default: return "Scalar";
+		}
+	}
+
+	const SimdKernels& Simd::GetKernels()
+	{
+		const SimdKernels* kernels = current.load(std::memory_order_acquire);
+		if (kernels == nullptr)
+		{
+			// first use, any thread racing here stores the same table
+			kernels = GetKernelsOf(GetSupportedLevel());
+			const SimdKernels* expected = nullptr;
+			if (!current.compare_exchange_strong(expected, kernels, std::memory_order_acq_rel))
+				kernels = expected;
+		}
+
+		return *kernels;
+	}
+
+	void Simd::Min(float* buffer, float value, int len)
+	{
+		GetKernels().Min(buffer, value, len);
+	}
+
+	void Simd::Max(float* buffer, float value, int len)
+	{
+		GetKernels().Max(buffer, value, len);
+	}
+
+	void Simd::Floor(float* buffer, int len)
+	{
+		GetKernels().Floor(buffer, len);
+	}
+
+	void Simd::ConvertToFloats(const int* input, float* output, int len)
+	{
+		GetKernels().ConvertToFloats(input, output, len);
+	}
+
+	void Simd::PreventDenormals()
+	{
+#if defined(AUDIOLIB_SIMD_X86)
+		// flush to zero and denormals are zero, the same bits as _MM_SET_FLUSH_ZERO_MODE / _MM_SET_DENORMALS_ZERO_MODE
+		_mm_setcsr(_mm_getcsr() | 0x8040);
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+		// FZ bit of the floating point control register
+		unsigned long long fpcr;
+		__asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+		__asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr | (1ull << 24)));
+#endif
+	}
+}
@@ -0,0 +1,93 @@
+#ifndef AUDIOLIB_SIMD
+#define AUDIOLIB_SIMD
+
+#include <cstdlib>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace AudioLib
+{
+	// Instruction sets the array kernels are built for, from narrowest to widest
+	enum class SimdLevel
+	{
+		Scalar = 0,
+		Sse2,
+		Avx2,    // with FMA
+		Avx512,  // AVX-512F
+	};
+
+	// The kernels of one level, see SimdKernels.h
+	struct SimdKernels;
+
+	/// <summary>
+	/// Portable vector support. The array functions here and the fast modes of VectorMath run on the widest
+	/// instruction set both the CPU and this build support, detected once on first use; a kernel constructor
+	/// triggers that, so it never happens on the audio thread. One binary therefore uses AVX-512 or AVX2 where it
+	/// can and falls back to SSE2, or to plain C++ on other architectures. Every function takes any length, the
+	/// tail that doesn't fill a vector is done one element at a time
+	/// </summary>
+	class Simd
+	{
+	public:
+		// Alignment of AlignedMalloc, a cache line and one AVX-512 register
+		static const int Alignment = 64;
+
+		// Widest level the CPU, the OS and this build support
+		static SimdLevel GetSupportedLevel();
+
+		// Level in use, GetSupportedLevel() unless changed with SetLevel
+		static SimdLevel GetLevel();
+
+		/// <summary>
+		/// Switches every kernel to the given level, clamped to GetSupportedLevel(), and returns the level set.
+		/// For tests and benchmarks that compare the levels; calls already running finish on the old level
+		/// </summary>
+		static SimdLevel SetLevel(SimdLevel level);
+
+		static const char* GetName(SimdLevel level);
+
+		// The kernels of the level in use
+		static const SimdKernels& GetKernels();
+
+		// buffer[i] = min(buffer[i], value)
+		static void Min(float* buffer, float value, int len);
+
+		// buffer[i] = max(buffer[i], value)
+		static void Max(float* buffer, float value, int len);
+
+		static void Floor(float* buffer, int len);
+
+		static void ConvertToFloats(const int* input, float* output, int len);
+
+		// Returns an array of count T aligned to Alignment, nullptr if it can't be allocated. Free with AlignedFree
+		template<typename T>
+		static inline T* AlignedMalloc(int count)
+		{
+#ifdef _MSC_VER
+			return (T*)_aligned_malloc(count * sizeof(T), Alignment);
+#else
+			void* mem = nullptr;
+			if (posix_memalign(&mem, Alignment, count * sizeof(T)) != 0)
+				return nullptr;
+			return (T*)mem;
+#endif
+		}
+
+		template<typename T>
+		static inline void AlignedFree(T* ptr)
+		{
+#ifdef _MSC_VER
+			_aligned_free(ptr);
+#else
+			free(ptr);
+#endif
+		}
+
+		// Flushes denormal results and inputs to zero on the calling thread
+		static void PreventDenormals();
+	};
+}
+
+#endif
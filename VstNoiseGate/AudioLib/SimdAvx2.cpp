@@ -0,0 +1,15 @@
+// Compiled with AVX2 and FMA enabled (-mavx2 -mfma, /arch:AVX2). Nothing here may run before Simd has checked the CPU
+#include "SimdKernels.h"
+
+namespace AudioLib
+{
+	const SimdKernels* GetAvx2Kernels()
+	{
+#if defined(AUDIOLIB_SIMD_AVX2) && defined(AUDIOLIB_SIMD_FMA)
+		static const SimdKernels kernels = MakeKernels<Avx2Ops>(SimdLevel::Avx2);
+		return &kernels;
+#else
+		return nullptr;
+#endif
+	}
+}
@@ -0,0 +1,15 @@
+// Compiled with AVX-512F and FMA enabled (-mavx512f -mfma, /arch:AVX512). Nothing here may run before Simd has checked the CPU
+#include "SimdKernels.h"
+
+namespace AudioLib
+{
+	const SimdKernels* GetAvx512Kernels()
+	{
+#if defined(AUDIOLIB_SIMD_AVX512)
+		static const SimdKernels kernels = MakeKernels<Avx512Ops>(SimdLevel::Avx512);
+		return &kernels;
+#else
+		return nullptr;
+#endif
+	}
+}
@@ -0,0 +1,235 @@
+#ifndef AUDIOLIB_SIMDKERNELS
+#define AUDIOLIB_SIMDKERNELS
+
+#include "Simd.h"
+#include "SimdTypes.h"
+
+namespace AudioLib
+{
+	/// <summary>
+	/// The array kernels of one SimdLevel. Simd.cpp holds the scalar and SSE2 tables, SimdAvx2.cpp and SimdAvx512.cpp
+	/// the others, each compiled for its own instruction set. The fast log2/exp2 kernels are indexed by
+	/// [function][polynomial degree - 2], function 0 is output = log2(input) * scale, 1 is output = 2 ^ (input * scale)
+	/// </summary>
+	struct SimdKernels
+	{
+		typedef void(*FloatKernel)(const float* input, float* output, int len, float scale);
+		typedef void(*DoubleKernel)(const double* input, double* output, int len, float scale);
+		typedef void(*DoubleToFloatKernel)(const double* input, float* output, int len, float scale);
+
+		SimdLevel Level;
+		FloatKernel Float[2][2];
+		DoubleKernel Double[2][2];
+		DoubleToFloatKernel DoubleToFloat[2][2];
+		float(*MaxAbsFloat)(const float* input, int len);
+		double(*MaxAbsDouble)(const double* input, int len);
+		void(*Min)(float* buffer, float value, int len);
+		void(*Max)(float* buffer, float value, int len);
+		void(*Floor)(float* buffer, int len);
+		void(*ConvertToFloats)(const int* input, float* output, int len);
+	};
+
+	// nullptr when the build has no kernels for the level. Only call them on a CPU that has the instruction set,
+	// the tables of the wider levels are built with it
+	const SimdKernels* GetScalarKernels();
+	const SimdKernels* GetSse2Kernels();
+	const SimdKernels* GetAvx2Kernels();
+	const SimdKernels* GetAvx512Kernels();
+
+	// Internal linkage for the same reason as in SimdTypes.h
+	namespace
+	{
+		// Polynomials fitted (minimax) to log2(1 + u), u in [sqrt(0.5) - 1, sqrt(2) - 1]
+		// and 2^f, f in [-0.5, 0.5]. Index is the power of the argument
+		const float Log2Deg2[] = { 0.0f, 1.48311536f, -0.699155328f };
+		const float Log2Deg3[] = { 0.0f, 1.44515177f, -0.754083432f, 0.445079038f };
+		const float Exp2Deg2[] = { 1.0f, 0.703457121f, 0.242641454f };
+		const float Exp2Deg3[] = { 1.0f, 0.693112485f, 0.242225534f, 0.0559772405f };
+
+		const float Exp2Min = -125.0f;
+		const float Exp2Max = 127.0f;
+
+		// exponent bias split point, reduces the mantissa to [sqrt(0.5), sqrt(2)) so the polynomial is centered on 1.0
+		const int32_t SqrtHalfBits = 0x3f3504f3;
+
+		template<int Deg> struct Coeffs;
+		template<> struct Coeffs<2> { static const float* Log2() { return Log2Deg2; } static const float* Exp2() { return Exp2Deg2; } };
+		template<> struct Coeffs<3> { static const float* Log2() { return Log2Deg3; } static const float* Exp2() { return Exp2Deg3; } };
+
+		template<typename Ops, int Deg>
+		inline typename Ops::V FastLog2(typename Ops::V x)
+		{
+			auto bits = Ops::AsInt(x);
+			auto e = Ops::ShiftRight23(Ops::SubInt(bits, Ops::SetInt(SqrtHalfBits)));
+			auto m = Ops::AsFloat(Ops::SubInt(bits, Ops::ShiftLeft23(e)));
+
+			auto c = Coeffs<Deg>::Log2();
+			auto u = Ops::Sub(m, Ops::Set(1.0f));
+			auto p = Ops::Set(c[Deg]);
+			for (int j = Deg - 1; j >= 0; j--)
+				p = Ops::MulAdd(p, u, Ops::Set(c[j]));
+
+			return Ops::Add(p, Ops::ToFloat(e));
+		}
+
+		template<typename Ops, int Deg>
+		inline typename Ops::V FastExp2(typename Ops::V x)
+		{
+			x = Ops::Min(Ops::Max(x, Ops::Set(Exp2Min)), Ops::Set(Exp2Max));
+			auto n = Ops::Round(x);
+			auto f = Ops::Sub(x, Ops::ToFloat(n));
+
+			auto c = Coeffs<Deg>::Exp2();
+			auto p = Ops::Set(c[Deg]);
+			for (int j = Deg - 1; j >= 0; j--)
+				p = Ops::MulAdd(p, f, Ops::Set(c[j]));
+
+			return Ops::AsFloat(Ops::AddInt(Ops::AsInt(p), Ops::ShiftLeft23(n)));
+		}
+
+		template<typename Ops, int Deg, bool IsExp>
+		inline typename Ops::V FastOp(typename Ops::V x, typename Ops::V scale)
+		{
+			if (IsExp)
+				return FastExp2<Ops, Deg>(Ops::Mul(x, scale));
+			else
+				return Ops::Mul(FastLog2<Ops, Deg>(x), scale);
+		}
+
+		template<typename Ops, int Deg, bool IsExp, typename TIn, typename TOut>
+		void RunFast(const TIn* input, TOut* output, int len, float scale)
+		{
+			int i = 0;
+			if (Ops::Width > 1)
+			{
+				auto scaleV = Ops::Set(scale);
+				for (; i + Ops::Width <= len; i += Ops::Width)
+					Ops::Store(&output[i], FastOp<Ops, Deg, IsExp>(Ops::Load(&input[i]), scaleV));
+			}
+
+			for (; i < len; i++)
+				ScalarOps::Store(&output[i], FastOp<ScalarOps, Deg, IsExp>(ScalarOps::Load(&input[i]), scale));
+		}
+
+		// NaNs are ignored: max() returns its second operand, the running maximum, when the first is NaN
+		template<typename T>
+		inline T MaxAbsTail(const T* input, int len, T max)
+		{
+			for (int i = 0; i < len; i++)
+			{
+				T x = std::abs(input[i]);
+				max = x > max ? x : max;
+			}
+
+			return max;
+		}
+
+		template<typename Ops>
+		float MaxAbsFloat(const float* input, int len)
+		{
+			int i = 0;
+			float max = 0;
+			if (Ops::Width > 1)
+			{
+				auto maxV = Ops::Set(0.0f);
+				for (; i + Ops::Width <= len; i += Ops::Width)
+					maxV = Ops::Max(Ops::Abs(Ops::Load(&input[i])), maxV);
+
+				float lanes[Ops::Width];
+				Ops::Store(lanes, maxV);
+				max = MaxAbsTail(lanes, Ops::Width, max);
+			}
+
+			return MaxAbsTail(&input[i], len - i, max);
+		}
+
+		template<typename Ops>
+		double MaxAbsDouble(const double* input, int len)
+		{
+			int i = 0;
+			double max = 0;
+			if (Ops::DoubleWidth > 1)
+			{
+				auto maxV = Ops::SetDouble(0.0);
+				for (; i + Ops::DoubleWidth <= len; i += Ops::DoubleWidth)
+					maxV = Ops::MaxDouble(Ops::AbsDouble(Ops::LoadDouble(&input[i])), maxV);
+
+				double lanes[Ops::DoubleWidth];
+				Ops::StoreDouble(lanes, maxV);
+				max = MaxAbsTail(lanes, Ops::DoubleWidth, max);
+			}
+
+			return MaxAbsTail(&input[i], len - i, max);
+		}
+
+		template<typename Ops>
+		void ArrayMin(float* buffer, float value, int len)
+		{
+			int i = 0;
+			auto valueV = Ops::Set(value);
+			for (; i + Ops::Width <= len; i += Ops::Width)
+				Ops::Store(&buffer[i], Ops::Min(Ops::Load(&buffer[i]), valueV));
+			for (; i < len; i++)
+				buffer[i] = ScalarOps::Min(buffer[i], value);
+		}
+
+		template<typename Ops>
+		void ArrayMax(float* buffer, float value, int len)
+		{
+			int i = 0;
+			auto valueV = Ops::Set(value);
+			for (; i + Ops::Width <= len; i += Ops::Width)
+				Ops::Store(&buffer[i], Ops::Max(Ops::Load(&buffer[i]), valueV));
+			for (; i < len; i++)
+				buffer[i] = ScalarOps::Max(buffer[i], value);
+		}
+
+		template<typename Ops>
+		void ArrayFloor(float* buffer, int len)
+		{
+			int i = 0;
+			for (; i + Ops::Width <= len; i += Ops::Width)
+				Ops::Store(&buffer[i], Ops::Floor(Ops::Load(&buffer[i])));
+			for (; i < len; i++)
+				buffer[i] = ScalarOps::Floor(buffer[i]);
+		}
+
+		template<typename Ops>
+		void ArrayConvertToFloats(const int* input, float* output, int len)
+		{
+			int i = 0;
+			for (; i + Ops::Width <= len; i += Ops::Width)
+				Ops::Store(&output[i], Ops::ToFloat(Ops::LoadInt(&input[i])));
+			for (; i < len; i++)
+				output[i] = (float)input[i];
+		}
+
+		template<typename Ops>
+		SimdKernels MakeKernels(SimdLevel level)
+		{
+			SimdKernels k;
+			k.Level = level;
+			k.Float[0][0] = RunFast<Ops, 2, false, float, float>;
+			k.Float[0][1] = RunFast<Ops, 3, false, float, float>;
+			k.Float[1][0] = RunFast<Ops, 2, true, float, float>;
+			k.Float[1][1] = RunFast<Ops, 3, true, float, float>;
+			k.Double[0][0] = RunFast<Ops, 2, false, double, double>;
+			k.Double[0][1] = RunFast<Ops, 3, false, double, double>;
+			k.Double[1][0] = RunFast<Ops, 2, true, double, double>;
+			k.Double[1][1] = RunFast<Ops, 3, true, double, double>;
+			k.DoubleToFloat[0][0] = RunFast<Ops, 2, false, double, float>;
+			k.DoubleToFloat[0][1] = RunFast<Ops, 3, false, double, float>;
+			k.DoubleToFloat[1][0] = RunFast<Ops, 2, true, double, float>;
+			k.DoubleToFloat[1][1] = RunFast<Ops, 3, true, double, float>;
+			k.MaxAbsFloat = MaxAbsFloat<Ops>;
+			k.MaxAbsDouble = MaxAbsDouble<Ops>;
+			k.Min = ArrayMin<Ops>;
+			k.Max = ArrayMax<Ops>;
+			k.Floor = ArrayFloor<Ops>;
+			k.ConvertToFloats = ArrayConvertToFloats<Ops>;
+			return k;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef AUDIOLIB_SIMDTYPES
+#define AUDIOLIB_SIMDTYPES
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIOLIB_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define AUDIOLIB_SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX512F__)
+#define AUDIOLIB_SIMD_AVX512
+#include <immintrin.h>
+#endif
+
+// MSVC has no __FMA__, /arch:AVX2 implies it
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define AUDIOLIB_SIMD_FMA
+#endif
+
+namespace AudioLib
+{
+	// Everything here has internal linkage. The header is compiled into translation units with different instruction
+	// set flags, and the linker must not pick an AVX2 copy of an inline function for the code running on an SSE2 CPU.
+	// Only include it from .cpp files
+	namespace
+	{
+		/// <summary>
+		/// The vector backends. Each one has the same operations on V, a register of Width floats, Vi, the same
+		/// number of 32 bit ints, and D, a register of DoubleWidth doubles. Samples are loaded and stored unaligned,
+		/// double arrays are converted to float on load and back on store. A backend only exists when the
+		/// translation unit is compiled for its instruction set
+		/// </summary>
+		struct ScalarOps
+		{
+			typedef float V;
+			typedef int32_t Vi;
+			typedef double D;
+			static const int Width = 1;
+			static const int DoubleWidth = 1;
+
+			static inline V Load(const float* p) { return *p; }
+			static inline V Load(const double* p) { return (float)*p; }
+			static inline void Store(float* p, V x) { *p = x; }
+			static inline void Store(double* p, V x) { *p = x; }
+			static inline V Set(float x) { return x; }
+			static inline V Add(V a, V b) { return a + b; }
+			static inline V Sub(V a, V b) { return a - b; }
+			static inline V Mul(V a, V b) { return a * b; }
+			// fused where the vector backend of the same translation unit is, so the tail rounds like the vectors
+			static inline V MulAdd(V a, V b, V c)
+			{
+#ifdef AUDIOLIB_SIMD_FMA
+				return std::fma(a, b, c);
+#else
+				return a * b + c;
+#endif
+			}
+
+			// same operand order as minps / maxps: a NaN in either operand returns b
+			static inline V Min(V a, V b) { return a < b ? a : b; }
+			static inline V Max(V a, V b) { return a > b ? a : b; }
+			static inline V Abs(V a) { return std::abs(a); }
+			static inline V Floor(V a) { return std::floor(a); }
+
+			static inline Vi AsInt(V a) { Vi i; std::memcpy(&i, &a, 4); return i; }
+			static inline V AsFloat(Vi a) { V f; std::memcpy(&f, &a, 4); return f; }
+			static inline Vi SetInt(int32_t x) { return x; }
+			static inline Vi LoadInt(const int* p) { return *p; }
+			static inline Vi AddInt(Vi a, Vi b) { return a + b; }
+			static inline Vi SubInt(Vi a, Vi b) { return a - b; }
+			static inline Vi ShiftRight23(Vi a) { return a >> 23; }
+			static inline Vi ShiftLeft23(Vi a) { return a * (1 << 23); }
+			static inline V ToFloat(Vi a) { return (float)a; }
+			// rounds halves to even in the default rounding mode, like the conversions of the vector backends
+			static inline Vi Round(V a) { return (Vi)std::lrint(a); }
+
+			static inline D LoadDouble(const double* p) { return *p; }
+			static inline D SetDouble(double x) { return x; }
+			static inline D MaxDouble(D a, D b) { return a > b ? a : b; }
+			static inline D AbsDouble(D a) { return std::abs(a); }
+			static inline void StoreDouble(double* p, D x) { *p = x; }
+		};
+
+#ifdef AUDIOLIB_SIMD_SSE2
+
+		struct Sse2Ops
+		{
+			typedef __m128 V;
+			typedef __m128i Vi;
+			typedef __m128d D;
+			static const int Width = 4;
+			static const int DoubleWidth = 2;
+
+			static inline V Load(const float* p) { return _mm_loadu_ps(p); }
+			static inline V Load(const double* p) { return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p)), _mm_cvtpd_ps(_mm_loadu_pd(p + 2))); }
+			static inline void Store(float* p, V x) { _mm_storeu_ps(p, x); }
+			static inline void Store(double* p, V x)
+			{
+				_mm_storeu_pd(p, _mm_cvtps_pd(x));
+				_mm_storeu_pd(p + 2, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+			}
+			static inline V Set(float x) { return _mm_set1_ps(x); }
+			static inline V Add(V a, V b) { return _mm_add_ps(a, b); }
+			static inline V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+			static inline V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+			static inline V MulAdd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+			static inline V Min(V a, V b) { return _mm_min_ps(a, b); }
+			static inline V Max(V a, V b) { return _mm_max_ps(a, b); }
+			static inline V Abs(V a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+			// SSE2 has no roundps: truncate, step down where that rounded up, and keep values of 2^23 and above,
+			// which are integers already and may not fit the conversion
+			static inline V Floor(V a)
+			{
+				V t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+				t = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+				V small = _mm_cmplt_ps(Abs(a), _mm_set1_ps(8388608.0f));
+				return _mm_or_ps(_mm_and_ps(small, t), _mm_andnot_ps(small, a));
+			}
+
+			static inline Vi AsInt(V a) { return _mm_castps_si128(a); }
+			static inline V AsFloat(Vi a) { return _mm_castsi128_ps(a); }
+			static inline Vi SetInt(int32_t x) { return _mm_set1_epi32(x); }
+			static inline Vi LoadInt(const int* p) { return _mm_loadu_si128((const __m128i*)p); }
+			static inline Vi AddInt(Vi a, Vi b) { return _mm_add_epi32(a, b); }
+			static inline Vi SubInt(Vi a, Vi b) { return _mm_sub_epi32(a, b); }
+			static inline Vi ShiftRight23(Vi a) { return _mm_srai_epi32(a, 23); }
+			static inline Vi ShiftLeft23(Vi a) { return _mm_slli_epi32(a, 23); }
+			static inline V ToFloat(Vi a) { return _mm_cvtepi32_ps(a); }
+			static inline Vi Round(V a) { return _mm_cvtps_epi32(a); }
+
+			static inline D LoadDouble(const double* p) { return _mm_loadu_pd(p); }
+			static inline D SetDouble(double x) { return _mm_set1_pd(x); }
+			static inline D MaxDouble(D a, D b) { return _mm_max_pd(a, b); }
+			static inline D AbsDouble(D a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+			static inline void StoreDouble(double* p, D x) { _mm_storeu_pd(p, x); }
+		};
+
+#endif
+
+#ifdef AUDIOLIB_SIMD_AVX2
+
+		struct Avx2Ops
+		{
+			typedef __m256 V;
+			typedef __m256i Vi;
+			typedef __m256d D;
+			static const int Width = 8;
+			static const int DoubleWidth = 4;
+
+			static inline V Load(const float* p) { return _mm256_loadu_ps(p); }
+			static inline V Load(const double* p) { return _mm256_set_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(p + 4)), _mm256_cvtpd_ps(_mm256_loadu_pd(p))); }
+			static inline void Store(float* p, V x) { _mm256_storeu_ps(p, x); }
+			static inline void Store(double* p, V x)
+			{
+				_mm256_storeu_pd(p, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+				_mm256_storeu_pd(p + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+			}
+			static inline V Set(float x) { return _mm256_set1_ps(x); }
+			static inline V Add(V a, V b) { return _mm256_add_ps(a, b); }
+			static inline V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+			static inline V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+			static inline V MulAdd(V a, V b, V c)
+			{
+#ifdef AUDIOLIB_SIMD_FMA
+				return _mm256_fmadd_ps(a, b, c);
+#else
+				return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+			}
+			static inline V Min(V a, V b) { return _mm256_min_ps(a, b); }
+			static inline V Max(V a, V b) { return _mm256_max_ps(a, b); }
+			static inline V Abs(V a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+			static inline V Floor(V a) { return _mm256_floor_ps(a); }
+
+			static inline Vi AsInt(V a) { return _mm256_castps_si256(a); }
+			static inline V AsFloat(Vi a) { return _mm256_castsi256_ps(a); }
+			static inline Vi SetInt(int32_t x) { return _mm256_set1_epi32(x); }
+			static inline Vi LoadInt(const int* p) { return _mm256_loadu_si256((const __m256i*)p); }
+			static inline Vi AddInt(Vi a, Vi b) { return _mm256_add_epi32(a, b); }
+			static inline Vi SubInt(Vi a, Vi b) { return _mm256_sub_epi32(a, b); }
+			static inline Vi ShiftRight23(Vi a) { return _mm256_srai_epi32(a, 23); }
+			static inline Vi ShiftLeft23(Vi a) { return _mm256_slli_epi32(a, 23); }
+			static inline V ToFloat(Vi a) { return _mm256_cvtepi32_ps(a); }
+			static inline Vi Round(V a) { return _mm256_cvtps_epi32(a); }
+
+			static inline D LoadDouble(const double* p) { return _mm256_loadu_pd(p); }
+			static inline D SetDouble(double x) { return _mm256_set1_pd(x); }
+			static inline D MaxDouble(D a, D b) { return _mm256_max_pd(a, b); }
+			static inline D AbsDouble(D a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+			static inline void StoreDouble(double* p, D x) { _mm256_storeu_pd(p, x); }
+		};
+
+#endif
+
+#ifdef AUDIOLIB_SIMD_AVX512
+
+		// AVX-512F only, which every AVX-512 CPU has
+		struct Avx512Ops
+		{
+			typedef __m512 V;
+			typedef __m512i Vi;
+			typedef __m512d D;
+			static const int Width = 16;
+			static const int DoubleWidth = 8;
+
+			static inline V Load(const float* p) { return _mm512_loadu_ps(p); }
+			static inline V Load(const double* p)
+			{
+				__m256 low = _mm512_cvtpd_ps(_mm512_loadu_pd(p));
+				__m256 high = _mm512_cvtpd_ps(_mm512_loadu_pd(p + 8));
+				return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castps_pd(_mm512_castps256_ps512(low)), _mm256_castps_pd(high), 1));
+			}
+			static inline void Store(float* p, V x) { _mm512_storeu_ps(p, x); }
+			static inline void Store(double* p, V x)
+			{
+				_mm512_storeu_pd(p, _mm512_cvtps_pd(_mm512_castps512_ps256(x)));
+				_mm512_storeu_pd(p + 8, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(x), 1))));
+			}
+			static inline V Set(float x) { return _mm512_set1_ps(x); }
+			static inline V Add(V a, V b) { return _mm512_add_ps(a, b); }
+			static inline V Sub(V a, V b) { return _mm512_sub_ps(a, b); }
+			static inline V Mul(V a, V b) { return _mm512_mul_ps(a, b); }
+			static inline V MulAdd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+			static inline V Min(V a, V b) { return _mm512_min_ps(a, b); }
+			static inline V Max(V a, V b) { return _mm512_max_ps(a, b); }
+			static inline V Abs(V a) { return _mm512_castsi512_ps(_mm512_andnot_si512(_mm512_set1_epi32(0x80000000), _mm512_castps_si512(a))); }
+			static inline V Floor(V a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+
+			static inline Vi AsInt(V a) { return _mm512_castps_si512(a); }
+			static inline V AsFloat(Vi a) { return _mm512_castsi512_ps(a); }
+			static inline Vi SetInt(int32_t x) { return _mm512_set1_epi32(x); }
+			static inline Vi LoadInt(const int* p) { return _mm512_loadu_si512(p); }
+			static inline Vi AddInt(Vi a, Vi b) { return _mm512_add_epi32(a, b); }
+			static inline Vi SubInt(Vi a, Vi b) { return _mm512_sub_epi32(a, b); }
+			static inline Vi ShiftRight23(Vi a) { return _mm512_srai_epi32(a, 23); }
+			static inline Vi ShiftLeft23(Vi a) { return _mm512_slli_epi32(a, 23); }
+			static inline V ToFloat(Vi a) { return _mm512_cvtepi32_ps(a); }
+			static inline Vi Round(V a) { return _mm512_cvtps_epi32(a); }
+
+			static inline D LoadDouble(const double* p) { return _mm512_loadu_pd(p); }
+			static inline D SetDouble(double x) { return _mm512_set1_pd(x); }
+			static inline D MaxDouble(D a, D b) { return _mm512_max_pd(a, b); }
+			static inline D AbsDouble(D a) { return _mm512_castsi512_pd(_mm512_andnot_si512(_mm512_set1_epi64(0x8000000000000000LL), _mm512_castpd_si512(a))); }
+			static inline void StoreDouble(double* p, D x) { _mm512_storeu_pd(p, x); }
+		};
+
+#endif
+	}
+}
+
+#endif
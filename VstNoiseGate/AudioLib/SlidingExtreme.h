@@ -0,0 +1,173 @@
+#ifndef AUDIOLIB_SLIDINGEXTREME
+#define AUDIOLIB_SLIDINGEXTREME
+
+#include <cstdint>
+#include <functional>
+
+namespace AudioLib
+{
+	/// <summary>
+	/// Maximum (or minimum, depending on Compare) over a sliding window of samples, as a monotonic deque.
+	/// Only values that can still become the extreme are kept, in time order. The oldest is always the extreme.
+	/// A new value removes every older one it beats, so each value is added and removed once: amortized O(1) per sample,
+	/// independent of the window length. The deque is a fixed ring of Capacity entries, so the window can be at most
+	/// Capacity samples long, and nothing is allocated after construction. Capacity must be a power of two
+	/// </summary>
+	template<typename T, int Capacity, typename Compare = std::greater<T>>
+	class SlidingExtremeT
+	{
+		static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+		static const uint32_t Mask = Capacity - 1;
+
+	public:
+		/// <summary>
+		/// The candidates oldest first and the sample clock, plain data for snapshots. Only the first Count entries are used
+		/// </summary>
+		struct State
+		{
+			uint32_t Now;
+			int Count;
+			uint32_t Times[Capacity];
+			T Values[Capacity];
+		};
+
+	private:
+		// sample time each value was added at, compared as unsigned differences so the clock may wrap
+		uint32_t times[Capacity];
+		T values[Capacity];
+
+		// ring positions, only masked when indexing, so tail - head is the number of candidates
+		uint32_t head;
+		uint32_t tail;
+		uint32_t now;
+		uint32_t window;
+		Compare compare;
+
+	public:
+		SlidingExtremeT(int window = Capacity)
+		{
+			SetWindow(window);
+			Reset();
+		}
+
+		// Drops every value and restarts the clock
+		void Reset()
+		{
+			head = 0;
+			tail = 0;
+			now = 0;
+		}
+
+		/// <summary>
+		/// Values stay for this many samples: the one added at the current sample and the window - 1 before it.
+		/// Clamped to 1...Capacity. Shortening the window drops the expired values on the next Advance
+		/// </summary>
+		void SetWindow(int samples)
+		{
+			window = (uint32_t)(samples < 1 ? 1 : samples > Capacity ? Capacity : samples);
+		}
+
+		int GetWindow() const
+		{
+			return (int)window;
+		}
+
+		bool IsEmpty() const
+		{
+			return head == tail;
+		}
+
+		// The extreme of the values in the window. Only valid if the window is not empty
+		T GetExtreme() const
+		{
+			return values[head & Mask];
+		}
+
+		/// <summary>
+		/// Adds a value at the current sample. Several values may be added per sample, only the extreme of them is kept
+		/// </summary>
+		void Push(T value)
+		{
+			// a second value at the same sample only counts if it beats the first
+			if (tail != head && times[(tail - 1) & Mask] == now && compare(values[(tail - 1) & Mask], value))
+				return;
+
+			// equal values are dropped as well, the new one stays longer
+			while (tail != head && !compare(values[(tail - 1) & Mask], value))
+				tail--;
+
+			times[tail & Mask] = now;
+			values[tail & Mask] = value;
+			tail++;
+		}
+
+		// Moves on to the next sample and drops the value that has left the window
+		void Advance()
+		{
+			now++;
+
+			// one value per sample at most can expire, unless the window was just shortened
+			while (tail != head && now - times[head & Mask] >= window)
+				head++;
+		}
+
+		// Moves on by that many samples without adding anything
+		void Skip(int samples)
+		{
+			now += (uint32_t)samples;
+			while (tail != head && now - times[head & Mask] >= window)
+				head++;
+		}
+
+		/// <summary>
+		/// Plain sliding extreme: adds the value and returns the extreme of it and the window - 1 samples before it
+		/// </summary>
+		T Process(T value)
+		{
+			Push(value);
+			T extreme = GetExtreme();
+			Advance();
+			return extreme;
+		}
+
+		void Process(const T* input, T* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = Process(input[i]);
+		}
+
+		void GetState(State& state) const
+		{
+			state.Now = now;
+			state.Count = (int)(tail - head);
+			for (int i = 0; i < state.Count; i++)
+			{
+				state.Times[i] = times[(head + i) & Mask];
+				state.Values[i] = values[(head + i) & Mask];
+			}
+		}
+
+		// The window length is a setting and is kept
+		void SetState(const State& state)
+		{
+			int count = state.Count < 0 ? 0 : state.Count > Capacity ? Capacity : state.Count;
+			for (int i = 0; i < count; i++)
+			{
+				times[i] = state.Times[i];
+				values[i] = state.Values[i];
+			}
+
+			head = 0;
+			tail = (uint32_t)count;
+			now = state.Now;
+		}
+	};
+
+	template<typename T, int Capacity>
+	using SlidingMaxT = SlidingExtremeT<T, Capacity, std::greater<T>>;
+
+	template<typename T, int Capacity>
+	using SlidingMinT = SlidingExtremeT<T, Capacity, std::less<T>>;
+}
+
+#endif
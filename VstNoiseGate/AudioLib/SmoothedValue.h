@@ -0,0 +1,86 @@
+#ifndef AUDIOLIB_SMOOTHEDVALUE
+#define AUDIOLIB_SMOOTHEDVALUE
+
+namespace AudioLib
+{
+	/// <summary>
+	/// Linear ramp towards a target value, to avoid zipper noise when a parameter jumps.
+	/// A new target restarts the ramp from the current value, and the ramp always takes the same number of samples
+	/// </summary>
+	template<typename T>
+	class SmoothedValue
+	{
+	private:
+		T current;
+		T target;
+		T step;
+		int remaining;
+		int rampSamples;
+
+	public:
+		SmoothedValue()
+		{
+			rampSamples = 0;
+			Reset(0);
+		}
+
+		inline void SetRampLength(int samples)
+		{
+			rampSamples = samples;
+		}
+
+		// Jumps to the value without ramping
+		inline void Reset(T value)
+		{
+			current = value;
+			target = value;
+			step = 0;
+			remaining = 0;
+		}
+
+		inline void SetTarget(T value)
+		{
+			if (value == target)
+				return;
+
+			target = value;
+			if (rampSamples <= 0)
+			{
+				Reset(value);
+				return;
+			}
+
+			remaining = rampSamples;
+			step = (target - current) / rampSamples;
+		}
+
+		inline bool IsSmoothing() const
+		{
+			return remaining > 0;
+		}
+
+		inline T GetCurrent() const
+		{
+			return current;
+		}
+
+		/// <summary>
+		/// Writes the next len values of the ramp. The last step lands exactly on the target
+		/// </summary>
+		inline void Process(T* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+			{
+				if (remaining > 0)
+				{
+					remaining--;
+					current = remaining == 0 ? target : current + step;
+				}
+
+				output[i] = current;
+			}
+		}
+	};
+}
+
+#endif
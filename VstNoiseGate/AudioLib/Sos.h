@@ -0,0 +1,290 @@
+#ifndef AUDIOLIB_SOS
+#define AUDIOLIB_SOS
+
+namespace AudioLib
+{
+	/// <summary>
+	/// Coefficients of one second order section, normalised so that a0 == 1:
+	/// H(z) = (B0 + B1 z^-1 + B2 z^-2) / (1 + A1 z^-1 + A2 z^-2)
+	/// </summary>
+	template<typename T>
+	struct SosCoefficients
+	{
+		T B0, B1, B2, A1, A2;
+
+		// A section that passes the signal through unchanged
+		static SosCoefficients Identity()
+		{
+			return { 1, 0, 0, 0, 0 };
+		}
+	};
+
+	/// <summary>
+	/// Biquad in transposed direct form II. T is the sample type of the input and output, TAcc the type of the
+	/// coefficients, the state and the arithmetic. With float samples and a double TAcc the filter is accumulated
+	/// in double precision, which keeps the rounding noise of low cutoffs out of the output at the cost of two
+	/// conversions per sample. No copying of the history from one sample to the next.
+	/// The first state value is kept as its feedforward part and the last output, and the feedback term is only
+	/// applied when the next output is formed: y = (B0 x + S1) - A1 y1. That leaves a multiply and a subtraction
+	/// between consecutive outputs instead of four operations, which sets the speed of a recurrence like this
+	/// </summary>
+	template<typename T, typename TAcc = T>
+	class Tdf2BiquadT
+	{
+	private:
+		TAcc b0, b1, b2, a1, a2;
+		TAcc s1, s2, y1;
+
+	public:
+		// The filter memory, plain data so it can be part of a snapshot of the processor using the filter
+		struct State
+		{
+			TAcc S1, S2, Y1;
+		};
+
+		Tdf2BiquadT()
+		{
+			SetCoefficients(SosCoefficients<T>::Identity());
+			ClearBuffers();
+		}
+
+		// Keeps the state, so the filter can be retuned while running. The coefficients are converted to TAcc
+		template<typename TCoeff>
+		inline void SetCoefficients(const SosCoefficients<TCoeff>& c)
+		{
+			b0 = (TAcc)c.B0;
+			b1 = (TAcc)c.B1;
+			b2 = (TAcc)c.B2;
+			a1 = (TAcc)c.A1;
+			a2 = (TAcc)c.A2;
+		}
+
+		inline void ClearBuffers()
+		{
+			s1 = 0;
+			s2 = 0;
+			y1 = 0;
+		}
+
+		inline T Process(T x)
+		{
+			return (T)Step((TAcc)x, s1, s2, y1);
+		}
+
+		// input and output may be the same buffer
+		inline void Process(const T* input, T* output, int len)
+		{
+			TAcc z1 = s1;
+			TAcc z2 = s2;
+			TAcc last = y1;
+			for (int i = 0; i < len; i++)
+				output[i] = (T)Step((TAcc)input[i], z1, z2, last);
+
+			s1 = z1;
+			s2 = z2;
+			y1 = last;
+		}
+
+		/// <summary>
+		/// Sets the state the filter settles to under a constant input x, so it continues from there without a transient.
+		/// Returns the output it then gives, x times the DC gain
+		/// </summary>
+		inline TAcc SetSteadyState(TAcc x)
+		{
+			TAcc y = x * (b0 + b1 + b2) / (1 + a1 + a2);
+			s2 = b2 * x - a2 * y;
+			s1 = b1 * x + s2;
+			y1 = y;
+			return y;
+		}
+
+		/// <summary>
+		/// Runs this section and next in series over the block, sample by sample in one loop. The two recurrences
+		/// don't wait on each other, so they overlap and the pair costs little more than one section. Gives exactly
+		/// the same result as running the sections one after the other
+		/// </summary>
+		inline void ProcessPair(Tdf2BiquadT& next, const T* input, T* output, int len)
+		{
+			TAcc z1 = s1;
+			TAcc z2 = s2;
+			TAcc last = y1;
+			TAcc w1 = next.s1;
+			TAcc w2 = next.s2;
+			TAcc nextLast = next.y1;
+			for (int i = 0; i < len; i++)
+			{
+				// the intermediate is rounded to T, as between two separate sections
+				T y = (T)Step((TAcc)input[i], z1, z2, last);
+				output[i] = (T)next.Step((TAcc)y, w1, w2, nextLast);
+			}
+
+			s1 = z1;
+			s2 = z2;
+			y1 = last;
+			next.s1 = w1;
+			next.s2 = w2;
+			next.y1 = nextLast;
+		}
+
+		// True if all state values are below level in magnitude
+		inline bool IsBelow(TAcc level) const
+		{
+			return s1 < level && s1 > -level && s2 < level && s2 > -level && y1 < level && y1 > -level;
+		}
+
+		inline void GetState(State& state) const
+		{
+			state.S1 = s1;
+			state.S2 = s2;
+			state.Y1 = y1;
+		}
+
+		// Coefficients are not part of the state and stay as they are
+		inline void SetState(const State& state)
+		{
+			s1 = state.S1;
+			s2 = state.S2;
+			y1 = state.Y1;
+		}
+
+	private:
+		// One sample, with the state passed in so the block loops can keep it in registers
+		inline TAcc Step(TAcc in, TAcc& z1, TAcc& z2, TAcc& last) const
+		{
+			TAcc y = (b0 * in + z1) - a1 * last;
+			z1 = b1 * in + z2;
+			z2 = b2 * in - a2 * y;
+			last = y;
+			return y;
+		}
+	};
+
+	/// <summary>
+	/// A cascade of up to MaxSections transposed direct form II sections, for filters of higher order given as
+	/// second order sections. The block version runs the sections two at a time over the whole block, see
+	/// Tdf2BiquadT::ProcessPair, with the state in registers. Nothing is allocated, the section count can change freely
+	/// </summary>
+	template<typename T, int MaxSections, typename TAcc = T>
+	class SosCascadeT
+	{
+		static_assert(MaxSections >= 1, "SosCascade needs at least one section");
+
+	public:
+		typedef Tdf2BiquadT<T, TAcc> Section;
+
+		// The memory of every section in use, plain data for snapshots
+		struct State
+		{
+			int Count;
+			typename Section::State Sections[MaxSections];
+		};
+
+	private:
+		Section sections[MaxSections];
+		int count;
+
+	public:
+		SosCascadeT() : count(0) { }
+
+		/// <summary>
+		/// Sets the sections, clamped to MaxSections. Sections that stay in use keep their state,
+		/// new ones start cleared
+		/// </summary>
+		template<typename TCoeff>
+		void SetSections(const SosCoefficients<TCoeff>* coefficients, int sectionCount)
+		{
+			sectionCount = sectionCount < 0 ? 0 : sectionCount > MaxSections ? MaxSections : sectionCount;
+			for (int i = 0; i < sectionCount; i++)
+			{
+				sections[i].SetCoefficients(coefficients[i]);
+				if (i >= count)
+					sections[i].ClearBuffers();
+			}
+
+			count = sectionCount;
+		}
+
+		int GetSectionCount() const
+		{
+			return count;
+		}
+
+		void ClearBuffers()
+		{
+			for (int i = 0; i < count; i++)
+				sections[i].ClearBuffers();
+		}
+
+		inline T Process(T x)
+		{
+			for (int i = 0; i < count; i++)
+				x = sections[i].Process(x);
+			return x;
+		}
+
+		// input and output may be the same buffer. With no sections the input is copied
+		void Process(const T* input, T* output, int len)
+		{
+			if (count == 0)
+			{
+				if (input != output)
+				{
+					for (int i = 0; i < len; i++)
+						output[i] = input[i];
+				}
+				return;
+			}
+
+			const T* source = input;
+			int i = 0;
+			for (; i + 1 < count; i += 2)
+			{
+				sections[i].ProcessPair(sections[i + 1], source, output, len);
+				source = output;
+			}
+
+			if (i < count)
+				sections[i].Process(source, output, len);
+		}
+
+		// Settles every section to a constant input x, see Tdf2BiquadT::SetSteadyState
+		void SetSteadyState(TAcc x)
+		{
+			for (int i = 0; i < count; i++)
+				x = sections[i].SetSteadyState(x);
+		}
+
+		/// <summary>
+		/// Clears the state once every value of it is below level in magnitude. A decaying cascade only reaches exact
+		/// zero at the bottom of the TAcc range, this ends the tail early. With a level far enough below the smallest
+		/// input, the remainder would be lost in rounding against the next input anyway, so the output doesn't change
+		/// </summary>
+		void ClearBelow(TAcc level)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				if (!sections[i].IsBelow(level))
+					return;
+			}
+
+			ClearBuffers();
+		}
+
+		void GetState(State& state) const
+		{
+			state.Count = count;
+			for (int i = 0; i < count; i++)
+				sections[i].GetState(state.Sections[i]);
+		}
+
+		// Only restores the memory of the sections, the state must come from a cascade with the same design
+		void SetState(const State& state)
+		{
+			int n = state.Count < count ? state.Count : count;
+			for (int i = 0; i < n; i++)
+				sections[i].SetState(state.Sections[i]);
+		}
+	};
+}
+
+#endif
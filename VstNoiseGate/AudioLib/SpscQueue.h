@@ -0,0 +1,62 @@
+#ifndef AUDIOLIB_SPSCQUEUE
+#define AUDIOLIB_SPSCQUEUE
+
+#include <atomic>
+
+namespace AudioLib
+{
+	/// <summary>
+	/// Lock-free, wait-free queue for exactly one producer thread and one consumer thread.
+	/// Fixed capacity, nothing is allocated after construction. Capacity must be a power of two,
+	/// one slot is kept free to tell a full queue from an empty one
+	/// </summary>
+	template<typename T, int Capacity>
+	class SpscQueue
+	{
+		static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+		static const int Mask = Capacity - 1;
+
+		// head is only written by the consumer, tail only by the producer. Kept on separate cache lines
+		alignas(64) std::atomic<int> head;
+		alignas(64) std::atomic<int> tail;
+		alignas(64) T items[Capacity];
+
+	public:
+		SpscQueue()
+		{
+			head.store(0, std::memory_order_relaxed);
+			tail.store(0, std::memory_order_relaxed);
+		}
+
+		/// <summary>
+		/// Producer side. Returns false and drops the item if the queue is full
+		/// </summary>
+		inline bool TryPush(const T& item)
+		{
+			int t = tail.load(std::memory_order_relaxed);
+			int next = (t + 1) & Mask;
+			if (next == head.load(std::memory_order_acquire))
+				return false;
+
+			items[t] = item;
+			tail.store(next, std::memory_order_release);
+			return true;
+		}
+
+		/// <summary>
+		/// Consumer side. Returns false if the queue is empty
+		/// </summary>
+		inline bool TryPop(T& item)
+		{
+			int h = head.load(std::memory_order_relaxed);
+			if (h == tail.load(std::memory_order_acquire))
+				return false;
+
+			item = items[h];
+			head.store((h + 1) & Mask, std::memory_order_release);
+			return true;
+		}
+	};
+}
+
+#endif
@@ -3,23 +3,151 @@
 #include <vector>
 using namespace std;
 
-// UNTESTED BUT SHOULD WORK
-
 namespace AudioLib
 {
+	/// <summary>
+	/// Transfer function filter of fixed order, a[0] y[n] = sum b[j] x[n - j] - sum a[j] y[n - j], with
+	/// OrderB + 1 numerator and OrderA + 1 denominator coefficients. With OrderA = 0 it is an FIR filter and the
+	/// output doesn't feed back. Runs in transposed direct form II: max(OrderB, OrderA) state values, no history
+	/// buffer to index, and every tap is a loop of constant length the compiler unrolls. The coefficients are
+	/// normalised by a[0] when they are set. Nothing is allocated, see Transfer for orders only known at runtime
+	/// </summary>
+	template<typename T, int OrderB, int OrderA = OrderB>
+	class TransferT
+	{
+		static_assert(OrderB >= 0 && OrderA >= 0, "Transfer orders can't be negative");
+
+	public:
+		static const int Order = OrderB > OrderA ? OrderB : OrderA;
+
+		// The filter memory, plain data for snapshots. One unused entry for order 0, to keep the array valid
+		struct State
+		{
+			T S[Order > 0 ? Order : 1];
+		};
+
+	private:
+		double rawB[OrderB + 1];
+		double rawA[OrderA + 1];
+
+		T b[OrderB + 1];
+		T a[OrderA + 1];
+		T s[Order > 0 ? Order : 1];
+
+	public:
+		TransferT()
+		{
+			for (int j = 0; j <= OrderB; j++)
+				rawB[j] = j == 0 ? 1 : 0;
+			for (int j = 0; j <= OrderA; j++)
+				rawA[j] = j == 0 ? 1 : 0;
+
+			Normalise();
+			ClearBuffers();
+		}
+
+		int GetOrder() const
+		{
+			return Order;
+		}
+
+		// Missing trailing coefficients are 0. Keeps the state
+		void SetB(const double (&b)[OrderB + 1])
+		{
+			for (int j = 0; j <= OrderB; j++)
+				rawB[j] = b[j];
+			Normalise();
+		}
+
+		// Missing trailing coefficients are 0. Keeps the state. As with Transfer, a[0] == 0 silences the filter
+		void SetA(const double (&a)[OrderA + 1])
+		{
+			for (int j = 0; j <= OrderA; j++)
+				rawA[j] = a[j];
+			Normalise();
+		}
+
+		void ClearBuffers()
+		{
+			for (int i = 0; i < (Order > 0 ? Order : 1); i++)
+				s[i] = 0;
+		}
+
+		inline T Process(T x)
+		{
+			return Step(x, s);
+		}
+
+		// input and output may be the same buffer. The state is held in a local copy for the whole block
+		void Process(const T* input, T* output, int len)
+		{
+			T z[Order > 0 ? Order : 1];
+			for (int i = 0; i < Order; i++)
+				z[i] = s[i];
+
+			for (int n = 0; n < len; n++)
+				output[n] = Step(input[n], z);
+
+			for (int i = 0; i < Order; i++)
+				s[i] = z[i];
+		}
+
+		void GetState(State& state) const
+		{
+			for (int i = 0; i < (Order > 0 ? Order : 1); i++)
+				state.S[i] = s[i];
+		}
+
+		// Coefficients are not part of the state and stay as they are
+		void SetState(const State& state)
+		{
+			for (int i = 0; i < (Order > 0 ? Order : 1); i++)
+				s[i] = state.S[i];
+		}
+
+	private:
+		void Normalise()
+		{
+			double gain = rawA[0] == 0.0 ? 0.0 : 1 / rawA[0];
+			for (int j = 0; j <= OrderB; j++)
+				b[j] = (T)(rawB[j] * gain);
+			for (int j = 0; j <= OrderA; j++)
+				a[j] = (T)(rawA[j] * gain);
+		}
+
+		// One sample: state value i holds what taps i + 1 and above contribute to the next output
+		inline T Step(T x, T* z) const
+		{
+			T y = b[0] * x + (Order > 0 ? z[0] : 0);
+			for (int i = 0; i < Order; i++)
+			{
+				T next = i + 1 < Order ? z[i + 1] : 0;
+				T feedForward = i + 1 <= OrderB ? b[i + 1] * x : 0;
+				T feedBack = i + 1 <= OrderA ? a[i + 1] * y : 0;
+				z[i] = feedForward - feedBack + next;
+			}
+
+			return y;
+		}
+	};
+
+	/// <summary>
+	/// Transfer function filter of any order up to 63, set at runtime, in direct form I. Slower than TransferT, which
+	/// should be used whenever the order is known at compile time; this is the fallback for the other cases
+	/// </summary>
 	class Transfer
 	{
 	private:
 		vector<double> b;
 		vector<double> a;
 
-		double bufIn[64];
-		double bufOut[64];
+		// history of the input and the output, a power of two so the index wraps with a mask
+		static const int BufferSize = 64;
+		double bufIn[BufferSize];
+		double bufOut[BufferSize];
 
 		double Gain;
 
-		// buffer size
-		int modulo = 64;
 		int index = 0;
 
 	public:
@@ -28,44 +156,62 @@ namespace AudioLib
 		{
 			SetB(vector<double> { 1.0 });
 			SetA(vector<double> { 1.0 });
+			ClearBuffers();
 		}
 
-		int GetOrder()
+		int GetOrder() const
 		{
-			return (b.size() > a.size()) ? b.size() - 1 : a.size() - 1;
+			return (b.size() > a.size()) ? (int)b.size() - 1 : (int)a.size() - 1;
 		}
 
-		void SetB(vector<double> b)
+		// At most BufferSize coefficients are used
+		void SetB(const vector<double>& b)
 		{
 			this->b = b;
+			if (this->b.size() > BufferSize)
+				this->b.resize(BufferSize);
 		}
 
-		void SetA(vector<double> a)
+		// At most BufferSize coefficients are used. a[0] == 0 silences the filter
+		void SetA(const vector<double>& a)
 		{
 			this->a = a;
-			if (a[0] == 0.0)
+			if (this->a.size() > BufferSize)
+				this->a.resize(BufferSize);
+
+			if (this->a.empty() || this->a[0] == 0.0)
 				Gain = 0.0;
 			else
-				Gain = 1 / a[0];
+				Gain = 1 / this->a[0];
+		}
+
+		void ClearBuffers()
+		{
+			for (int i = 0; i < BufferSize; i++)
+			{
+				bufIn[i] = 0;
+				bufOut[i] = 0;
+			}
 		}
 
 		double Process(double input)
 		{
-			index = (index + 1) % modulo;
+			const int mask = BufferSize - 1;
+			index = (index + 1) & mask;
 
 			bufIn[index] = input;
-			bufOut[index] = 0;
-
-			for (int j = 0; j < b.size(); j++)
-				bufOut[index] += (b[j] * bufIn[((index - j) + modulo) % modulo]);
+			double sum = 0;
 
-			for (int j = 1; j < a.size(); j++)
-				bufOut[index] -= (a[j] * bufOut[((index - j) + modulo) % modulo]);
+			int nb = (int)b.size();
+			for (int j = 0; j < nb; j++)
+				sum += b[j] * bufIn[(index - j) & mask];
 
-			bufOut[index] = bufOut[index] * Gain;
+			int na = (int)a.size();
+			for (int j = 1; j < na; j++)
+				sum -= a[j] * bufOut[(index - j) & mask];
 
-			auto output = bufOut[index];
-			return output;
+			bufOut[index] = sum * Gain;
+			return bufOut[index];
 		}
 	};
 }
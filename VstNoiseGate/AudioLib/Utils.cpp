@@ -5,44 +5,47 @@
 
 namespace AudioLib
 {
-	float Utils::note2Freq[12800];
-	float Utils::sintable[TableSize];
-	float Utils::costable[TableSize];
-	float Utils::tableScaler;
-
-	float Utils::tanhTable[TanhTableSize];
-
-	void Utils::Initialize()
+	Utils::TrigTables::TrigTables()
 	{
-		for (int i = 0; i < 12800; i++)
+		for (int i = 0; i < TableSize; i++)
 		{
-			note2Freq[i] = (float)(440.0 * std::pow(2, (0.01*i - 69) / 12.0));
+			Sin[i] = (float)std::sin(i / (double)TableSize * M_PI);
+			Cos[i] = (float)std::cos(i / (double)TableSize * M_PI);
 		}
+	}
 
-		tableScaler = (float)(1.0 / (2.0f * M_PI) * TableSize);
-
-		for (int i = 0; i < TableSize; i++)
+	Utils::NoteTable::NoteTable()
+	{
+		for (int i = 0; i < NoteTableSize; i++)
 		{
-			sintable[i] = (float)std::sin(i / (double)TableSize * M_PI);
-			costable[i] = (float)std::cos(i / (double)TableSize * M_PI);
+			Freq[i] = (float)(440.0 * std::pow(2, (0.01*i - 69) / 12.0));
 		}
+	}
 
+	Utils::TanhTable::TanhTable()
+	{
 		for (int i = 0; i < TanhTableSize; i++)
 		{
-			tanhTable[i] = std::tanh(-3.0f + i / 10000.0f);
+			Values[i] = std::tanh(-3.0f + i / 10000.0f);
 		}
 	}
 
+	void Utils::Initialize()
+	{
+		Trig();
+	}
+
 	float Utils::Note2Freq(float note)
 	{
+		static const NoteTable table;
+		auto& note2Freq = table.Freq;
+
 		auto base = (int)(note * 100);
 		auto partial = note * 100 - base;
 
-		if (base > 12799)
-		{
-			base = 12799;
-			partial = 0;
-		}
+		// the last entry has no neighbour to interpolate with
+		if (base >= NoteTableSize - 1)
+			return note2Freq[NoteTableSize - 1];
 
 		auto freq = note2Freq[base];
 		auto slope = note2Freq[base + 1] - freq;
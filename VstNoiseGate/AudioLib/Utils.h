@@ -11,28 +11,61 @@ namespace AudioLib
 	{
 	private:
 		static const int TableSize = 20000;
-		static float note2Freq[12800];
-		static float sintable[TableSize];
-		static float costable[TableSize];
-		static float tableScaler;
-
+		static constexpr float TableScaler = (float)(1.0 / (2.0f * M_PI) * TableSize);
+		static const int NoteTableSize = 12800;
 		static const int TanhTableSize = 60000;
-		static float tanhTable[TanhTableSize];
+
+		// Every table is built by the constructor of a function local static the first time it is used. The language
+		// guarantees that runs once per process, also when several threads get there at the same time
+		struct TrigTables
+		{
+			float Sin[TableSize];
+			float Cos[TableSize];
+			TrigTables();
+		};
+
+		struct NoteTable
+		{
+			float Freq[NoteTableSize];
+			NoteTable();
+		};
+
+		struct TanhTable
+		{
+			float Values[TanhTableSize];
+			TanhTable();
+		};
+
+		static inline const TrigTables& Trig()
+		{
+			static const TrigTables tables;
+			return tables;
+		}
+
+		static inline const TanhTable& Tanh()
+		{
+			static const TanhTable table;
+			return table;
+		}
 
 	public:
+		/// <summary>
+		/// Builds the sine and cosine tables ahead of their first use, the only tables the filter designs need.
+		/// Optional, every table is built once on first use, and cheap to call again
+		/// </summary>
 		static void Initialize();
 		static float Note2Freq(float note);
 
 		static inline float FastSin(float x)
 		{
-			int idx = ((int)(x * tableScaler) + 100 * TableSize) % TableSize;
-			return sintable[idx];
+			int idx = ((int)(x * TableScaler) + 100 * TableSize) % TableSize;
+			return Trig().Sin[idx];
 		}
 
 		static inline float FastCos(float x)
 		{
-			int idx = ((int)(x * tableScaler) + 100 * TableSize) % TableSize;
-			return costable[idx];
+			int idx = ((int)(x * TableScaler) + 100 * TableSize) % TableSize;
+			return Trig().Cos[idx];
 		}
 
 		static inline void ZeroBuffer(float* buffer, int len)
@@ -60,6 +93,17 @@ namespace AudioLib
 			std::memcpy(dest, source, len * sizeof(float));
 		}
 
+		static inline void Copy(const double* source, double* dest, int len)
+		{
+			std::memcpy(dest, source, len * sizeof(double));
+		}
+
+		static inline void Copy(const float* source, double* dest, int len)
+		{
+			for (int i = 0; i < len; i++)
+				dest[i] = source[i];
+		}
+
 		static inline void Gain(float* buffer, float gain, int len)
 		{
 			for (int i = 0; i < len; i++)
@@ -130,7 +174,7 @@ namespace AudioLib
 			int underMax = i < TanhTableSize - 1;
 			i = i * overZero;
 			i = i * underMax + !underMax * (TanhTableSize - 1);
-			return tanhTable[i];
+			return Tanh().Values[i];
 		}
 
 		static inline float CubicNonlin(float x)
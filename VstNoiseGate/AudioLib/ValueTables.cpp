@@ -4,76 +4,146 @@
 
 namespace AudioLib
 {
-	double ValueTables::Sqrt[TableSize];
-	double ValueTables::Sqrt3[TableSize];
-	double ValueTables::Pow1_5[TableSize];
-	double ValueTables::Pow2[TableSize];
-	double ValueTables::Pow3[TableSize];
-	double ValueTables::Pow4[TableSize];
-	double ValueTables::x2Pow3[TableSize];
-
-	// octave response. value double every step (2,3,4,5 or 6 steps)
-	double ValueTables::Response2Oct[TableSize];
-	double ValueTables::Response3Oct[TableSize];
-	double ValueTables::Response4Oct[TableSize];
-	double ValueTables::Response5Oct[TableSize];
-	double ValueTables::Response6Oct[TableSize];
-
-	// decade response, value multiplies by 10 every step
-	double ValueTables::Response2Dec[TableSize];
-	double ValueTables::Response3Dec[TableSize];
-	double ValueTables::Response4Dec[TableSize];
+	namespace
+	{
+		// One table, filled from f(x) for x = 0...1 when it is constructed
+		struct Table
+		{
+			double Values[ValueTables::TableSize];
+
+			template<typename F>
+			Table(F f)
+			{
+				for (int i = 0; i <= 4000; i++)
+					Values[i] = f(i / 4000.0);
+			}
+		};
+
+		// A response table, rescaled to run from 0 to 1
+		struct ResponseTable : Table
+		{
+			template<typename F>
+			ResponseTable(F f) : Table(f)
+			{
+				for (int i = 1; i <= 4000; i++)
+					Values[i] = (Values[i] - Values[0]) / (1 - Values[0]);
+
+				Values[0] = 0;
+			}
+		};
+	}
+
+	// Each table is a function local static, built on the first call
+	const double* ValueTables::Sqrt()
+	{
+		static const Table table([](double x) { return std::sqrt(x); });
+		return table.Values;
+	}
+
+	const double* ValueTables::Sqrt3()
+	{
+		static const Table table([](double x) { return std::pow(x, 1.0 / 3.0); });
+		return table.Values;
+	}
+
+	const double* ValueTables::Pow1_5()
+	{
+		static const Table table([](double x) { return std::pow(x, 1.5); });
+		return table.Values;
+	}
+
+	const double* ValueTables::Pow2()
+	{
+		static const Table table([](double x) { return std::pow(x, 2.0); });
+		return table.Values;
+	}
+
+	const double* ValueTables::Pow3()
+	{
+		static const Table table([](double x) { return std::pow(x, 3.0); });
+		return table.Values;
+	}
+
+	const double* ValueTables::Pow4()
+	{
+		static const Table table([](double x) { return std::pow(x, 4.0); });
+		return table.Values;
+	}
+
+	const double* ValueTables::x2Pow3()
+	{
+		static const Table table([](double x) { return std::pow(2 * x, 3.0); });
+		return table.Values;
+	}
+
+	const double* ValueTables::Response2Oct()
+	{
+		static const ResponseTable table([](double x) { return (std::pow(4, x) - 1.0) / 4.0 + 0.25; });
+		return table.Values;
+	}
+
+	const double* ValueTables::Response3Oct()
+	{
+		static const ResponseTable table([](double x) { return (std::pow(8, x) - 1.0) / 8.0 + 0.125; });
+		return table.Values;
+	}
+
+	const double* ValueTables::Response4Oct()
+	{
+		static const ResponseTable table([](double x) { return (std::pow(16, x) - 1.0) / 16.0 + 0.125 / 2.0; });
+		return table.Values;
+	}
+
+	const double* ValueTables::Response5Oct()
+	{
+		static const ResponseTable table([](double x) { return (std::pow(32, x) - 1.0) / 32.0 + 0.125 / 4.0; });
+		return table.Values;
+	}
+
+	const double* ValueTables::Response6Oct()
+	{
+		static const ResponseTable table([](double x) { return (std::pow(64, x) - 1.0) / 64.0 + 0.125 / 8.0; });
+		return table.Values;
+	}
+
+	const double* ValueTables::Response2Dec()
+	{
+		static const ResponseTable table([](double x) { return std::pow(100, x) / 100.0; });
+		return table.Values;
+	}
+
+	const double* ValueTables::Response3Dec()
+	{
+		static const ResponseTable table([](double x) { return std::pow(1000, x) / 1000.0; });
+		return table.Values;
+	}
+
+	const double* ValueTables::Response4Dec()
+	{
+		static const ResponseTable table([](double x) { return std::pow(10000, x) / 10000.0; });
+		return table.Values;
+	}
 
 	void ValueTables::Init()
 	{
-		// Initialize tables
+		Sqrt();
+		Sqrt3();
+		Pow1_5();
+		Pow2();
+		Pow3();
+		Pow4();
+		x2Pow3();
+		Response2Oct();
+		Response3Oct();
+		Response4Oct();
+		Response5Oct();
+		Response6Oct();
+		Response2Dec();
+		Response3Dec();
+		Response4Dec();
+	}
 
-		for (int i = 0; i <= 4000; i++)
-		{
-			double x = i / 4000.0;
-
-			Sqrt[i] = std::sqrt(x);
-			Sqrt3[i] = std::pow(x, 1.0 / 3.0);
-			Pow1_5[i] = std::pow(x, 1.5);
-			Pow2[i] = std::pow(x, 2.0);
-			Pow3[i] = std::pow(x, 3.0);
-			Pow4[i] = std::pow(x, 4.0);
-
-			x2Pow3[i] = std::pow(2 * x, 3.0);
-			Response2Oct[i] = (std::pow(4, x) - 1.0) / 4.0 + 0.25;
-			Response3Oct[i] = (std::pow(8, x) - 1.0) / 8.0 + 0.125;
-			Response4Oct[i] = (std::pow(16, x) - 1.0) / 16.0 + 0.125 / 2.0;
-			Response5Oct[i] = (std::pow(32, x) - 1.0) / 32.0 + 0.125 / 4.0;
-			Response6Oct[i] = (std::pow(64, x) - 1.0) / 64.0 + 0.125 / 8.0;
-
-			Response2Dec[i] = std::pow(100, x) / 100.0;
-			Response3Dec[i] = std::pow(1000, x) / 1000.0;
-			Response4Dec[i] = std::pow(10000, x) / 10000.0;
-		}
-
-		for (int i = 1; i <= 4000; i++)
-		{
-			Response2Oct[i] = (Response2Oct[i] - Response2Oct[0]) / (1 - Response2Oct[0]);
-			Response3Oct[i] = (Response3Oct[i] - Response3Oct[0]) / (1 - Response3Oct[0]);
-			Response4Oct[i] = (Response4Oct[i] - Response4Oct[0]) / (1 - Response4Oct[0]);
-			Response5Oct[i] = (Response5Oct[i] - Response5Oct[0]) / (1 - Response5Oct[0]);
-			Response6Oct[i] = (Response6Oct[i] - Response6Oct[0]) / (1 - Response6Oct[0]);
-			Response2Dec[i] = (Response2Dec[i] - Response2Dec[0]) / (1 - Response2Dec[0]);
-			Response3Dec[i] = (Response3Dec[i] - Response3Dec[0]) / (1 - Response3Dec[0]);
-			Response4Dec[i] = (Response4Dec[i] - Response4Dec[0]) / (1 - Response4Dec[0]);
-		}
-
-		Response2Oct[0] = 0;
-		Response3Oct[0] = 0;
-		Response4Oct[0] = 0;
-		Response5Oct[0] = 0;
-		Response6Oct[0] = 0;
-		Response2Dec[0] = 0;
-		Response3Dec[0] = 0;
-		Response4Dec[0] = 0;
-	}
-
-	double ValueTables::Get(double index, double* table)
+	double ValueTables::Get(double index, const double* table)
 	{
 		if (table == nullptr)
 			return index;
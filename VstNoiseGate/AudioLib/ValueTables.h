@@ -3,33 +3,38 @@
 
 namespace AudioLib
 {
+	/// <summary>
+	/// Lookup tables over 0...1, TableSize entries each. Every table is built the first time its accessor is called,
+	/// once per process and safe to reach from several threads at once, so a plugin only pays for the tables it uses
+	/// </summary>
 	class ValueTables
 	{
 	public:
 		static const int TableSize = 4001;
 
-		static double Sqrt[TableSize];
-		static double Sqrt3[TableSize];
-		static double Pow1_5[TableSize];
-		static double Pow2[TableSize];
-		static double Pow3[TableSize];
-		static double Pow4[TableSize];
-		static double x2Pow3[TableSize];
+		static const double* Sqrt();
+		static const double* Sqrt3();
+		static const double* Pow1_5();
+		static const double* Pow2();
+		static const double* Pow3();
+		static const double* Pow4();
+		static const double* x2Pow3();
 
 		// octave response. value double every step (2,3,4,5 or 6 steps)
-		static double Response2Oct[TableSize];
-		static double Response3Oct[TableSize];
-		static double Response4Oct[TableSize];
-		static double Response5Oct[TableSize];
-		static double Response6Oct[TableSize];
+		static const double* Response2Oct();
+		static const double* Response3Oct();
+		static const double* Response4Oct();
+		static const double* Response5Oct();
+		static const double* Response6Oct();
 
 		// decade response, value multiplies by 10 every step
-		static double Response2Dec[TableSize];
-		static double Response3Dec[TableSize];
-		static double Response4Dec[TableSize];
+		static const double* Response2Dec();
+		static const double* Response3Dec();
+		static const double* Response4Dec();
 
+		// Builds every table now, instead of on first use
 		static void Init();
-		static double Get(double index, double* table);
+		static double Get(double index, const double* table);
 	};
 }
 
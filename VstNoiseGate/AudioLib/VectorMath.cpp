@@ -0,0 +1,159 @@
+#include <cmath>
+
+#include "Simd.h"
+#include "SimdKernels.h"
+#include "Utils.h"
+#include "VectorMath.h"
+
+namespace AudioLib
+{
+	namespace
+	{
+		const float Log10Of2 = 0.301029995663981f;
+		const float Log2Of10 = 3.32192809488736f;
+
+		enum class Op { Log2, Exp2 };
+
+		inline int DegreeIndex(MathPrecision precision)
+		{
+			return precision == MathPrecision::Db01 ? 0 : 1;
+		}
+
+		/// <summary>
+		/// Log2: output = log2(input) * scale
+		/// Exp2: output = 2 ^ (input * scale)
+		/// On the kernels of the current SimdLevel
+		/// </summary>
+		template<Op op>
+		void Run(const float* input, float* output, int len, float scale, MathPrecision precision)
+		{
+			Simd::GetKernels().Float[(int)op][DegreeIndex(precision)](input, output, len, scale);
+		}
+
+		template<Op op>
+		void Run(const double* input, double* output, int len, float scale, MathPrecision precision)
+		{
+			Simd::GetKernels().Double[(int)op][DegreeIndex(precision)](input, output, len, scale);
+		}
+
+		template<Op op>
+		void Run(const double* input, float* output, int len, float scale, MathPrecision precision)
+		{
+			Simd::GetKernels().DoubleToFloat[(int)op][DegreeIndex(precision)](input, output, len, scale);
+		}
+	}
+
+	void VectorMath::Log2(const float* input, float* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = std::log2(input[i]);
+		else
+			Run<Op::Log2>(input, output, len, 1.0f, precision);
+	}
+
+	void VectorMath::Log2(const double* input, double* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = std::log2(input[i]);
+		else
+			Run<Op::Log2>(input, output, len, 1.0f, precision);
+	}
+
+	void VectorMath::Log10(const float* input, float* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = std::log10(input[i]);
+		else
+			Run<Op::Log2>(input, output, len, Log10Of2, precision);
+	}
+
+	void VectorMath::Log10(const double* input, double* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = std::log10(input[i]);
+		else
+			Run<Op::Log2>(input, output, len, Log10Of2, precision);
+	}
+
+	void VectorMath::Exp2(const float* input, float* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = std::exp2(input[i]);
+		else
+			Run<Op::Exp2>(input, output, len, 1.0f, precision);
+	}
+
+	void VectorMath::Exp2(const double* input, double* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = std::exp2(input[i]);
+		else
+			Run<Op::Exp2>(input, output, len, 1.0f, precision);
+	}
+
+	void VectorMath::Pow10(const float* input, float* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = std::pow(10.0f, input[i]);
+		else
+			Run<Op::Exp2>(input, output, len, Log2Of10, precision);
+	}
+
+	void VectorMath::Pow10(const double* input, double* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = std::pow(10.0, input[i]);
+		else
+			Run<Op::Exp2>(input, output, len, Log2Of10, precision);
+	}
+
+	void VectorMath::Gain2Db(const float* input, float* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = Utils::Gain2DB(input[i]);
+		else
+			Run<Op::Log2>(input, output, len, 20.0f * Log10Of2, precision);
+	}
+
+	void VectorMath::Gain2Db(const double* input, float* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = Utils::Gain2DB((float)input[i]);
+		else
+			Run<Op::Log2>(input, output, len, 20.0f * Log10Of2, precision);
+	}
+
+	void VectorMath::Gain2Db(const double* input, double* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = 20.0 * std::log10(input[i]);
+		else
+			Run<Op::Log2>(input, output, len, 20.0f * Log10Of2, precision);
+	}
+
+	void VectorMath::Db2Gain(const float* input, float* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = (float)Utils::DB2gain(input[i]);
+		else
+			Run<Op::Exp2>(input, output, len, Log2Of10 / 20.0f, precision);
+	}
+
+	void VectorMath::Db2Gain(const double* input, double* output, int len, MathPrecision precision)
+	{
+		if (precision == MathPrecision::Exact)
+			for (int i = 0; i < len; i++) output[i] = Utils::DB2gain(input[i]);
+		else
+			Run<Op::Exp2>(input, output, len, Log2Of10 / 20.0f, precision);
+	}
+
+	float VectorMath::MaxAbs(const float* input, int len)
+	{
+		return Simd::GetKernels().MaxAbsFloat(input, len);
+	}
+
+	double VectorMath::MaxAbs(const double* input, int len)
+	{
+		return Simd::GetKernels().MaxAbsDouble(input, len);
+	}
+}
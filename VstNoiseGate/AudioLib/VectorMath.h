@@ -0,0 +1,55 @@
+#ifndef AUDIOLIB_VECTORMATH
+#define AUDIOLIB_VECTORMATH
+
+namespace AudioLib
+{
+	/// <summary>
+	/// Accuracy of the VectorMath functions. The fast modes use a polynomial on the mantissa and
+	/// bit manipulation of the exponent, evaluated in single precision.
+	/// Measured maximum error, expressed in dB of the (log domain) result:
+	///   Db001: log2/log10 0.0051 dB, exp2/pow10 0.0013 dB  (3rd order polynomials)
+	///   Db01:  log2/log10 0.034 dB,  exp2/pow10 0.022 dB   (2nd order polynomials)
+	/// </summary>
+	enum class MathPrecision
+	{
+		Exact = 0, // standard library, one scalar call per element, not vectorized. Bit-identical to Utils::Gain2DB / Utils::DB2gain
+		           // per call; NoiseGateKernel follows its output gain incrementally in this mode, see GainRampT::Follow
+		Db001,     // better than 0.01 dB
+		Db01       // better than 0.1 dB
+	};
+
+	/// <summary>
+	/// Array versions of the log/exp functions used for dB conversions. Input and output may alias.
+	/// The fast modes run on the widest instruction set of the CPU, picked at runtime (see Simd), with a scalar
+	/// loop for the tail. Double arrays are evaluated in single precision in the fast modes.
+	/// Fast mode domain: log inputs must be >= 0, zero and denormals return about -127 (log2), -764 dB;
+	/// exp2 inputs are clamped to -125...127.
+	/// </summary>
+	class VectorMath
+	{
+	public:
+		static void Log2(const float* input, float* output, int len, MathPrecision precision);
+		static void Log2(const double* input, double* output, int len, MathPrecision precision);
+		static void Log10(const float* input, float* output, int len, MathPrecision precision);
+		static void Log10(const double* input, double* output, int len, MathPrecision precision);
+		static void Exp2(const float* input, float* output, int len, MathPrecision precision);
+		static void Exp2(const double* input, double* output, int len, MathPrecision precision);
+		static void Pow10(const float* input, float* output, int len, MathPrecision precision);
+		static void Pow10(const double* input, double* output, int len, MathPrecision precision);
+
+		// 20 * log10(x), in Exact mode identical to Utils::Gain2DB, except double to double which is computed in double precision
+		static void Gain2Db(const float* input, float* output, int len, MathPrecision precision);
+		static void Gain2Db(const double* input, float* output, int len, MathPrecision precision);
+		static void Gain2Db(const double* input, double* output, int len, MathPrecision precision);
+
+		// 10 ^ (x / 20), in Exact mode identical to Utils::DB2gain
+		static void Db2Gain(const float* input, float* output, int len, MathPrecision precision);
+		static void Db2Gain(const double* input, double* output, int len, MathPrecision precision);
+
+		// Largest absolute value of the array, 0 for an empty one. Exact, NaNs are ignored
+		static float MaxAbs(const float* input, int len);
+		static double MaxAbs(const double* input, int len);
+	};
+}
+
+#endif
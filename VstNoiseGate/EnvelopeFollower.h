@@ -2,12 +2,34 @@
 
 #include "AudioLib/Utils.h"
 #include "AudioLib/Biquad.h"
+#include "AudioLib/Butterworth.h"
+#include "AudioLib/Sos.h"
+#include "AudioLib/VectorMath.h"
 #include "Indicators.h"
 #include "AudioLib/OnePoleFilters.h"
+#include "Profiler.h"
 
 namespace NoiseInvader
 {
-	class EnvelopeFollower
+	/// <summary>
+	/// Lowpass that turns the hold signal into the envelope, both at 200Hz. OnePoleCascade, the default, is the original
+	/// smoother, four one pole lowpasses in series, with a soft corner and more delay. Butterworth is a 4th order
+	/// Butterworth: flat up to the cutoff and steep above it, so the envelope follows the hold more closely with less
+	/// ripple left on it. It sounds different and costs more than the cascade, so it has to be selected
+	/// </summary>
+	enum class HoldSmootherMode
+	{
+		Butterworth,
+		OnePoleCascade,
+	};
+
+	/// <summary>
+	/// Envelope follower over sample type T, float or double. Settings are given in double precision,
+	/// the filters and the state run in T. All state is held by value, nothing is allocated, and
+	/// Reconfigure() retunes it to another samplerate in place
+	/// </summary>
+	template<typename T>
+	class EnvelopeFollowerT
 	{
 	private:
 		const double InputFilterHpCutoff = 100.0;
@@ -16,101 +38,494 @@ namespace NoiseInvader
 		const double SmaPeriodSeconds = 0.01; // 10ms
 		const double TimeoutPeriodSeconds = 0.01; // 10ms
 		const double HoldSmootherFc = 200.0;
+		const int HoldSmootherOrder = 4;
+
+		// The Butterworth state is cleared once it has decayed below this, see SosCascadeT::ClearBelow. Far below
+		// anything the smallest float hold value (1e-38) contributes through the smallest lowpass gain at 384kHz.
+		// Double samples keep the whole tail, a floor of 0 never clears
+		const double HoldSmootherFloor = sizeof(T) == sizeof(float) ? 1e-80 : 0;
+		const double MovementLatchAlpha = 0.005;
+
+		// log2 units per dB, the decays are averaged in dB and exponentiated with Exp2
+		const double Log2PerDb = 0.16609640474436813;
+
+		// Settling, see GetSettleSamples: time constants until a filter has forgotten its start (under 1% left),
+		// and the range the hold may have to release over, from full scale to below the lowest threshold
+		const double SettleTimeConstants = 5.0;
+		const double HoldSettleRangeDb = 100.0;
 
 		double Fs;
 		double ReleaseMs;
 
-		AudioLib::Hp1 hpFilter;
-		AudioLib::Biquad* inputFilter;
-		Sma* sma;
-		Ema* ema;
-		EmaLatch* movementLatch;
+		// Averages, hold and smoother run at Fs / decimation, see SetDecimation
+		int decimation;
+		double controlFs;
 
-		int triggerCounterTimeoutSamples;
-		double slowDecay;
-		double fastDecay;
-		double holdAlpha;
+		AudioLib::Hp1T<T> hpFilter;
+		// direct form I in T, the filter of the reference chain, like GateBank's
+		AudioLib::BiquadT<T> inputFilter;
+		EmaT<T> ema;
+		EmaLatchT<T> movementLatch;
 
-		double hold;
+		int triggerCounterTimeoutSamples;
+		// the decay of the hold per control sample, in dB and as a factor, and its limits per sample of the full rate
+		T slowDbDecay;
+		T fastDbDecay;
+		T slowDecay;
+		T fastDecay;
+		T sampleSlowDbDecay;
+		T sampleFastDbDecay;
+		// 4th order Butterworth, accumulated in double precision: the poles sit close to z = 1 at high samplerates
+		typedef AudioLib::SosCascadeT<T, 2, double> ButterworthSmoother;
+		ButterworthSmoother holdSmoother;
+		T holdAlpha;
+		HoldSmootherMode smootherMode;
+
+		T hold;
 		int lastTriggerCounter;
-		double h1, h2, h3, h4;
-		double holdFiltered;
+		T h1, h2, h3, h4;
+		T holdFiltered;
+
+		// decimation: the two halves of the triangular window over the group in progress and the rising half of the last
+		// group, and the sum of the SMA's limited decays over the group in progress, with the count of its samples
+		T risingSum;
+		T fallingSum;
+		T lastRisingSum;
+		T decaySum;
+		int decimationPhase;
+		T decimationScale;
+		T windowScale;
+
+		AudioLib::MathPrecision precision;
+
+		// set once a silent block has left the state unchanged, see IsAtRest
+		bool atRest;
+
+	public:
+		// The block version processes in chunks of this many samples, the size of the scratch buffers
+		static const int BlockSize = 256;
+
+		// Largest factor SetDecimation takes
+		static const int MaxDecimation = 8;
+
+		/// <summary>
+		/// Everything the envelope depends on besides the settings: the filter memories, the averages, the hold and the
+		/// smoother. Plain data, the SMA window last as it is by far the largest part
+		/// </summary>
+		struct State
+		{
+			T HpFilter;
+			typename AudioLib::BiquadT<T>::State InputFilter;
+			T Ema;
+			typename EmaLatchT<T>::State MovementLatch;
+			T Hold;
+			int LastTriggerCounter;
+			typename ButterworthSmoother::State HoldSmoother;
+			T H1, H2, H3, H4;
+			T HoldFiltered;
+			T RisingSum, FallingSum, LastRisingSum, DecaySum;
+			int DecimationPhase;
+			typename SmaT<T>::State Sma;
+		};
+
+	private:
+		// Everything besides the SMA window, compared before and after a silent block to find the resting state
+		struct Scalars
+		{
+			T HpFilter;
+			typename AudioLib::BiquadT<T>::State InputFilter;
+			T Ema;
+			typename EmaLatchT<T>::State MovementLatch;
+			T Hold;
+			int LastTriggerCounter;
+			typename ButterworthSmoother::State HoldSmoother;
+			T H1, H2, H3, H4;
+			// the phase and the decay sum of the decimation are left out: in silence the sum only counts the samples of
+			// the group, see SkipSilence
+			T RisingSum, FallingSum, LastRisingSum;
+
+			bool operator==(const Scalars& other) const
+			{
+				return HpFilter == other.HpFilter
+					&& InputFilter.X1 == other.InputFilter.X1 && InputFilter.X2 == other.InputFilter.X2
+					&& InputFilter.Y1 == other.InputFilter.Y1 && InputFilter.Y2 == other.InputFilter.Y2
+					&& Ema == other.Ema
+					&& MovementLatch.Value == other.MovementLatch.Value && MovementLatch.CurrentValue == other.MovementLatch.CurrentValue
+					&& Hold == other.Hold && LastTriggerCounter == other.LastTriggerCounter
+					&& SameSmootherState(HoldSmoother, other.HoldSmoother)
+					&& H1 == other.H1 && H2 == other.H2 && H3 == other.H3 && H4 == other.H4
+					&& RisingSum == other.RisingSum && FallingSum == other.FallingSum && LastRisingSum == other.LastRisingSum;
+			}
+
+			static bool SameSmootherState(const typename ButterworthSmoother::State& a, const typename ButterworthSmoother::State& b)
+			{
+				if (a.Count != b.Count)
+					return false;
+
+				for (int i = 0; i < a.Count; i++)
+				{
+					auto& x = a.Sections[i];
+					auto& y = b.Sections[i];
+					if (x.S1 != y.S1 || x.S2 != y.S2 || x.Y1 != y.Y1)
+						return false;
+				}
+
+				return true;
+			}
+		};
+
+		alignas(32) T band[BlockSize];
+		alignas(32) T bandDb[BlockSize];
+		alignas(32) T emaValues[BlockSize];
+		alignas(32) T smaValues[BlockSize];
+		alignas(32) T smaDbDecay[BlockSize];
+		alignas(32) T smaDecay[BlockSize];
+		// the samples whose decay lies between the limits and is exponentiated
+		int decayIndex[BlockSize];
+		alignas(32) T movement[BlockSize];
+		alignas(32) T holdValues[BlockSize];
+		// the decimated band signal, the SMA, the movement and the decay at the end of each group, and the envelope, at
+		// most one value per two samples
+		alignas(32) T controlInput[BlockSize / 2];
+		alignas(32) T controlSma[BlockSize / 2];
+		alignas(32) T controlMovement[BlockSize / 2];
+		alignas(32) T controlDbDecay[BlockSize / 2];
+		alignas(32) T controlOutput[BlockSize / 2];
+
+#ifdef NOISEINVADER_PROFILING
+		KernelProfiler* profiler = nullptr;
+#endif
+
+		// largest member, kept last so the hot scalar state above shares cache lines
+		SmaT<T> sma;
 
 	public:
 
-		EnvelopeFollower(double fs, double releaseMs)
+		EnvelopeFollowerT(double fs, double releaseMs)
+			: inputFilter(AudioLib::BiquadT<T>::FilterType::LowPass, (int)fs)
+			, ema(0)
+			, movementLatch((T)MovementLatchAlpha, (T)0.2) // frequency dependent, but not really that critical...
+			, sma((int)(fs * SmaPeriodSeconds))
+		{
+			inputFilter.Frequency = (T)InputFilterCutoff;
+			inputFilter.SetQ(1);
+
+			ReleaseMs = releaseMs;
+			decimation = 1;
+			Reconfigure(fs);
+
+			precision = AudioLib::MathPrecision::Exact;
+			smootherMode = HoldSmootherMode::OnePoleCascade;
+			atRest = false;
+			hold = 0;
+			lastTriggerCounter = 0;
+			h1 = h2 = h3 = h4 = 0;
+			holdFiltered = 0;
+			risingSum = fallingSum = lastRisingSum = decaySum = 0;
+			decimationPhase = 0;
+		}
+
+		/// <summary>
+		/// Retunes every samplerate dependent coefficient and the length of the SMA window, in place.
+		/// The filter, average and hold state is kept, so the envelope continues across the change
+		/// </summary>
+		void Reconfigure(double fs)
 		{
 			Fs = fs;
-			double ts = 1.0 / fs;
+			atRest = false;
 
-			hpFilter.SetFc(InputFilterHpCutoff / (fs * 0.5));
+			hpFilter.SetFc((T)(InputFilterHpCutoff / (fs * 0.5)));
 
-			inputFilter = new AudioLib::Biquad(AudioLib::Biquad::FilterType::LowPass, fs);
-			inputFilter->Frequency = InputFilterCutoff;
-			inputFilter->SetQ(1.0f);
-			inputFilter->Update();
-			
-			auto emaAlpha = AudioLib::Utils::ComputeLpAlpha(EmaFc, ts);
+			inputFilter.SetSamplerate((int)fs);
 
-			double slowDbDecayPerSample = -60 / (3000 / 1000.0 * fs);
-			slowDecay = AudioLib::Utils::DB2gain(slowDbDecayPerSample);
+			ConfigureControlRate();
+		}
 
-			SetRelease(releaseMs);
+		/// <summary>
+		/// Runs the averages, the hold and the smoother on every factor-th sample, 1 (every sample, the default), 2, 4 or 8.
+		/// The band filter stays at the full rate. Its rectified output is decimated with a triangular window over the last
+		/// two groups of factor samples (a second order CIC), whose double nulls sit on the frequencies that would alias
+		/// to DC and into the envelope. The SMA gets the mean of the dB values of the group: its decay over the window then
+		/// adds up to the per sample decays of the full rate. Every time and frequency is rescaled to the lower rate, so
+		/// the envelope keeps its timing in ms within a group, at a fraction of the cost. The output holds each control value
+		/// over the following group; NoiseGateKernelT ramps the expander's gain between them. The state carries over:
+		/// the smoother settles at the current envelope and the window starts empty
+		/// </summary>
+		void SetDecimation(int factor)
+		{
+			factor = factor >= 8 ? 8 : factor >= 4 ? 4 : factor >= 2 ? 2 : 1;
+			if (factor == decimation)
+				return;
+
+			lastTriggerCounter = lastTriggerCounter * decimation / factor;
+			decimation = factor;
+			atRest = false;
+			ConfigureControlRate();
+
+			holdSmoother.SetSteadyState(holdFiltered);
+			risingSum = fallingSum = lastRisingSum = decaySum = 0;
+			decimationPhase = 0;
+		}
 
-			sma = new Sma((int)(fs * SmaPeriodSeconds));
-			ema = new Ema(emaAlpha);
-			movementLatch = new EmaLatch(0.005, 0.2); // frequency dependent, but not really that critical...
+		int GetDecimation() const
+		{
+			return decimation;
+		}
 
-			triggerCounterTimeoutSamples = (int)(fs * TimeoutPeriodSeconds);
+		// Samples of the group in progress, the output changes with the sample that completes it
+		int GetDecimationPhase() const
+		{
+			return decimationPhase;
+		}
 
-			holdAlpha = AudioLib::Utils::ComputeLpAlpha(HoldSmootherFc, ts);
+	private:
+		// The one pole alpha that decays as far in one control sample as alpha does in decimation samples of the full rate
+		double ControlAlpha(double alpha) const
+		{
+			return decimation == 1 ? alpha : 1 - std::pow(1 - alpha, decimation);
 		}
 
-		~EnvelopeFollower()
+		// Everything after the band filter and the SMA, designed for the control rate Fs / decimation
+		void ConfigureControlRate()
 		{
-			delete inputFilter;
-			delete sma;
-			delete ema;
-			delete movementLatch;
+			controlFs = Fs / decimation;
+			decimationScale = (T)(1.0 / decimation);
+			windowScale = (T)(1.0 / decimation / decimation);
+			double fs = controlFs;
+
+			// per control sample, the same time constant in seconds
+			ema.SetAlpha((T)ControlAlpha(AudioLib::Utils::ComputeLpAlpha(EmaFc, 1.0 / Fs)));
+
+			double slowDbDecayPerSample = -60 / (3000 / 1000.0 * fs);
+			slowDbDecay = (T)slowDbDecayPerSample;
+			slowDecay = (T)AudioLib::Utils::DB2gain(slowDbDecayPerSample);
+			sampleSlowDbDecay = (T)(-60 / (3000 / 1000.0 * Fs));
+
+			SetRelease(ReleaseMs);
+
+			// the SMA runs at the full rate, see SetDecimation
+			sma.SetLength((int)(Fs * SmaPeriodSeconds));
+			triggerCounterTimeoutSamples = (int)(fs * TimeoutPeriodSeconds);
+
+			AudioLib::Butterworth smootherDesign(fs);
+			smootherDesign.CutoffHz = HoldSmootherFc;
+			smootherDesign.Order = HoldSmootherOrder;
+			smootherDesign.Update();
+			holdSmoother.SetSections(smootherDesign.GetSections(), smootherDesign.GetSectionCount());
+			holdAlpha = (T)ControlAlpha(AudioLib::Utils::ComputeLpAlpha(HoldSmootherFc, 1.0 / Fs));
 		}
 
+	public:
 		void SetRelease(double releaseMs)
 		{
 			ReleaseMs = releaseMs;
-			double dbDecayPerSample = -60 / (ReleaseMs / 1000.0 * Fs);
-			fastDecay = AudioLib::Utils::DB2gain(dbDecayPerSample);
+			double dbDecayPerSample = -60 / (ReleaseMs / 1000.0 * controlFs);
+			fastDbDecay = (T)dbDecayPerSample;
+			fastDecay = (T)AudioLib::Utils::DB2gain(dbDecayPerSample);
+			sampleFastDbDecay = (T)(-60 / (ReleaseMs / 1000.0 * Fs));
 		}
 
-		double GetOutput()
+		// Accuracy of the dB conversion and the exponentiation of the decay
+		void SetPrecision(AudioLib::MathPrecision precision)
+		{
+			this->precision = precision;
+		}
+
+		/// <summary>
+		/// Selects the hold smoother. The one taking over starts settled at the current envelope, so the output
+		/// continues without a step; the state of the other one is left as it is
+		/// </summary>
+		void SetHoldSmoother(HoldSmootherMode mode)
+		{
+			if (mode == smootherMode)
+				return;
+
+			smootherMode = mode;
+			atRest = false;
+			if (mode == HoldSmootherMode::Butterworth)
+				holdSmoother.SetSteadyState(holdFiltered);
+			else
+				h1 = h2 = h3 = h4 = holdFiltered;
+		}
+
+		HoldSmootherMode GetHoldSmoother() const
+		{
+			return smootherMode;
+		}
+
+		// Stage timings of the block version go to this profiler. Does nothing unless NOISEINVADER_PROFILING is defined
+		void SetProfiler(KernelProfiler* profiler)
+		{
+#ifdef NOISEINVADER_PROFILING
+			this->profiler = profiler;
+#else
+			(void)profiler;
+#endif
+		}
+
+		/// <summary>
+		/// Samples of input after which a follower started from silence tracks one that has been running all along:
+		/// the band filters, the SMA window and the EMA / latch averages settle, the hold timeout runs out and the hold
+		/// releases over HoldSettleRangeDb, and the four pole smoother settles. The stages are in series, so the times add.
+		/// The movement latch has hysteresis and can stay apart for longer when the signal gives it no reason to flip
+		/// </summary>
+		int GetSettleSamples() const
+		{
+			double filters = SettleTimeConstants / (2 * M_PI * InputFilterHpCutoff) + SettleTimeConstants / (2 * M_PI * InputFilterCutoff);
+			double averages = SmaPeriodSeconds + SettleTimeConstants / (2 * M_PI * EmaFc) + SettleTimeConstants / MovementLatchAlpha / Fs;
+			double hold = TimeoutPeriodSeconds + HoldSettleRangeDb / 60 * ReleaseMs / 1000;
+			double smoother = 4 * SettleTimeConstants / (2 * M_PI * HoldSmootherFc);
+			double decimated = 2.0 * decimation / Fs;
+			return (int)std::ceil((filters + averages + hold + smoother + decimated) * Fs);
+		}
+
+		T GetOutput() const
 		{
 			return holdFiltered;
 		}
 
-		void ProcessEnvelope(double val)
+		/// <summary>
+		/// True once silence has brought the filters, averages, hold and smoother to a state that further silence leaves
+		/// unchanged. The envelope then stays at GetOutput() for as long as the input is silent, and a silent block
+		/// doesn't need to be processed: skipping it only leaves the SMA head elsewhere in a window of zeros
+		/// </summary>
+		bool IsAtRest() const
+		{
+			return atRest;
+		}
+
+		/// <summary>
+		/// Stands in for processing len samples of silence while IsAtRest(): the output stays where it is and only the
+		/// SMA head moves on, and the decay sum of the group counts the silent samples in it: the SMA is flat, so each
+		/// one decays at the slow limit
+		/// </summary>
+		void SkipSilence(int len)
+		{
+			decimationPhase = (int)((decimationPhase + (long long)len) % decimation);
+			decaySum = 0;
+			for (int i = 0; i < decimationPhase; i++)
+				decaySum += sampleSlowDbDecay;
+
+			sma.SkipSilence(len);
+		}
+
+		void GetState(State& state) const
+		{
+			state.HpFilter = hpFilter.GetState();
+			inputFilter.GetState(state.InputFilter);
+			state.Ema = ema.GetState();
+			movementLatch.GetState(state.MovementLatch);
+			state.Hold = hold;
+			state.LastTriggerCounter = lastTriggerCounter;
+			holdSmoother.GetState(state.HoldSmoother);
+			state.H1 = h1;
+			state.H2 = h2;
+			state.H3 = h3;
+			state.H4 = h4;
+			state.HoldFiltered = holdFiltered;
+			state.RisingSum = risingSum;
+			state.FallingSum = fallingSum;
+			state.LastRisingSum = lastRisingSum;
+			state.DecaySum = decaySum;
+			state.DecimationPhase = decimationPhase;
+			sma.GetState(state.Sma);
+		}
+
+		/// <summary>
+		/// Continues from a state taken at the same samplerate and decimation. Coefficients and settings are kept
+		/// </summary>
+		void SetState(const State& state)
+		{
+			hpFilter.SetState(state.HpFilter);
+			inputFilter.SetState(state.InputFilter);
+			ema.SetState(state.Ema);
+			movementLatch.SetState(state.MovementLatch);
+			hold = state.Hold;
+			lastTriggerCounter = state.LastTriggerCounter;
+			holdSmoother.SetState(state.HoldSmoother);
+			h1 = state.H1;
+			h2 = state.H2;
+			h3 = state.H3;
+			h4 = state.H4;
+			holdFiltered = state.HoldFiltered;
+			risingSum = state.RisingSum;
+			fallingSum = state.FallingSum;
+			lastRisingSum = state.LastRisingSum;
+			decaySum = state.DecaySum;
+			decimationPhase = state.DecimationPhase < decimation ? state.DecimationPhase : 0;
+			sma.SetState(state.Sma);
+			atRest = false;
+		}
+
+		void ProcessEnvelope(T val)
 		{
-			double combinedFiltered;
-			double decay;
+			atRest = false;
 
 			// 1. Rectify the input signal
 			val = std::abs(val);
 
 			// 2. Band pass filter to ~  100hz - 2Khz
 			val = hpFilter.Process(val);
-			auto lpValue = inputFilter->Process(val);
+			auto lpValue = inputFilter.Process(val);
 			//hpSignal = hipassAlpha * lpSignal + (1 - hipassAlpha) * hpSignal
 
 			// rectify the lpValue again, because the resonance in the filter can cause a tiny bit of ringing and cause the values to go negative again
 			lpValue = std::abs(lpValue);
 
-			auto mainInput = lpValue;
-
-			// 3. Compute the EMA and SMA of the band-filtered signal. Also compute the per-sample dB decay baed on the SMA
-			auto emaValue = ema->Update(mainInput);
-			auto smaValue = sma->Update(mainInput);
+			// 3. Compute the SMA of the band-filtered signal, always at the full rate. Also compute the per-sample dB decay based on the SMA
+			auto smaValue = sma.Update(lpValue, Db(lpValue));
+			T smaDbDecay = sma.GetDbDecayPerSample();
 
 			// 4. use a latching low-pass classifier to determine if signal strength is generally increasing or decreasing.
 			// This removes spike from the signal where the SMA may move in the opposite direction for a short period
-			auto movementValue = movementLatch->Update(sma->GetDbDecayPerSample() > 0);
+			auto movementValue = movementLatch.Update(smaDbDecay > 0);
+
+			if (decimation == 1)
+			{
+				// 1.2 is fudge factor to make the follower decay slightly faster than actual signal, so we gently bump into the peaks
+				ProcessControl(lpValue, smaValue, movementValue, smaDbDecay * (T)1.2);
+				return;
+			}
+
+			// 2.5 Decimate each group of samples to one for the control rate, see SetDecimation
+			T controlValue, dbDecay;
+			if (Accumulate(lpValue, smaDbDecay, controlValue, dbDecay))
+				ProcessControl(controlValue, smaValue, movementValue, dbDecay);
+		}
+
+	private:
+		/// <summary>
+		/// Adds a band sample and the SMA's decay at it to the group in progress. When it completes the group, returns true
+		/// with the control sample, the triangular window over the last two groups, and the decay of the group in dB: the
+		/// sum of the per sample decays, each with the fudge factor and the limits of the full rate
+		/// </summary>
+		inline bool Accumulate(T value, T smaDbDecay, T& windowed, T& dbDecay)
+		{
+			T sampleDbDecay = smaDbDecay * (T)1.2;
+			risingSum += value * (T)(decimationPhase + 1);
+			fallingSum += value * (T)(decimation - 1 - decimationPhase);
+			decaySum += sampleDbDecay >= sampleSlowDbDecay ? sampleSlowDbDecay : sampleDbDecay <= sampleFastDbDecay ? sampleFastDbDecay : sampleDbDecay;
+			if (++decimationPhase < decimation)
+				return false;
+
+			windowed = (lastRisingSum + fallingSum) * windowScale;
+			dbDecay = decaySum;
+			lastRisingSum = risingSum;
+			risingSum = fallingSum = decaySum = 0;
+			decimationPhase = 0;
+			return true;
+		}
+
+		/// <summary>
+		/// Steps 5 - 8 of ProcessEnvelope, once per sample of the control rate: the input of the EMA, the SMA, the latched
+		/// movement and the decay in dB, at the end of the group when decimated
+		/// </summary>
+		void ProcessControl(T mainInput, T smaValue, T movementValue, T dbDecay)
+		{
+			T combinedFiltered;
+			T decay;
+
+			auto emaValue = ema.Update(mainInput);
 
 			// 5. If the movement is going up, prefer the faster moving EMA signal if it's above the SMA
 			// If the movement is going down, prefer the faster moving EMA signal if it's below the SMA
@@ -132,29 +547,298 @@ namespace NoiseInvader
 			// The reason for this is so that we gently bump into the peaks of the signal once in a while.
 			// If the hold mechanism hasn't been triggered for a specific timeout, then the current hold value is too high, and we need to rapidly decay downwards.
 			// Use the fastDecay (based on the user- specified release value) as a slew limited value
+			// 7.5 Limit the decay speed in the general range of slowDecay...fastDecay, the slow decay is currently a fixed 3 seconds to -60dB value.
+			// Limited in dB, so only a decay between the two is exponentiated
 			if (lastTriggerCounter > triggerCounterTimeoutSamples)
+			{
 				decay = fastDecay;
+			}
 			else
-				decay = AudioLib::Utils::DB2gain(sma->GetDbDecayPerSample() * 1.2); // 1.2 is fudge factor to make the follower decay slightly faster than actual signal, so we gently bump into the peaks
-
-			// 7.5 Limit the decay speed in the general range of slowDecay...fastDecay, the slow decay is currently a fixed 3 seconds to -60dB value
-			if (decay > slowDecay)
-				decay = slowDecay;
-			if (decay < fastDecay)
-				decay = fastDecay;
+			{
+				if (dbDecay >= slowDbDecay)
+					decay = slowDecay;
+				else if (dbDecay <= fastDbDecay)
+					decay = fastDecay;
+				else
+				{
+					T log2Decay = dbDecay * (T)Log2PerDb;
+					AudioLib::VectorMath::Exp2(&log2Decay, &decay, 1, precision);
+				}
+			}
 
 			hold = hold * decay;
 
-			// 8. Filter the resulting hold signal to retrieve a smooth envelope.
-			// Currently using 4x 1 pole lowpass, should replace with a proper 4th order butterworth
-			h1 = holdAlpha * hold + (1 - holdAlpha) * h1;
-			h2 = holdAlpha * h1 + (1 - holdAlpha) * h2;
-			h3 = holdAlpha * h2 + (1 - holdAlpha) * h3;
-			h4 = holdAlpha * h3 + (1 - holdAlpha) * h4;
+			// 8. Filter the resulting hold signal to retrieve a smooth envelope, with the selected lowpass. The Butterworth
+			// overshoots a little and can ring below zero after a short burst, the envelope can't
+			if (smootherMode == HoldSmootherMode::Butterworth)
+			{
+				auto smoothed = holdSmoother.Process(hold);
+				holdFiltered = smoothed > 0 ? smoothed : 0;
+				holdSmoother.ClearBelow(HoldSmootherFloor);
+			}
+			else
+			{
+				h1 = holdAlpha * hold + (1 - holdAlpha) * h1;
+				h2 = holdAlpha * h1 + (1 - holdAlpha) * h2;
+				h3 = holdAlpha * h2 + (1 - holdAlpha) * h3;
+				h4 = holdAlpha * h3 + (1 - holdAlpha) * h4;
+				holdFiltered = h4;
+			}
+
+			// saturate, the counter only matters up to the timeout and would otherwise wrap after a few hours
+			if (lastTriggerCounter <= triggerCounterTimeoutSamples)
+				lastTriggerCounter++;
+		}
+
+		// The SMA's dB value of a band sample, the same as the block version computes
+		inline T Db(T value) const
+		{
+			T db;
+			AudioLib::VectorMath::Gain2Db(&value, &db, 1, precision);
+			return db < -150 ? -150 : db;
+		}
+
+	public:
+		/// <summary>
+		/// Block version of ProcessEnvelope, writes the envelope of each input sample to output.
+		/// Produces exactly the same result as calling ProcessEnvelope() for each sample, but runs every stage
+		/// as a separate pass over the block: the stateless stages (rectify, dB conversion, exponentiating the
+		/// decays between the limits) become vectorizable loops, the filters and the hold logic stay as tight
+		/// recurrences. Both versions convert with VectorMath at the same precision and limit the decay in dB.
+		/// </summary>
+		void ProcessEnvelope(const T* input, T* output, int len)
+		{
+			for (int pos = 0; pos < len; pos += BlockSize)
+			{
+				int count = len - pos < BlockSize ? len - pos : BlockSize;
+				ProcessBlock(&input[pos], &output[pos], count);
+			}
+		}
+
+	private:
+
+		void GetScalars(Scalars& scalars) const
+		{
+			scalars.HpFilter = hpFilter.GetState();
+			inputFilter.GetState(scalars.InputFilter);
+			scalars.Ema = ema.GetState();
+			movementLatch.GetState(scalars.MovementLatch);
+			scalars.Hold = hold;
+			scalars.LastTriggerCounter = lastTriggerCounter;
+			holdSmoother.GetState(scalars.HoldSmoother);
+			scalars.H1 = h1;
+			scalars.H2 = h2;
+			scalars.H3 = h3;
+			scalars.H4 = h4;
+			scalars.RisingSum = risingSum;
+			scalars.FallingSum = fallingSum;
+			scalars.LastRisingSum = lastRisingSum;
+		}
+
+		void ProcessBlock(const T* input, T* output, int len)
+		{
+			T inputPeak = 0;
+			Scalars before;
+			GetScalars(before);
+
+			{
+				NOISEINVADER_PROFILE(profiler, ProfileStage::DetectorFilter);
+
+				// 1. Rectify
+				for (int i = 0; i < len; i++)
+				{
+					band[i] = std::abs(input[i]);
+					inputPeak = band[i] > inputPeak ? band[i] : inputPeak;
+				}
+
 
-			holdFiltered = h4;
-			lastTriggerCounter++;
+				// 2. Band pass filter, then rectify again to remove the ringing from the biquad
+				hpFilter.Process(band, band, len);
+				inputFilter.Process(band, band, len);
+
+				for (int i = 0; i < len; i++)
+					band[i] = std::abs(band[i]);
+			}
+
+			{
+				NOISEINVADER_PROFILE(profiler, ProfileStage::Averages);
+
+				// 3. SMA at the full rate, the dB conversion needed for its decay is done as its own pass
+				AudioLib::VectorMath::Gain2Db(band, bandDb, len, precision);
+				for (int i = 0; i < len; i++)
+					bandDb[i] = bandDb[i] < -150 ? -150 : bandDb[i];
+
+				sma.Update(band, bandDb, smaValues, smaDbDecay, len);
+
+				// 4. movement classifier, at the full rate as well
+				movementLatch.Update(smaDbDecay, movement, len);
+			}
+
+			int controlCount = len;
+			if (decimation == 1)
+			{
+				// the decay with the fudge factor, see ProcessEnvelope(T)
+				for (int i = 0; i < len; i++)
+					smaDbDecay[i] = smaDbDecay[i] * (T)1.2;
+
+				ProcessControl(band, smaValues, movement, smaDbDecay, output, len);
+				holdFiltered = output[len - 1];
+			}
+			else
+			{
+				// 2.5 - 8. at the control rate, then each control value held over the next group, see ProcessEnvelope(T)
+				T previous = holdFiltered;
+				int phase = decimationPhase;
+				{
+					NOISEINVADER_PROFILE(profiler, ProfileStage::Averages);
+					controlCount = Decimate(len);
+				}
+
+				ProcessControl(controlInput, controlSma, controlMovement, controlDbDecay, controlOutput, controlCount);
+				if (controlCount > 0)
+					holdFiltered = controlOutput[controlCount - 1];
+
+				Hold(previous, phase, output, len);
+			}
+
+			atRest = false;
+			if (inputPeak == 0)
+			{
+				Scalars after;
+				GetScalars(after);
+				// a silent block only shows the control rate chain at rest if it ran, and the ramp must have come to an end
+				atRest = after == before && sma.IsSilent() && controlCount > 0;
+			}
 		}
 
+		// Decimates each complete group of the band samples and the SMA into the control buffers and returns their number
+		int Decimate(int len)
+		{
+			int count = 0;
+			for (int i = 0; i < len; i++)
+			{
+				if (Accumulate(band[i], smaDbDecay[i], controlInput[count], controlDbDecay[count]))
+				{
+					controlSma[count] = smaValues[i];
+					controlMovement[count] = movement[i];
+					count++;
+				}
+			}
+
+			return count;
+		}
+
+		// Each control value over the group after the one it was decimated from, starting at phase with the previous value
+		void Hold(T previous, int phase, T* output, int len)
+		{
+			int next = 0;
+			T value = previous;
+			for (int i = 0; i < len; i++)
+			{
+				if (++phase == decimation)
+				{
+					phase = 0;
+					value = controlOutput[next++];
+				}
+
+				output[i] = value;
+			}
+		}
+
+		/// <summary>
+		/// Steps 5 - 8 over a block at the control rate, see ProcessControl(T, T, T, T): the input of the EMA, the SMA, the
+		/// latched movement and the decay in dB. The decays are overwritten
+		/// </summary>
+		void ProcessControl(const T* input, const T* smaValues, const T* movement, T* dbDecay, T* output, int len)
+		{
+			{
+				NOISEINVADER_PROFILE(profiler, ProfileStage::Averages);
+				ema.Update(input, emaValues, len);
+			}
+
+			{
+				NOISEINVADER_PROFILE(profiler, ProfileStage::HoldDecay);
+
+				// 7. - 7.5 (precomputed) the SMA based decay for every sample, limited in dB like ProcessControl(T, T, T, T).
+				// The samples between the limits are gathered into the front of dbDecay, in log2 units, and exponentiated in one
+				// pass, so the hold loop only has to pick the decay or the fast decay
+				int count = 0;
+				for (int i = 0; i < len; i++)
+				{
+					T sampleDbDecay = dbDecay[i];
+					bool slow = sampleDbDecay >= slowDbDecay;
+					bool limited = slow || sampleDbDecay <= fastDbDecay;
+					smaDecay[i] = slow ? slowDecay : fastDecay;
+					dbDecay[count] = sampleDbDecay * (T)Log2PerDb;
+					decayIndex[count] = i;
+					count += !limited;
+				}
+
+				AudioLib::VectorMath::Exp2(dbDecay, dbDecay, count, precision);
+				for (int i = 0; i < count; i++)
+					smaDecay[decayIndex[i]] = dbDecay[i];
+
+				// 5. - 7 see ProcessEnvelope(T)
+				for (int i = 0; i < len; i++)
+				{
+					T combinedFiltered;
+					T decay;
+					auto emaValue = emaValues[i];
+					auto smaValue = smaValues[i];
+
+					if (movement[i] > 0)
+						combinedFiltered = emaValue > smaValue ? emaValue : smaValue;
+					else
+						combinedFiltered = emaValue < smaValue ? emaValue : smaValue;
+
+					if (combinedFiltered > hold)
+					{
+						hold = combinedFiltered;
+						lastTriggerCounter = 0;
+					}
+
+					decay = lastTriggerCounter > triggerCounterTimeoutSamples ? fastDecay : smaDecay[i];
+					hold = hold * decay;
+					holdValues[i] = hold;
+
+					if (lastTriggerCounter <= triggerCounterTimeoutSamples)
+						lastTriggerCounter++;
+				}
+			}
+
+			{
+				NOISEINVADER_PROFILE(profiler, ProfileStage::Smoother);
+
+				// 8. smoother, as its own pass over the hold values
+				if (smootherMode == HoldSmootherMode::Butterworth)
+				{
+					holdSmoother.Process(holdValues, output, len);
+					for (int i = 0; i < len; i++)
+						output[i] = output[i] > 0 ? output[i] : 0;
+					holdSmoother.ClearBelow(HoldSmootherFloor);
+				}
+				else
+				{
+					// in locals, output could alias the members and would keep them out of registers
+					T alpha = holdAlpha;
+					T y1 = h1, y2 = h2, y3 = h3, y4 = h4;
+					for (int i = 0; i < len; i++)
+					{
+						y1 = alpha * holdValues[i] + (1 - alpha) * y1;
+						y2 = alpha * y1 + (1 - alpha) * y2;
+						y3 = alpha * y2 + (1 - alpha) * y3;
+						y4 = alpha * y3 + (1 - alpha) * y4;
+						output[i] = y4;
+					}
+
+					h1 = y1;
+					h2 = y2;
+					h3 = y3;
+					h4 = y4;
+				}
+			}
+		}
 	};
+
+	typedef EnvelopeFollowerT<float> EnvelopeFollower;
 }
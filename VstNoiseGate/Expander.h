@@ -4,31 +4,41 @@
 
 namespace NoiseInvader
 {
-	class Expander
+	// T is the sample type, float or double
+	template<typename T>
+	class ExpanderT
 	{
 	private:
 
-		double prevInDb = -150.0;
-		double outputDb = -150.0;
-		double gainDb = 0.0;
+		T prevInDb = -150;
+		T outputDb = -150;
+		T gainDb = 0;
 
-		double reductionDb;
-		double upperSlope;
-		double lowerSlope;
-		double thresholdDb;
+		T reductionDb;
+		T upperSlope;
+		T lowerSlope;
+		T thresholdDb;
 
 	public:
-		Expander()
+		// The input and output levels the hysteresis continues from, and the last gain
+		struct State
 		{
-			Update(-20, -100, 2.0);
+			T PrevInDb;
+			T OutputDb;
+			T GainDb;
+		};
+
+		ExpanderT()
+		{
+			Update(-20, -100, 2);
 		}
 
-		~Expander()
+		~ExpanderT()
 		{
 
 		}
 
-		void Update(double thresholdDb, double reductionDb, double slope)
+		void Update(T thresholdDb, T reductionDb, T slope)
 		{
 			this->thresholdDb = thresholdDb;
 			this->reductionDb = reductionDb;
@@ -36,16 +46,44 @@ namespace NoiseInvader
 			lowerSlope = slope * 2;
 		}
 
-		inline double GetOutput()
+		inline T GetOutput() const
 		{
 			return gainDb;
 		}
 
-		void Expand(double dbVal)
+		void GetState(State& state) const
+		{
+			state.PrevInDb = prevInDb;
+			state.OutputDb = outputDb;
+			state.GainDb = gainDb;
+		}
+
+		void SetState(const State& state)
+		{
+			prevInDb = state.PrevInDb;
+			outputDb = state.OutputDb;
+			gainDb = state.GainDb;
+		}
+
+		void Expand(T dbVal)
 		{
-			if (isnan(outputDb) || isinf(outputDb))
+			if (std::isnan(outputDb) || std::isinf(outputDb))
 				outputDb = -150;
 
+			// digital silence produces -inf, which would turn dbChange into NaN and poison the output
+			if (!(dbVal > -150))
+				dbVal = -150;
+
+			// 0. Above the knees of both curves they are the identity and the gate is fully open. Taken as such, so the
+			// gain is exactly 0dB rather than the rounding error of the two curves, and the kernel can pass the signal through
+			if (dbVal >= thresholdDb + 8)
+			{
+				outputDb = dbVal;
+				prevInDb = dbVal;
+				gainDb = reductionDb > 0 ? reductionDb : 0;
+				return;
+			}
+
 			// 1. The two expansion curve form the upper and lower boundary of what the permitted "desired dB" value will be
 			auto upperDb = Compress(dbVal, thresholdDb, upperSlope, 4, true);
 			auto lowerDb = Compress(dbVal, thresholdDb + 4, lowerSlope, 4, true);
@@ -76,15 +114,140 @@ namespace NoiseInvader
 			gainDb = gainDiff;
 		}
 
+		/// <summary>
+		/// Block version, writes the gain in dB for each input value
+		/// </summary>
+		void Expand(const T* dbVal, T* gainDbOut, int len)
+		{
+			for (int i = 0; i < len; i++)
+			{
+				Expand(dbVal[i]);
+				gainDbOut[i] = gainDb;
+			}
+		}
+
+		/// <summary>
+		/// Block version for an input that stays at dbVal. With a constant input the state stops changing after one or
+		/// two samples; from then on the gain is written without evaluating the curves. Returns the first sample of
+		/// that constant stretch, len if the state never settled
+		/// </summary>
+		int ExpandConstant(T dbVal, T* gainDbOut, int len)
+		{
+			int settled = len;
+			for (int i = 0; i < len; i++)
+			{
+				T prevOutputDb = outputDb;
+				T prevPrevInDb = prevInDb;
+				Expand(dbVal);
+				gainDbOut[i] = gainDb;
+				if (outputDb == prevOutputDb && prevInDb == prevPrevInDb)
+				{
+					settled = i;
+					break;
+				}
+			}
+
+			for (int i = settled + 1; i < len; i++)
+				gainDbOut[i] = gainDb;
+
+			return settled;
+		}
+
+		/// <summary>
+		/// Block version with the same result as Expand(dbVal, gainDbOut, len) bit for bit, with shortcuts for the two
+		/// steady states. A block entirely above the knees of both curves (fully open) has one gain and only its last
+		/// sample decides the state, so no sample is evaluated. Below the knees of both curves the curves are straight
+		/// lines, so the hysteresis runs without the knee logic. Returns true if every gain of the block is the same
+		/// </summary>
+		bool ExpandSteady(const T* dbVal, T* gainDbOut, int len)
+		{
+			// the bounds as Expand and Compress compute them, so each sample takes the same branch
+			T openDb = thresholdDb + 8;
+			T lowerThresholdDb = thresholdDb + 4;
+			T upperKneeLow = thresholdDb - 4;
+			T lowerKneeLow = lowerThresholdDb - 4;
+
+			int notOpen = 0;
+			int notBelow = 0;
+			for (int i = 0; i < len; i++)
+			{
+				T x = dbVal[i] > -150 ? dbVal[i] : -150;
+				notOpen += !(x >= openDb);
+				notBelow += !(x <= upperKneeLow && x <= lowerKneeLow);
+			}
+
+			if (len > 0 && notOpen == 0)
+			{
+				T last = dbVal[len - 1] > -150 ? dbVal[len - 1] : -150;
+				outputDb = prevInDb = last;
+				gainDb = reductionDb > 0 ? reductionDb : 0;
+				for (int i = 0; i < len; i++)
+					gainDbOut[i] = gainDb;
+
+				return true;
+			}
+
+			if (len == 0 || notBelow > 0)
+			{
+				Expand(dbVal, gainDbOut, len);
+				return false;
+			}
+
+			if (std::isnan(outputDb) || std::isinf(outputDb))
+				outputDb = -150;
+
+			// Compress below the knee: x * ratio - (threshold * ratio - threshold)
+			T upperOffset = thresholdDb * upperSlope - thresholdDb;
+			T lowerOffset = lowerThresholdDb * lowerSlope - lowerThresholdDb;
+			T output = outputDb;
+			T prevIn = prevInDb;
+			T gain = gainDb;
+			bool constant = true;
+			for (int i = 0; i < len; i++)
+			{
+				T x = dbVal[i] > -150 ? dbVal[i] : -150;
+				T upperDb = x * upperSlope - upperOffset;
+				T lowerDb = x * lowerSlope - lowerOffset;
+				T desiredDb = output + (x - prevIn);
+				desiredDb = desiredDb < lowerDb ? lowerDb : desiredDb > upperDb ? upperDb : desiredDb;
+				output = desiredDb;
+				prevIn = x;
+
+				T gainDiff = output - x;
+				gain = gainDiff < reductionDb ? reductionDb : gainDiff;
+				gainDbOut[i] = gain;
+				constant &= gain == gainDbOut[0];
+			}
+
+			outputDb = output;
+			prevInDb = prevIn;
+			gainDb = gain;
+			return constant;
+		}
+
+		/// <summary>
+		/// Block version with per-sample settings, used while the settings are being smoothed.
+		/// The settings of the last sample remain in effect afterwards
+		/// </summary>
+		void Expand(const T* dbVal, const T* thresholdDb, const T* reductionDb, const T* slope, T* gainDbOut, int len)
+		{
+			for (int i = 0; i < len; i++)
+			{
+				Update(thresholdDb[i], reductionDb[i], slope[i]);
+				Expand(dbVal[i]);
+				gainDbOut[i] = gainDb;
+			}
+		}
+
 	private:
 
 		/// <summary>
 		/// Given an input dB value, will compress or expand it according to the parameters specified
 		/// </summary>
-		static double Compress(double x, double threshold, double ratio, double knee, bool expand)
+		static T Compress(T x, T threshold, T ratio, T knee, bool expand)
 		{
 			// the assumed gain
-			double output;
+			T output;
 			auto kneeLow = threshold - knee;
 			auto kneeHigh = threshold + knee;
 
@@ -123,4 +286,6 @@ namespace NoiseInvader
 			return output;
 		}
 	};
+
+	typedef ExpanderT<float> Expander;
 }
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <cmath>
+#include "AudioLib/Utils.h"
+
+namespace NoiseInvader
+{
+	/// <summary>
+	/// Turns a gain in dB into a gain factor per sample without exponentiating every sample. Each sample's gain is the
+	/// last one times the ratio of the change, 10 ^ (change / 20), from a short series that is accurate to a few 1e-7 for
+	/// the changes a slew limiter makes. Start and Process ramp a gain computed once every interval samples linearly in dB,
+	/// so with one ratio per step, applied Lanes samples at a time from its precomputed powers. Follow takes a gain that
+	/// moves every sample. Both come back to the exact gain periodically: at the end of each step, after MaxInterval moving
+	/// samples and whenever the gain stops moving, so the rounding of the multiplies never carries over and a steady gain
+	/// is exactly DB2gain of it, 1 when the gate is open.
+	/// T is the sample type, float or double
+	/// </summary>
+	template<typename T>
+	class GainRampT
+	{
+	public:
+		static const int MaxInterval = 64;
+
+		// Samples of a step computed from one base gain, each as base * ratio ^ (lane + 1)
+		static const int Lanes = 8;
+
+		// Largest change per sample the series is used for, larger ones are exponentiated
+		static constexpr double MaxSeriesDb = 3.0;
+
+		// The step in progress, plain data for kernel snapshots
+		struct State
+		{
+			int Length;
+			int Remaining;
+			T StartDb;
+			T DeltaDb;
+			T EndDb;
+			T Gain;
+			double Ratio;
+			T EndGain;
+			int Drift;
+		};
+
+	private:
+		int interval;
+
+		// samples in the step in progress and the ones of it still to come, 0 when the next sample starts a step
+		int length;
+		int remaining;
+
+		T startDb;
+		T deltaDb;
+		T endDb;
+		// within a step, the gain at the last multiple of Lanes samples
+		T gain;
+		// in double for both sample types, a step multiplies it up to MaxInterval times
+		double ratio;
+		T endGain;
+		// ratio ^ 1 ... ratio ^ Lanes
+		alignas(32) T powers[Lanes];
+
+		// moving samples Follow has multiplied since the gain was last exact
+		int drift;
+
+	public:
+		GainRampT()
+		{
+			interval = 1;
+			Reset(0);
+		}
+
+		// Samples per step, 1 - MaxInterval. A step in progress keeps its length
+		void SetInterval(int interval)
+		{
+			this->interval = interval < 1 ? 1 : interval > MaxInterval ? MaxInterval : interval;
+		}
+
+		int GetInterval() const
+		{
+			return interval;
+		}
+
+		// Ends the step in progress and settles on gainDb, the next sample starts a step from there
+		void Reset(T gainDb)
+		{
+			length = interval;
+			remaining = 0;
+			startDb = endDb = gainDb;
+			deltaDb = 0;
+			gain = endGain = (T)AudioLib::Utils::DB2gain(gainDb);
+			SetRatio(1);
+			drift = 0;
+		}
+
+		// The gain in dB the ramp has reached, or the step in progress ends on
+		inline T GetLevel() const
+		{
+			return endDb;
+		}
+
+		inline bool IsStepDone() const
+		{
+			return remaining == 0;
+		}
+
+		// True if the step in progress holds the gain where it is
+		inline bool IsFlat() const
+		{
+			return deltaDb == 0 && startDb == endDb;
+		}
+
+		/// <summary>
+		/// Starts the next step of interval samples, changing by deltaDb per sample from the end of the last one. The last
+		/// sample of the step is set to gainDb, normally the last one's end plus interval * deltaDb
+		/// </summary>
+		void Start(T deltaDb, T gainDb)
+		{
+			length = remaining = interval;
+			startDb = endDb;
+			this->deltaDb = deltaDb;
+			endDb = gainDb;
+
+			if (!IsFlat())
+			{
+				SetRatio(Ratio((double)deltaDb));
+				endGain = (T)AudioLib::Utils::DB2gain(gainDb);
+			}
+			else
+			{
+				SetRatio(1);
+			}
+		}
+
+		/// <summary>
+		/// Writes the gain in dB and as a factor for the samples of the step in progress, at most len. Returns the number of
+		/// samples written, call Start again once IsStepDone(). The gain factors are independent multiplies of the base gain by
+		/// the powers of the ratio, rebased every Lanes samples of the step, so the rounding only builds up once per Lanes samples
+		/// and the groups fall on the same samples however the step is split into calls
+		/// </summary>
+		int Process(T* gainDbOut, T* gainOut, int len)
+		{
+			int count = remaining < len ? remaining : len;
+			int pos = length - remaining;
+
+			for (int i = 0; i < count; i++)
+				gainDbOut[i] = startDb + (T)(pos + i + 1) * deltaDb;
+
+			// the rest of a group an earlier call started, then whole groups, then the start of the next one
+			int lane = pos % Lanes;
+			int i = 0;
+			if (lane > 0)
+			{
+				for (; i < count && lane + i < Lanes; i++)
+					gainOut[i] = gain * powers[lane + i];
+				if (lane + i == Lanes)
+					gain = gainOut[i - 1];
+			}
+
+			for (; i + Lanes <= count; i += Lanes)
+			{
+				T base = gain;
+				for (int j = 0; j < Lanes; j++)
+					gainOut[i + j] = base * powers[j];
+				gain = gainOut[i + Lanes - 1];
+			}
+
+			for (int j = 0; i < count; i++, j++)
+				gainOut[i] = gain * powers[j];
+
+			remaining -= count;
+			if (remaining == 0 && count > 0)
+			{
+				gain = endGain;
+				gainDbOut[count - 1] = endDb;
+				gainOut[count - 1] = endGain;
+			}
+
+			return count;
+		}
+
+		/// <summary>
+		/// Writes the gain factor of every sample of gainDb, a gain that may move on every sample, continuing from the last
+		/// gain this ramp ended on. Returns true if the whole block got the same gain. Only for an interval of 1, where no
+		/// step is in progress
+		/// </summary>
+		bool Follow(const T* gainDb, T* gainOut, int len)
+		{
+			for (int i = 0; i < len; i++)
+			{
+				T level = gainDb[i];
+				if (level != endDb)
+				{
+					T deltaDb = level - endDb;
+					if (++drift >= MaxInterval || std::abs(deltaDb) > (T)MaxSeriesDb)
+					{
+						gain = (T)AudioLib::Utils::DB2gain(level);
+						drift = 0;
+					}
+					else
+					{
+						gain *= Ratio(deltaDb);
+					}
+
+					endDb = level;
+				}
+				else if (drift > 0)
+				{
+					gain = (T)AudioLib::Utils::DB2gain(level);
+					drift = 0;
+				}
+
+				gainOut[i] = gain;
+			}
+
+			startDb = endDb;
+			endGain = gain;
+
+			bool flat = true;
+			for (int i = 0; i < len; i++)
+				flat &= gainOut[i] == gainOut[0];
+
+			return flat;
+		}
+
+		void GetState(State& state) const
+		{
+			state.Length = length;
+			state.Remaining = remaining;
+			state.StartDb = startDb;
+			state.DeltaDb = deltaDb;
+			state.EndDb = endDb;
+			state.Gain = gain;
+			state.Ratio = ratio;
+			state.EndGain = endGain;
+			state.Drift = drift;
+		}
+
+		void SetState(const State& state)
+		{
+			length = state.Length;
+			remaining = state.Remaining >= 0 && state.Remaining <= state.Length ? state.Remaining : 0;
+			startDb = state.StartDb;
+			deltaDb = state.DeltaDb;
+			endDb = state.EndDb;
+			gain = state.Gain;
+			SetRatio(state.Ratio);
+			endGain = state.EndGain;
+			drift = state.Drift;
+		}
+
+	private:
+		// The powers are multiplied out in double, so each is rounded once
+		void SetRatio(double ratio)
+		{
+			this->ratio = ratio;
+			double power = 1;
+			for (int i = 0; i < Lanes; i++)
+			{
+				power *= ratio;
+				powers[i] = (T)power;
+			}
+		}
+
+		// 10 ^ (deltaDb / 20), a series in x = deltaDb * ln(10) / 20 up to x^6, below 1e-7 off for changes up to MaxSeriesDb
+		// Follow computes it in T, a step in double
+		template<typename TMath>
+		static inline TMath Ratio(TMath deltaDb)
+		{
+			if (std::abs(deltaDb) > (TMath)MaxSeriesDb)
+				return (TMath)AudioLib::Utils::DB2gain(deltaDb);
+
+			TMath x = deltaDb * (TMath)0.11512925464970229;
+			return 1 + x * (1 + x * ((TMath)(1.0 / 2) + x * ((TMath)(1.0 / 6) + x * ((TMath)(1.0 / 24) + x * ((TMath)(1.0 / 120) + x * (TMath)(1.0 / 720))))));
+		}
+	};
+
+	typedef GainRampT<float> GainRamp;
+}
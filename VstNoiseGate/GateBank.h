@@ -0,0 +1,538 @@
+#pragma once
+
+#include <cmath>
+#include <cfloat>
+
+#include "AudioLib/Biquad.h"
+#include "AudioLib/BiquadBank.h"
+#include "AudioLib/Simd.h"
+#include "AudioLib/Utils.h"
+#include "AudioLib/VectorMath.h"
+#include "NoiseGateKernel.h"
+
+namespace NoiseInvader
+{
+	/// <summary>
+	/// A bank of Lanes independent mono noise gates, processed in lockstep.
+	/// Every gate has the complete state of NoiseGateKernel (band filter, SMA ring, EMA, movement latch, hold logic,
+	/// smoothing poles, expander and slew limiter), stored as structure-of-arrays so that each step of the chain
+	/// is a loop over the lanes without branches, which the compiler turns into SIMD code.
+	/// The settings of each lane are independent. The lanes keep the mixed float / double arithmetic of the
+	/// original kernel, so with MathPrecision::Exact every lane reproduces the reference chain bit for bit.
+	/// </summary>
+	template<int Lanes>
+	class GateBank
+	{
+		static_assert(Lanes == 4 || Lanes == 8 || Lanes == 16, "GateBank supports 4, 8 or 16 lanes");
+
+	public:
+		// The bank processes in chunks of this many samples. The scratch buffers hold BlockSize * Lanes values
+		static const int BlockSize = 64;
+
+	private:
+		// same constants as EnvelopeFollower
+		const double InputFilterHpCutoff = 100.0;
+		const double InputFilterCutoff = 2000.0;
+		const double EmaFc = 200.0;
+		const double SmaPeriodSeconds = 0.01;
+		const double TimeoutPeriodSeconds = 0.01;
+		const double HoldSmootherFc = 200.0;
+		const double LatchAlpha = 0.005;
+		const double LatchLevel = 0.2;
+
+		double fs;
+
+		// parameters shared by all lanes, they only depend on the samplerate
+		float hpG2;
+		double emaAlpha;
+		double slowDecay;
+		double holdAlpha;
+		double triggerCounterTimeoutSamples;
+		double slewUp;
+		int smaCount;
+
+		// per-lane parameters, computed by UpdateAll()
+		alignas(64) double fastDecay[Lanes];
+		alignas(64) double slewDown[Lanes];
+		alignas(64) double thresholdDb[Lanes];
+		alignas(64) double reductionDb[Lanes];
+		alignas(64) double upperSlope[Lanes];
+		alignas(64) double lowerSlope[Lanes];
+
+		// per-lane state
+		alignas(64) float hpZ[Lanes];
+		// the lowpass of the band filter, in direct form I like the reference chain
+		AudioLib::BiquadBankT<Lanes, float, AudioLib::BiquadForm::DirectForm1> inputFilter;
+		alignas(64) double emaValue[Lanes];
+		alignas(64) double smaSum[Lanes];
+		alignas(64) double latchValue[Lanes];
+		alignas(64) double latchOutput[Lanes];
+		alignas(64) double hold[Lanes];
+		alignas(64) double triggerCounter[Lanes]; // integer valued, kept as double so the hold loop has a single lane type
+		alignas(64) double h1[Lanes];
+		alignas(64) double h2[Lanes];
+		alignas(64) double h3[Lanes];
+		alignas(64) double h4[Lanes];
+		alignas(64) double prevInDb[Lanes];
+		alignas(64) double outputDb[Lanes];
+		alignas(64) double slewOutput[Lanes];
+
+		// SMA ring, smaCount rows of Lanes values. All lanes share the same head
+		double* smaQueue;
+		float* smaDbQueue;
+		int smaHead;
+
+		// scratch buffers, sample major: buffer[i * Lanes + lane]
+		alignas(64) float detector[BlockSize * Lanes];
+		alignas(64) float band[BlockSize * Lanes];
+		alignas(64) float bandDb[BlockSize * Lanes];
+		alignas(64) double emaValues[BlockSize * Lanes];
+		alignas(64) double smaValues[BlockSize * Lanes];
+		alignas(64) double smaDecay[BlockSize * Lanes];
+		alignas(64) double movement[BlockSize * Lanes];
+		alignas(64) double envelope[BlockSize * Lanes];
+		alignas(64) float envelopeDb[BlockSize * Lanes];
+		alignas(64) double slewDb[BlockSize * Lanes];
+		alignas(64) double gain[BlockSize * Lanes];
+
+	public:
+
+		// Per-lane settings, same meaning as in NoiseGateKernel. Call UpdateAll() after changing them
+		float DetectorGain[Lanes];
+		double ReductionDb[Lanes];
+		double ThresholdDb[Lanes];
+		double Slope[Lanes];
+		double ReleaseMs[Lanes];
+
+		// Accuracy of the log / exp conversions, shared by all lanes
+		AudioLib::MathPrecision Precision;
+
+		// for readouts, highest gain of each lane in the last Process() call
+		double CurrentGainDb[Lanes];
+
+		GateBank(int fs)
+		{
+			this->fs = fs;
+			double ts = 1.0 / this->fs;
+
+			hpG2 = GetHp1G2(InputFilterHpCutoff / (this->fs * 0.5));
+
+			AudioLib::Biquad lp(AudioLib::Biquad::FilterType::LowPass, fs);
+			lp.Frequency = InputFilterCutoff;
+			lp.SetQ(1.0f);
+			lp.Update();
+			inputFilter.SetCoefficients(lp.GetCoefficients());
+
+			emaAlpha = AudioLib::Utils::ComputeLpAlpha(EmaFc, ts);
+			slowDecay = AudioLib::Utils::DB2gain(-60 / (3000 / 1000.0 * this->fs));
+			holdAlpha = AudioLib::Utils::ComputeLpAlpha(HoldSmootherFc, ts);
+			triggerCounterTimeoutSamples = (int)(this->fs * TimeoutPeriodSeconds);
+			slewUp = 60.0 / (2.0 / 1000.0 * this->fs);
+
+			smaCount = (int)(this->fs * SmaPeriodSeconds);
+			// read and written with aligned vector loads
+			smaQueue = AudioLib::Simd::AlignedMalloc<double>(smaCount * Lanes);
+			smaDbQueue = AudioLib::Simd::AlignedMalloc<float>(smaCount * Lanes);
+
+			for (int l = 0; l < Lanes; l++)
+			{
+				DetectorGain[l] = 1.0f;
+				ReductionDb[l] = -150;
+				ThresholdDb[l] = -20;
+				Slope[l] = 3;
+				ReleaseMs[l] = 100;
+				CurrentGainDb[l] = 0;
+			}
+
+			Precision = AudioLib::MathPrecision::Db001;
+			Reset();
+			UpdateAll();
+		}
+
+		~GateBank()
+		{
+			AudioLib::Simd::AlignedFree(smaQueue);
+			AudioLib::Simd::AlignedFree(smaDbQueue);
+		}
+
+		GateBank(const GateBank&) = delete;
+		GateBank& operator=(const GateBank&) = delete;
+
+		void UpdateAll()
+		{
+			for (int l = 0; l < Lanes; l++)
+			{
+				fastDecay[l] = AudioLib::Utils::DB2gain(-60 / (ReleaseMs[l] / 1000.0 * fs));
+				slewDown[l] = 60.0 / (ReleaseMs[l] / 1000.0 * fs);
+				thresholdDb[l] = ThresholdDb[l];
+				reductionDb[l] = ReductionDb[l];
+				upperSlope[l] = Slope[l];
+				lowerSlope[l] = Slope[l] * 2;
+			}
+		}
+
+		// Clears the state of every lane
+		void Reset()
+		{
+			for (int l = 0; l < Lanes; l++)
+			{
+				hpZ[l] = 0.0f;
+				emaValue[l] = smaSum[l] = 0.0;
+				latchValue[l] = latchOutput[l] = 0.0;
+				hold[l] = triggerCounter[l] = 0.0;
+				h1[l] = h2[l] = h3[l] = h4[l] = 0.0;
+				prevInDb[l] = outputDb[l] = -150.0;
+				slewOutput[l] = 0.0;
+			}
+
+			for (int i = 0; i < smaCount * Lanes; i++)
+			{
+				smaQueue[i] = 0.0;
+				smaDbQueue[i] = -150.0f;
+			}
+
+			inputFilter.ClearBuffers();
+			smaHead = 0;
+		}
+
+		/// <summary>
+		/// Processes len samples of every lane. input[lane] and output[lane] point to the mono signal of each lane,
+		/// detector may be null, in which case each lane is keyed by its own input. traces, if not null, points to
+		/// Lanes StageTrace records.
+		/// </summary>
+		void Process(const float* const* input, const float* const* detectorInput, float* const* output, int len, const StageTrace* traces = nullptr)
+		{
+			AudioLib::Simd::PreventDenormals();
+			for (int l = 0; l < Lanes; l++)
+				CurrentGainDb[l] = -1000;
+
+			for (int pos = 0; pos < len; pos += BlockSize)
+			{
+				int count = len - pos < BlockSize ? len - pos : BlockSize;
+				ProcessBlock(input, detectorInput != nullptr ? detectorInput : input, output, pos, count, traces);
+			}
+		}
+
+	private:
+
+		static float GetHp1G2(double fcRel)
+		{
+			// same computation as Hp1::SetFc, including the float conversion of the argument
+			float g = (float)((float)fcRel * M_PI);
+			return g / (1 + g);
+		}
+
+		// Lane helpers. Doubles are processed two lanes per register, floats four lanes per register
+		static inline __m128d Select(__m128d mask, __m128d a, __m128d b)
+		{
+			return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+		}
+
+		// loads two floats and widens them to double
+		static inline __m128d Load2(const float* p)
+		{
+			return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)p)));
+		}
+
+		void ProcessBlock(const float* const* input, const float* const* detectorInput, float* const* output, int pos, int len, const StageTrace* traces)
+		{
+			const int n = len * Lanes;
+
+			// gather the lanes into the interleaved detector buffer and rectify
+			for (int l = 0; l < Lanes; l++)
+			{
+				auto src = &detectorInput[l][pos];
+				auto g = DetectorGain[l];
+				for (int i = 0; i < len; i++)
+					band[i * Lanes + l] = std::abs(src[i] * g);
+			}
+
+			// Every recurrence below runs one group of lanes over the whole block with the state kept in registers,
+			// then moves on to the next group. The lanes never interact, so the order doesn't change the result
+
+			// 1. - 2. Band pass filter and rectify again, see EnvelopeFollower::ProcessEnvelope
+			{
+				const __m128 g2 = _mm_set1_ps(hpG2);
+
+				for (int g = 0; g < Lanes; g += 4)
+				{
+					__m128 z = _mm_load_ps(&hpZ[g]);
+
+					for (int i = 0; i < len; i++)
+					{
+						float* p = &band[i * Lanes + g];
+						__m128 x = _mm_load_ps(p);
+						__m128 v = _mm_mul_ps(_mm_sub_ps(x, z), g2);
+						__m128 y = _mm_add_ps(v, z);
+						z = _mm_add_ps(y, v);
+						_mm_store_ps(p, _mm_sub_ps(x, y));
+					}
+
+					_mm_store_ps(&hpZ[g], z);
+				}
+
+				inputFilter.Process(band, band, len);
+
+				for (int i = 0; i < n; i++)
+					band[i] = std::abs(band[i]);
+			}
+
+			// 3. EMA and SMA. The dB decay of the SMA is computed in single precision like Sma::Update,
+			// the ring is walked separately for the float and the double part
+			AudioLib::VectorMath::Gain2Db(band, bandDb, n, Precision);
+			for (int i = 0; i < n; i++)
+				bandDb[i] = bandDb[i] < -150 ? -150 : bandDb[i];
+
+			{
+				const __m128 count = _mm_set1_ps((float)smaCount);
+				for (int g = 0; g < Lanes; g += 4)
+				{
+					int head = smaHead;
+					for (int i = 0; i < len; i++)
+					{
+						float* q = &smaDbQueue[head * Lanes + g];
+						__m128 xDb = _mm_load_ps(&bandDb[i * Lanes + g]);
+						_mm_store_ps(&bandDb[i * Lanes + g], _mm_div_ps(_mm_sub_ps(xDb, _mm_load_ps(q)), count));
+						_mm_store_ps(q, xDb);
+						if (++head >= smaCount)
+							head = 0;
+					}
+				}
+			}
+
+			// 4. movement latch, fed by the SMA decay that is now in bandDb
+			{
+				const __m128d alpha = _mm_set1_pd(emaAlpha), oneMinusAlpha = _mm_set1_pd(1 - emaAlpha);
+				const __m128d count = _mm_set1_pd(smaCount);
+				const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1.0), minusOne = _mm_set1_pd(-1.0);
+				const __m128d latchAlpha = _mm_set1_pd(LatchAlpha), latchOneMinusAlpha = _mm_set1_pd(1 - LatchAlpha);
+				const __m128d latchHigh = _mm_set1_pd(LatchLevel), latchLow = _mm_set1_pd(-LatchLevel);
+
+				for (int g = 0; g < Lanes; g += 2)
+				{
+					__m128d ema = _mm_load_pd(&emaValue[g]);
+					__m128d sum = _mm_load_pd(&smaSum[g]);
+					__m128d latch = _mm_load_pd(&latchValue[g]);
+					__m128d latchOut = _mm_load_pd(&latchOutput[g]);
+					int head = smaHead;
+
+					for (int i = 0; i < len; i++)
+					{
+						int k = i * Lanes + g;
+						double* q = &smaQueue[head * Lanes + g];
+						__m128d x = Load2(&band[k]);
+						__m128d dbDecay = Load2(&bandDb[k]);
+
+						ema = _mm_add_pd(_mm_mul_pd(x, alpha), _mm_mul_pd(ema, oneMinusAlpha));
+						_mm_store_pd(&emaValues[k], ema);
+
+						sum = _mm_add_pd(_mm_sub_pd(sum, _mm_load_pd(q)), x);
+						_mm_store_pd(q, x);
+						_mm_store_pd(&smaValues[k], _mm_div_pd(sum, count));
+						_mm_store_pd(&smaDecay[k], dbDecay);
+
+						__m128d sample = Select(_mm_cmpgt_pd(dbDecay, zero), one, minusOne);
+						latch = _mm_add_pd(_mm_mul_pd(sample, latchAlpha), _mm_mul_pd(latch, latchOneMinusAlpha));
+						latchOut = Select(_mm_cmpgt_pd(latch, latchHigh), one, latchOut);
+						latchOut = Select(_mm_cmplt_pd(latch, latchLow), minusOne, latchOut);
+						_mm_store_pd(&movement[k], latchOut);
+
+						if (++head >= smaCount)
+							head = 0;
+					}
+
+					_mm_store_pd(&emaValue[g], ema);
+					_mm_store_pd(&smaSum[g], sum);
+					_mm_store_pd(&latchValue[g], latch);
+					_mm_store_pd(&latchOutput[g], latchOut);
+				}
+
+				smaHead = (smaHead + len) % smaCount;
+			}
+
+			// 7. (precomputed) the SMA based decay
+			for (int i = 0; i < n; i++)
+				smaDecay[i] = smaDecay[i] * 1.2;
+			AudioLib::VectorMath::Db2Gain(smaDecay, smaDecay, n, Precision);
+
+			// 5. - 8. hold, decay selection and smoothing
+			{
+				const __m128d alpha = _mm_set1_pd(holdAlpha), oneMinusAlpha = _mm_set1_pd(1 - holdAlpha);
+				const __m128d slow = _mm_set1_pd(slowDecay);
+				const __m128d timeout = _mm_set1_pd(triggerCounterTimeoutSamples);
+				const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1.0);
+
+				// two register groups at a time, the recurrence is latency bound and the groups are independent
+				for (int g = 0; g < Lanes; g += 4)
+				{
+					__m128d fast[2], h[2], counter[2], s1[2], s2[2], s3[2], s4[2];
+					for (int j = 0; j < 2; j++)
+					{
+						int l = g + j * 2;
+						fast[j] = _mm_load_pd(&fastDecay[l]);
+						h[j] = _mm_load_pd(&hold[l]);
+						counter[j] = _mm_load_pd(&triggerCounter[l]);
+						s1[j] = _mm_load_pd(&h1[l]); s2[j] = _mm_load_pd(&h2[l]); s3[j] = _mm_load_pd(&h3[l]); s4[j] = _mm_load_pd(&h4[l]);
+					}
+
+					for (int i = 0; i < len; i++)
+					{
+						for (int j = 0; j < 2; j++)
+						{
+							int k = i * Lanes + g + j * 2;
+							__m128d ema = _mm_load_pd(&emaValues[k]);
+							__m128d sma = _mm_load_pd(&smaValues[k]);
+
+							__m128d up = Select(_mm_cmpgt_pd(ema, sma), ema, sma);
+							__m128d down = Select(_mm_cmplt_pd(ema, sma), ema, sma);
+							__m128d combinedFiltered = Select(_mm_cmpgt_pd(_mm_load_pd(&movement[k]), zero), up, down);
+
+							__m128d trigger = _mm_cmpgt_pd(combinedFiltered, h[j]);
+							h[j] = Select(trigger, combinedFiltered, h[j]);
+							counter[j] = Select(trigger, zero, counter[j]);
+
+							__m128d decay = Select(_mm_cmpgt_pd(counter[j], timeout), fast[j], _mm_load_pd(&smaDecay[k]));
+							decay = Select(_mm_cmpgt_pd(decay, slow), slow, decay);
+							decay = Select(_mm_cmplt_pd(decay, fast[j]), fast[j], decay);
+							h[j] = _mm_mul_pd(h[j], decay);
+
+							s1[j] = _mm_add_pd(_mm_mul_pd(alpha, h[j]), _mm_mul_pd(oneMinusAlpha, s1[j]));
+							s2[j] = _mm_add_pd(_mm_mul_pd(alpha, s1[j]), _mm_mul_pd(oneMinusAlpha, s2[j]));
+							s3[j] = _mm_add_pd(_mm_mul_pd(alpha, s2[j]), _mm_mul_pd(oneMinusAlpha, s3[j]));
+							s4[j] = _mm_add_pd(_mm_mul_pd(alpha, s3[j]), _mm_mul_pd(oneMinusAlpha, s4[j]));
+							_mm_store_pd(&envelope[k], s4[j]);
+
+							counter[j] = Select(_mm_cmple_pd(counter[j], timeout), _mm_add_pd(counter[j], one), counter[j]);
+						}
+					}
+
+					for (int j = 0; j < 2; j++)
+					{
+						int l = g + j * 2;
+						_mm_store_pd(&hold[l], h[j]);
+						_mm_store_pd(&triggerCounter[l], counter[j]);
+						_mm_store_pd(&h1[l], s1[j]); _mm_store_pd(&h2[l], s2[j]); _mm_store_pd(&h3[l], s3[j]); _mm_store_pd(&h4[l], s4[j]);
+					}
+				}
+			}
+
+			AudioLib::VectorMath::Gain2Db(envelope, envelopeDb, n, Precision);
+
+			// Expander and slew limiter, see Expander::Expand and SlewLimiter::Process.
+			// The expander gain is parked in the gain buffer until the exponentiation pass
+			{
+				const __m128d floor = _mm_set1_pd(-150);
+				const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+				const __m128d maxFinite = _mm_set1_pd(DBL_MAX);
+				const __m128d up = _mm_set1_pd(slewUp);
+
+				for (int g = 0; g < Lanes; g += 2)
+				{
+					const __m128d threshold = _mm_load_pd(&thresholdDb[g]);
+					const __m128d lowerThreshold = _mm_add_pd(threshold, _mm_set1_pd(4));
+					const __m128d upperRatio = _mm_load_pd(&upperSlope[g]);
+					const __m128d lowerRatio = _mm_load_pd(&lowerSlope[g]);
+					const __m128d reduction = _mm_load_pd(&reductionDb[g]);
+					const __m128d down = _mm_load_pd(&slewDown[g]);
+					__m128d prevIn = _mm_load_pd(&prevInDb[g]);
+					__m128d out = _mm_load_pd(&outputDb[g]);
+					__m128d slew = _mm_load_pd(&slewOutput[g]);
+
+					for (int i = 0; i < len; i++)
+					{
+						int k = i * Lanes + g;
+						__m128d dbVal = Load2(&envelopeDb[k]);
+						dbVal = Select(_mm_cmpgt_pd(dbVal, floor), dbVal, floor);
+						out = Select(_mm_cmple_pd(_mm_and_pd(out, absMask), maxFinite), out, floor);
+
+						__m128d upperDb = Compress(dbVal, threshold, upperRatio);
+						__m128d lowerDb = Compress(dbVal, lowerThreshold, lowerRatio);
+
+						__m128d desiredDb = _mm_add_pd(out, _mm_sub_pd(dbVal, prevIn));
+						desiredDb = Select(_mm_cmplt_pd(desiredDb, lowerDb), lowerDb, Select(_mm_cmpgt_pd(desiredDb, upperDb), upperDb, desiredDb));
+
+						out = desiredDb;
+						prevIn = dbVal;
+
+						__m128d gainDiff = _mm_sub_pd(out, dbVal);
+						gainDiff = Select(_mm_cmplt_pd(gainDiff, reduction), reduction, gainDiff);
+						_mm_store_pd(&gain[k], gainDiff);
+
+						__m128d slewUpper = _mm_add_pd(slew, up);
+						__m128d slewLower = _mm_sub_pd(slew, down);
+						__m128d rising = Select(_mm_cmpgt_pd(gainDiff, slewUpper), slewUpper, gainDiff);
+						__m128d falling = Select(_mm_cmplt_pd(gainDiff, slewLower), slewLower, gainDiff);
+						slew = Select(_mm_cmpgt_pd(gainDiff, slew), rising, falling);
+						_mm_store_pd(&slewDb[k], slew);
+					}
+
+					_mm_store_pd(&prevInDb[g], prevIn);
+					_mm_store_pd(&outputDb[g], out);
+					_mm_store_pd(&slewOutput[g], slew);
+				}
+			}
+
+			if (traces != nullptr)
+			{
+				for (int l = 0; l < Lanes; l++)
+				{
+					auto& t = traces[l];
+					for (int i = 0; i < len; i++)
+					{
+						if (t.Envelope) t.Envelope[pos + i] = envelope[i * Lanes + l];
+						if (t.ExpanderDb) t.ExpanderDb[pos + i] = gain[i * Lanes + l];
+						if (t.SlewDb) t.SlewDb[pos + i] = slewDb[i * Lanes + l];
+					}
+				}
+			}
+
+			for (int i = 0; i < len; i++)
+			{
+				for (int l = 0; l < Lanes; l++)
+				{
+					auto g = slewDb[i * Lanes + l];
+					CurrentGainDb[l] = g > CurrentGainDb[l] ? g : CurrentGainDb[l];
+				}
+			}
+
+			AudioLib::VectorMath::Db2Gain(slewDb, gain, n, Precision);
+
+			for (int l = 0; l < Lanes; l++)
+			{
+				auto src = &input[l][pos];
+				auto dst = &output[l][pos];
+				for (int i = 0; i < len; i++)
+					dst[i] = src[i] * gain[i * Lanes + l];
+			}
+		}
+
+		/// <summary>
+		/// Expander::Compress with a fixed 4dB knee in expansion mode. All three segments of the curve are
+		/// evaluated and the result selected, with the same operations as the scalar version
+		/// </summary>
+		static inline __m128d Compress(__m128d x, __m128d threshold, __m128d ratio)
+		{
+			const __m128d knee = _mm_set1_pd(4);
+			__m128d kneeLow = _mm_sub_pd(threshold, knee);
+			__m128d kneeHigh = _mm_add_pd(threshold, knee);
+
+			__m128d above = _mm_add_pd(threshold, _mm_div_pd(_mm_sub_pd(x, threshold), ratio));
+
+			__m128d positionOnLine = _mm_div_pd(_mm_sub_pd(x, kneeLow), _mm_sub_pd(kneeHigh, kneeLow));
+			__m128d kDiff = _mm_mul_pd(knee, positionOnLine);
+			__m128d xa = _mm_add_pd(kneeLow, kDiff);
+			__m128d yb = _mm_add_pd(threshold, _mm_div_pd(kDiff, ratio));
+			__m128d slope = _mm_div_pd(_mm_sub_pd(yb, xa), knee);
+			__m128d inKnee = _mm_add_pd(xa, _mm_mul_pd(_mm_mul_pd(slope, positionOnLine), knee));
+
+			__m128d output = Select(_mm_cmple_pd(x, kneeLow), x, Select(_mm_cmpge_pd(x, kneeHigh), above, inKnee));
+
+			__m128d yOffset = _mm_sub_pd(_mm_mul_pd(threshold, ratio), threshold);
+			return _mm_sub_pd(_mm_mul_pd(output, ratio), yOffset);
+		}
+	};
+
+	typedef GateBank<4> GateBank4;
+	typedef GateBank<8> GateBank8;
+	typedef GateBank<16> GateBank16;
+}
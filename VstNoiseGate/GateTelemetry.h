@@ -0,0 +1,27 @@
+#pragma once
+
+namespace NoiseInvader
+{
+	/// <summary>
+	/// Metering record for one Process call, sent from the audio thread to the UI through NoiseGateKernel::PollTelemetry.
+	/// Gains are the gain applied to the output in dB: 0 is fully open, negative values are gain reduction
+	/// </summary>
+	struct GateTelemetry
+	{
+		// Increments with every Process call. A gap means records were dropped because nobody polled
+		unsigned int Sequence;
+		int SampleCount;
+
+		float MinGainDb;
+		float MaxGainDb;
+		float MeanGainDb;
+
+		// Peak of the detector envelope
+		float EnvelopePeakDb;
+
+		// Fraction of the samples where the gate was open, meaning the gain was within OpenGainDb of unity
+		float OpenFraction;
+
+		static constexpr float OpenGainDb = -3.0f;
+	};
+}
@@ -1,107 +1,289 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include "AudioLib/Utils.h"
 
 namespace NoiseInvader
 {
-	class Sma
+	/// <summary>
+	/// Simple moving average, also tracks the per-sample dB decay over the averaging window.
+	/// T is the sample type (float or double). The running sum is recomputed from the queue every time the
+	/// head wraps around, so rounding errors of the incremental update can't accumulate in single precision.
+	/// The queue is part of the object, sized for MaxSampleCount, and the window can be changed without allocating
+	/// </summary>
+	template<typename T>
+	class SmaT
 	{
+	public:
+		// 10ms at 384kHz
+		static const int MaxSampleCount = 4096;
+
+		/// <summary>
+		/// The window contents and running values, plain data for kernel snapshots. Only the first Length entries
+		/// of the queues are used, GetState and SetState copy just those
+		/// </summary>
+		struct State
+		{
+			int Length;
+			int Head;
+			T Sum;
+			T DbDecayPerSample;
+			T Queue[MaxSampleCount];
+			T DbQueue[MaxSampleCount];
+		};
+
 	private:
-		double* queue;
+		alignas(64) T queue[MaxSampleCount];
+		alignas(64) T dbQueue[MaxSampleCount]; // dB value of every queued sample, so each sample is only converted once
 		int sampleCount;
 
 		int head;
-		double sum;
-		double dbDecayPerSample;
+		T sum;
+		T dbDecayPerSample;
 
 	public:
 
-		Sma(int sampleCount)
+		SmaT(int sampleCount)
+		{
+			this->sampleCount = ClampLength(sampleCount);
+			for (int i = 0; i < this->sampleCount; i++)
+			{
+				queue[i] = 0;
+				dbQueue[i] = -150;
+			}
+
+			head = 0;
+			sum = 0;
+			dbDecayPerSample = 0;
+		}
+
+		/// <summary>
+		/// Changes the length of the window, clamped to 1...MaxSampleCount. The current average is kept:
+		/// the new window is filled with it, so the output continues without a step
+		/// </summary>
+		void SetLength(int sampleCount)
 		{
+			sampleCount = ClampLength(sampleCount);
+			if (sampleCount == this->sampleCount)
+				return;
+
+			T average = sum / this->sampleCount;
+			T averageDb = ToDb(average);
 			this->sampleCount = sampleCount;
-			this->queue = new double[sampleCount];
 			for (int i = 0; i < sampleCount; i++)
-				queue[i] = 0.0;
+			{
+				queue[i] = average;
+				dbQueue[i] = averageDb;
+			}
 
 			head = 0;
-			sum = 0.0;
-			dbDecayPerSample = 0.0;
+			sum = Sum();
+			dbDecayPerSample = 0;
 		}
 
-		~Sma()
+		int GetLength() const
 		{
-			delete queue;
+			return sampleCount;
 		}
 
-		double GetDbDecayPerSample()
+		T GetDbDecayPerSample()
 		{
 			return dbDecayPerSample;
 		}
 
-		double Update(double sample)
+		/// <summary>
+		/// True if the window holds nothing but silence, so that further silence leaves the average and decay at 0,
+		/// wherever the head is. Scans the window, meant to be called only once the input has been silent for a while
+		/// </summary>
+		bool IsSilent() const
+		{
+			if (sum != 0 || dbDecayPerSample != 0)
+				return false;
+
+			for (int i = 0; i < sampleCount; i++)
+			{
+				if (queue[i] != 0 || dbQueue[i] != -150)
+					return false;
+			}
+
+			return true;
+		}
+
+		/// <summary>
+		/// Moves the head on as len silent samples would. Only valid while IsSilent(), the window then stays as it is;
+		/// the head still matters, it decides when the running sum is recomputed once the input returns
+		/// </summary>
+		void SkipSilence(int len)
+		{
+			head = (int)((head + (long long)len) % sampleCount);
+		}
+
+		void GetState(State& state) const
+		{
+			state.Length = sampleCount;
+			state.Head = head;
+			state.Sum = sum;
+			state.DbDecayPerSample = dbDecayPerSample;
+			std::copy(queue, queue + sampleCount, state.Queue);
+			std::copy(dbQueue, dbQueue + sampleCount, state.DbQueue);
+		}
+
+		// Takes over the window length of the state as well
+		void SetState(const State& state)
+		{
+			sampleCount = ClampLength(state.Length);
+			head = state.Head < sampleCount ? state.Head : 0;
+			sum = state.Sum;
+			dbDecayPerSample = state.DbDecayPerSample;
+			std::copy(state.Queue, state.Queue + sampleCount, queue);
+			std::copy(state.DbQueue, state.DbQueue + sampleCount, dbQueue);
+		}
+
+		static inline T ToDb(T sample)
+		{
+			T db = 20 * std::log10(sample);
+			return db < -150 ? -150 : db;
+		}
+
+		T Update(T sample)
+		{
+			return Update(sample, ToDb(sample));
+		}
+
+		/// <summary>
+		/// Same as Update(sample), but takes the dB value of the sample, as computed by ToDb(), precomputed
+		/// </summary>
+		inline T Update(T sample, T sampleDb)
 		{
 			auto takeAway = queue[head];
+			auto takeAwayDb = dbQueue[head];
 			queue[head] = sample;
+			dbQueue[head] = sampleDb;
 			head++;
-			if (head >= sampleCount)
-				head = 0;
 
 			sum -= takeAway;
 			sum += sample;
 
-			auto sampleDb = AudioLib::Utils::Gain2DB(sample);
-			auto takeAwayDb = AudioLib::Utils::Gain2DB(takeAway);
-
-			if (sampleDb < -150)
-				sampleDb = -150;
-			if (takeAwayDb < -150)
-				takeAwayDb = -150;
+			if (head >= sampleCount)
+			{
+				head = 0;
+				sum = Sum();
+			}
 
 			dbDecayPerSample = (sampleDb - takeAwayDb) / sampleCount;
 
 			return sum / sampleCount;
 		}
+
+		/// <summary>
+		/// Block version. inputDb must hold ToDb(input[i]) for every sample, writes the average and the per-sample dB decay
+		/// </summary>
+		void Update(const T* input, const T* inputDb, T* output, T* dbDecay, int len)
+		{
+			for (int i = 0; i < len; i++)
+			{
+				output[i] = Update(input[i], inputDb[i]);
+				dbDecay[i] = dbDecayPerSample;
+			}
+		}
+
+	private:
+		static int ClampLength(int sampleCount)
+		{
+			return sampleCount < 1 ? 1 : sampleCount > MaxSampleCount ? MaxSampleCount : sampleCount;
+		}
+
+		T Sum()
+		{
+			T total = 0;
+			for (int i = 0; i < sampleCount; i++)
+				total += queue[i];
+			return total;
+		}
 	};
 
-	class Ema
+	template<typename T>
+	class EmaT
 	{
 	private:
-		double alpha;
-		double value;
+		T alpha;
+		T value;
 
 	public:
 
-		Ema(double alpha)
+		EmaT(T alpha)
 		{
 			this->alpha = alpha;
+			this->value = 0;
+		}
+
+		// Keeps the current value
+		void SetAlpha(T alpha)
+		{
+			this->alpha = alpha;
+		}
+
+		T GetState() const
+		{
+			return value;
+		}
+
+		void SetState(T state)
+		{
+			value = state;
 		}
 
-		double Update(double sample)
+		T Update(T sample)
 		{
 			value = sample * alpha + value * (1 - alpha);
 			return value;
 		}
+
+		void Update(const T* input, T* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+			{
+				value = input[i] * alpha + value * (1 - alpha);
+				output[i] = value;
+			}
+		}
 	};
 
-	class EmaLatch
+	template<typename T>
+	class EmaLatchT
 	{
 	private:
-		double alpha;
-		double latch;
-		double value;
-		double currentValue;
+		T alpha;
+		T latch;
+		T value;
+		T currentValue;
 
 	public:
+		// The average and the latched direction
+		struct State
+		{
+			T Value;
+			T CurrentValue;
+		};
 
-		EmaLatch(double alpha, double latch)
+		EmaLatchT(T alpha, T latch)
 		{
 			this->alpha = alpha;
 			this->latch = latch;
+			this->value = 0;
+			this->currentValue = 0;
 		}
 
-		double Update(bool input)
+		// Keeps the average and the latched direction
+		void SetAlpha(T alpha)
 		{
-			auto sample = input ? 1.0 : -1.0;
+			this->alpha = alpha;
+		}
+
+		T Update(bool input)
+		{
+			T sample = input ? 1 : -1;
 			value = sample * alpha + value * (1 - alpha);
 
 			if (value > latch)
@@ -111,5 +293,30 @@ namespace NoiseInvader
 
 			return currentValue;
 		}
+
+		void GetState(State& state) const
+		{
+			state.Value = value;
+			state.CurrentValue = currentValue;
+		}
+
+		void SetState(const State& state)
+		{
+			value = state.Value;
+			currentValue = state.CurrentValue;
+		}
+
+		/// <summary>
+		/// Block version, the latch input for each sample is whether input[i] is positive
+		/// </summary>
+		void Update(const T* input, T* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = Update(input[i] > 0);
+		}
 	};
+
+	typedef SmaT<float> Sma;
+	typedef EmaT<float> Ema;
+	typedef EmaLatchT<float> EmaLatch;
 }
@@ -0,0 +1,12 @@
+#include <type_traits>
+
+#include "NoiseGateKernel.h"
+
+namespace NoiseInvader
+{
+	template class NoiseGateKernelT<float>;
+	template class NoiseGateKernelT<double>;
+
+	static_assert(std::is_trivially_copyable<NoiseGateKernel::Snapshot>::value, "snapshots must be plain data");
+	static_assert(std::is_trivially_copyable<NoiseGateKernelDouble::Snapshot>::value, "snapshots must be plain data");
+}
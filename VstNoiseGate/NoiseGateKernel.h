@@ -1,66 +1,435 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <cmath>
+#include <cstring>
+#include <limits>
 
-#include "AudioLib/Sse.h"
+#include "AudioLib/DelayLine.h"
+#include "AudioLib/SmoothedValue.h"
+#include "AudioLib/SpscQueue.h"
+#include "AudioLib/Simd.h"
+#include "AudioLib/VectorMath.h"
 #include "Expander.h"
+#include "GainRamp.h"
 #include "EnvelopeFollower.h"
+#include "GateTelemetry.h"
+#include "PeakDetector.h"
+#include "Profiler.h"
 #include "SlewLimiter.h"
 
 using namespace AudioLib;
 
 namespace NoiseInvader
 {
-	class NoiseGateKernel
+	/// <summary>
+	/// Optional per-sample record of the intermediate stages of the gain computer.
+	/// Any pointer may be null. Used by the regression harness to compare engines stage by stage
+	/// </summary>
+	struct StageTrace
+	{
+		double* Envelope;
+		double* ExpanderDb;
+		double* SlewDb;
+	};
+
+	enum class KernelParameter
+	{
+		DetectorGain,
+		ReductionDb,
+		ThresholdDb,
+		Slope,
+		ReleaseMs,
+		LookaheadMs,
+	};
+
+	static const int KernelParameterCount = (int)KernelParameter::LookaheadMs + 1;
+
+	/// <summary>
+	/// What produces the envelope the expander works on. Envelope is the full envelope follower (band filter, averages,
+	/// hold and smoother). PeakHold holds the largest peak of the rectified detector signal for 10ms and then falls
+	/// at the release rate: much cheaper, and faster to open, but without the band filter or the smoothing
+	/// </summary>
+	enum class DetectorMode
+	{
+		Envelope,
+		PeakHold,
+	};
+
+	/// <summary>
+	/// The noise gate. T is the sample type the whole gain chain runs in, float or double, explicitly
+	/// instantiated for both in NoiseGateKernel.cpp. Audio input and output are always float.
+	/// NoiseGateKernel (float) is the default, NoiseGateKernelDouble the high precision variant.
+	/// All state lives in the object itself, sized for MaxSampleRate, so nothing is allocated after construction
+	/// and Reconfigure() moves it to another samplerate in place
+	/// </summary>
+	template<typename T>
+	class alignas(64) NoiseGateKernelT
 	{
 	private:
 
 		float fs;
 
-		EnvelopeFollower envelopeFollower;
-		Expander expander;
-		SlewLimiter slewLimiter;
+		EnvelopeFollowerT<T> envelopeFollower;
+		PeakDetectorT<T> peakDetector;
+		DetectorMode detectorMode;
+		ExpanderT<T> expander;
+		SlewLimiterT<T> slewLimiter;
+		// turns slewDb into the gain factor, per sample or in steps, see GainInterval
+		GainRampT<T> gainRamp;
+		// the ramp of the expander's gain over a group of the decimated follower, see ExpandGroups. NaN until the first block
+		T expanderFrom;
+		T expanderTo;
+
+		// the last block held the gain factor at one value
+		bool gainFlat;
+
+		// lookahead, delays the main path while the detector runs ahead
+		DelayLine delayL;
+		DelayLine delayR;
+
+		// the latest value posted for each KernelParameter from other threads, and whether Process still has to apply it
+		std::atomic<double> postedValues[KernelParameterCount];
+		std::atomic<bool> postedChanged[KernelParameterCount];
+
+		// smoothed settings, ramped over ParameterRampMs when a queued change arrives
+		SmoothedValue<T> detectorGainSmoother;
+		SmoothedValue<T> reductionSmoother;
+		SmoothedValue<T> thresholdSmoother;
+		SmoothedValue<T> slopeSmoother;
+
+		// metering, one record per Process call for the UI thread
+		SpscQueue<GateTelemetry, 64> telemetryQueue;
+		unsigned int telemetrySequence;
+		T blockMinGain;
+		T blockMaxGain;
+		double blockGainSum;
+		T blockEnvelopePeak;
+		int blockOpenCount;
+
+		// steady state tracking for the fast paths: consecutive silent samples of the main input (saturating), and whether
+		// the last block ran with the detector at rest and silent output
+		int silentInputRun;
+		bool idle;
+
+#ifdef NOISEINVADER_PROFILING
+		KernelProfiler profiler;
+#endif
+
+		// scratch buffers for the block passes
+		static const int BlockSize = EnvelopeFollowerT<T>::BlockSize;
+		alignas(32) T detector[BlockSize];
+		alignas(32) T envelope[BlockSize];
+		alignas(32) T envelopeDb[BlockSize];
+		alignas(32) T expanderDb[BlockSize];
+		alignas(32) T slewDb[BlockSize];
+		alignas(32) T gain[BlockSize];
+		alignas(32) float delayedL[BlockSize];
+		alignas(32) float delayedR[BlockSize];
+		alignas(32) T detectorGains[BlockSize];
+		alignas(32) T reductions[BlockSize];
+		alignas(32) T thresholds[BlockSize];
+		alignas(32) T slopes[BlockSize];
 
 	public:
 
+		static const int MaxLookaheadMs = 10;
+		static const int ParameterRampMs = 20;
+		static const int MaxSampleRate = 384000;
+
+		// State distance below which two kernels count as being on the same trajectory, see GetStateDistanceDb
+		static constexpr double ConvergedDistanceDb = 1e-3;
+
+		// Raised whenever the layout or meaning of Snapshot changes
+		static const uint32_t SnapshotVersion = 11;
+
+		/// <summary>
+		/// The dynamic state of the kernel: the envelope follower, the expander hysteresis, the slew limiter and the lookahead
+		/// history, without the settings and parameter ramps. Plain data that can be copied or written to disk as it is, and
+		/// a few ten kB in size, so keep one around instead of putting it on the audio thread's stack
+		/// </summary>
+		struct Snapshot
+		{
+			uint32_t Version;
+			uint32_t Size;
+			int SampleRate;
+			typename ExpanderT<T>::State Expander;
+			T ExpanderFrom, ExpanderTo;
+			T SlewDb;
+			typename GainRampT<T>::State GainRamp;
+			typename EnvelopeFollowerT<T>::State Follower;
+			typename PeakDetectorT<T>::State PeakHold;
+			DelayLine::State DelayL;
+			DelayLine::State DelayR;
+		};
+
 		// Gain Settings
-		float DetectorGain;
+		T DetectorGain;
 		
 		// Noise Gate Settings
-		double ReductionDb;
-		double ThresholdDb;
-		double Slope;
-		double ReleaseMs;
+		T ReductionDb;
+		T ThresholdDb;
+		T Slope;
+		T ReleaseMs;
+		T LookaheadMs; // 0...MaxLookaheadMs
+
+		// Accuracy of the log / exp conversions in the gain chain. With Exact the output gain is not exponentiated for every
+		// sample but followed incrementally (GainRampT::Follow): within 1e-4 dB, and exact whenever it holds still. The fast
+		// modes exponentiate it in one vectorized pass, which is cheaper still. The fast modes compute in float, so the
+		// double kernel defaults to Exact and the float kernel to Db001
+		MathPrecision Precision;
+
+		// Envelope detector, applied by UpdateAll. Only the selected one runs, the other keeps its state from when it last ran
+		DetectorMode Detector;
+
+		// Lowpass on the hold of the envelope follower, applied by UpdateAll. The one pole cascade by default, see
+		// HoldSmootherMode. Switching continues from the current envelope
+		HoldSmootherMode Smoother;
+
+		// Runs the envelope follower's averages, hold and smoother at the samplerate divided by 1, 2, 4 or 8, applied by
+		// UpdateAll. The expander then runs once per group and its gain is ramped in between. See EnvelopeFollowerT::SetDecimation
+		int DetectorDecimation;
+
+		// Evaluates the expander and slew limiter once every GainInterval samples (1 - GainRampT::MaxInterval, applied by
+		// UpdateAll) and ramps the gain in between. 1, the default, computes the gain for every sample
+		int GainInterval;
 
-		// for readouts
-		double currentGainDb;
+		// Steady state fast paths, bit-exact with the full chain. Only turned off to compare against it
+		bool FastPaths;
 
-		NoiseGateKernel(int fs)
+		// highest gain of the last Process call. Only valid on the audio thread, use PollTelemetry from other threads
+		T currentGainDb;
+
+		NoiseGateKernelT(int fs)
 			: envelopeFollower(fs, 100)
+			, peakDetector(fs)
 			, expander()
 			, slewLimiter(fs)
 		{
 			this->fs = fs;
-			
-			DetectorGain = 1.0f;
+			// detects the instruction set here rather than on the first call of Process, on the audio thread
+			Simd::GetKernels();
+			SetRampLengths();
+			telemetrySequence = 0;
+			for (int i = 0; i < KernelParameterCount; i++)
+			{
+				postedValues[i].store(0, std::memory_order_relaxed);
+				postedChanged[i].store(false, std::memory_order_relaxed);
+			}
+			silentInputRun = 0;
+			idle = false;
+			gainFlat = false;
+#ifdef NOISEINVADER_PROFILING
+			envelopeFollower.SetProfiler(&profiler);
+#endif
+
+			DetectorGain = 1;
 			ReductionDb = -150;
 			ThresholdDb = -20;
 			Slope = 3;
 			ReleaseMs = 100;
+			LookaheadMs = 0;
+			Precision = sizeof(T) == sizeof(double) ? MathPrecision::Exact : MathPrecision::Db001;
+			Detector = DetectorMode::Envelope;
+			Smoother = HoldSmootherMode::OnePoleCascade;
+			DetectorDecimation = 1;
+			GainInterval = 1;
+			FastPaths = true;
 			UpdateAll();
+			expanderFrom = expanderTo = std::numeric_limits<T>::quiet_NaN();
 		}
 
-		inline ~NoiseGateKernel()
+		inline ~NoiseGateKernelT()
 		{
 
 		}
 
+		/// <summary>
+		/// Retunes the kernel to a new samplerate (up to MaxSampleRate) without allocating. Filter, detector
+		/// and delay line state is kept. Must not be called while another thread is inside Process
+		/// </summary>
+		inline void Reconfigure(int fs)
+		{
+			this->fs = fs;
+			envelopeFollower.Reconfigure(fs);
+			peakDetector.Reconfigure(fs);
+			slewLimiter.SetSampleRate(fs);
+			SetRampLengths();
+			UpdateTimes();
+		}
+
+		/// <summary>
+		/// Applies the settings immediately, without smoothing. Must not be called while another thread is inside
+		/// Process; use PostParameter to change settings while processing
+		/// </summary>
 		inline void UpdateAll()
 		{
+			detectorMode = Detector;
+			envelopeFollower.SetHoldSmoother(Smoother);
+			envelopeFollower.SetDecimation(DetectorDecimation);
+			SetGainInterval(GainInterval);
+			detectorGainSmoother.Reset(DetectorGain);
+			reductionSmoother.Reset(ReductionDb);
+			thresholdSmoother.Reset(ThresholdDb);
+			slopeSmoother.Reset(Slope);
 			expander.Update(ThresholdDb, ReductionDb, Slope);
-			envelopeFollower.SetRelease(ReleaseMs);
-			slewLimiter.UpdateDb60(2.0, ReleaseMs);
+			UpdateTimes();
+		}
+
+		/// <summary>
+		/// Posts a parameter change from a control thread. Lock-free and never drops a change: each parameter has one
+		/// slot holding its latest value, so several changes before the next Process call coalesce into the last one.
+		/// May be called from any number of threads while the audio thread is inside Process. The change is applied at
+		/// the start of the next Process call; detector gain, reduction, threshold and slope are then ramped over ParameterRampMs
+		/// </summary>
+		inline void PostParameter(KernelParameter parameter, double value)
+		{
+			postedValues[(int)parameter].store(value, std::memory_order_relaxed);
+			postedChanged[(int)parameter].store(true, std::memory_order_release);
+		}
+
+		/// <summary>
+		/// Takes the oldest metering record from the telemetry ring. Wait-free, for a single consumer thread
+		/// (the UI or a monitoring thread). Returns false if there is none. The audio thread never waits for the
+		/// consumer: when the ring is full, new records are dropped, which shows up as a gap in Sequence
+		/// </summary>
+		inline bool PollTelemetry(GateTelemetry& record)
+		{
+			return telemetryQueue.TryPop(record);
+		}
+
+		/// <summary>
+		/// Per-stage timing histograms. Readable from any thread while processing.
+		/// Null unless the kernel is compiled with NOISEINVADER_PROFILING
+		/// </summary>
+		inline const KernelProfiler* GetProfiler() const
+		{
+#ifdef NOISEINVADER_PROFILING
+			return &profiler;
+#else
+			return nullptr;
+#endif
+		}
+
+		// Size of one instance in bytes. The kernel allocates nothing else, so this is its whole memory footprint
+		static constexpr size_t GetMemoryFootprint()
+		{
+			return sizeof(NoiseGateKernelT<T>);
+		}
+
+		/// <summary>
+		/// Latency of the main path in samples, caused by the lookahead. Report this to the host
+		/// </summary>
+		inline int GetLatencySamples() const
+		{
+			return delayL.GetDelay();
+		}
+
+		/// <summary>
+		/// The latency a given lookahead will cause. Only depends on the samplerate, so it is safe to call from
+		/// the control thread before the change has reached the audio thread
+		/// </summary>
+		inline int GetLatencySamples(double lookaheadMs) const
+		{
+			double lookahead = lookaheadMs < 0 ? 0 : lookaheadMs > MaxLookaheadMs ? MaxLookaheadMs : lookaheadMs;
+			return (int)(lookahead * fs / 1000 + 0.5);
+		}
+
+		/// <summary>
+		/// Samples the output can go on for after the main input has turned silent: the lookahead delay.
+		/// The gain only scales the input, so from then on the output is silent whatever the detector does
+		/// </summary>
+		inline int GetTailSamples() const
+		{
+			return GetLatencySamples();
+		}
+
+		/// <summary>
+		/// True if the last Process call found the detector at rest on silent input and wrote silent output. The output
+		/// stays silent until the input changes, so a host may suspend processing. Only valid on the audio thread
+		/// </summary>
+		inline bool IsIdle() const
+		{
+			return idle;
+		}
+
+		/// <summary>
+		/// Input a kernel started from silence needs before its output follows a kernel that has been running all along,
+		/// within the accuracy shown by the regression harness: the envelope follower settling, a release of the slew
+		/// limiter over the full reduction, and the lookahead delay. A long file can be split into segments that each
+		/// start this far ahead, discard that output, and run in parallel. The peak hold detector settles within the
+		/// follower's hold time, so this covers both detectors
+		/// </summary>
+		inline int GetWarmupSamples() const
+		{
+			double slewMs = std::abs((double)ReductionDb) / 60 * ReleaseMs;
+			return envelopeFollower.GetSettleSamples() + (int)std::ceil(slewMs / 1000 * fs) + gainRamp.GetInterval() + envelopeFollower.GetDecimation()
+				+ GetLatencySamples();
+		}
+
+		/// <summary>
+		/// Largest difference in dB between the gain computer state of this kernel and another one with the same settings:
+		/// the envelope, the expander gain and the slew limiter. The expander has hysteresis and holds its gain for as long
+		/// as the signal stays between its curves, however long the warm-up was, so a warmed-up kernel has only joined the
+		/// trajectory of a kernel that has been running all along once this is close to zero. Expander levels below the
+		/// reduction floor are equivalent: they only move together with the input until a curve lifts or lowers them,
+		/// and both kernels then end up on that curve
+		/// </summary>
+		inline double GetStateDistanceDb(const NoiseGateKernelT<T>& other) const
+		{
+			auto envelopeDb = [](T x) { return x > (T)1e-15 ? std::max(20 * std::log10((double)x), -150.0) : -150.0; };
+			double envelope = std::abs(envelopeDb(GetEnvelope()) - envelopeDb(other.GetEnvelope()));
+			double expanderDb = std::abs((double)expander.GetOutput() - (double)other.expander.GetOutput());
+			double slewDb = std::abs((double)slewLimiter.GetOutput() - (double)other.slewLimiter.GetOutput());
+			return std::max(envelope, std::max(expanderDb, slewDb));
+		}
+
+		/// <summary>
+		/// Copies the dynamic state into snapshot. Allocation-free and only copies the parts in use (the SMA window and
+		/// the history the longest lookahead needs), so it can run every block. Call it on the thread that runs Process
+		/// </summary>
+		inline void TakeSnapshot(Snapshot& snapshot) const
+		{
+			snapshot.Version = SnapshotVersion;
+			snapshot.Size = sizeof(Snapshot);
+			snapshot.SampleRate = (int)fs;
+			expander.GetState(snapshot.Expander);
+			snapshot.ExpanderFrom = expanderFrom;
+			snapshot.ExpanderTo = expanderTo;
+			snapshot.SlewDb = slewLimiter.GetOutput();
+			gainRamp.GetState(snapshot.GainRamp);
+			envelopeFollower.GetState(snapshot.Follower);
+			peakDetector.GetState(snapshot.PeakHold);
+
+			int history = GetLatencySamples(MaxLookaheadMs);
+			delayL.GetState(snapshot.DelayL, history);
+			delayR.GetState(snapshot.DelayR, history);
+		}
+
+		/// <summary>
+		/// Continues from a snapshot taken by this or another kernel, which then produces the same output as the kernel the
+		/// snapshot was taken from, given the same settings. The kernel's own settings and parameter ramps are kept, so a
+		/// restored kernel can also continue with different ones. Returns false and leaves the kernel unchanged if the snapshot
+		/// is from another version or samplerate. Allocation-free; must not be called while another thread is inside Process
+		/// </summary>
+		inline bool RestoreSnapshot(const Snapshot& snapshot)
+		{
+			if (snapshot.Version != SnapshotVersion || snapshot.Size != sizeof(Snapshot) || snapshot.SampleRate != (int)fs)
+				return false;
+
+			expander.SetState(snapshot.Expander);
+			expanderFrom = snapshot.ExpanderFrom;
+			expanderTo = snapshot.ExpanderTo;
+			slewLimiter.SetOutput(snapshot.SlewDb);
+			gainRamp.SetState(snapshot.GainRamp);
+			envelopeFollower.SetState(snapshot.Follower);
+			peakDetector.SetState(snapshot.PeakHold);
+			delayL.SetState(snapshot.DelayL);
+			delayR.SetState(snapshot.DelayR);
+			return true;
 		}
 
 		inline void Process(
@@ -69,33 +438,532 @@ namespace NoiseInvader
 			float* detectorInput, 
 			float* outputL, 
 			float* outputR,
-			int len)
+			int len,
+			const StageTrace* trace = nullptr)
+		{
+#ifdef NOISEINVADER_PROFILING
+			profiler.BeginCall(len);
+#endif
+			NOISEINVADER_PROFILE(&profiler, ProfileStage::Process);
+
+			Simd::PreventDenormals();
+			ApplyPostedParameters();
+
+			blockMinGain = 1000;
+			blockMaxGain = -1000;
+			blockGainSum = 0;
+			blockEnvelopePeak = -1000;
+			blockOpenCount = 0;
+			idle = len > 0;
+
+			for (int pos = 0; pos < len; pos += BlockSize)
+			{
+				int count = len - pos < BlockSize ? len - pos : BlockSize;
+				ProcessBlock(&inputL[pos], &inputR[pos], &detectorInput[pos], &outputL[pos], &outputR[pos], count, pos, trace);
+			}
+
+			currentGainDb = blockMaxGain;
+			PublishTelemetry(len);
+		}
+
+	private:
+
+		// The current output of the selected detector
+		inline T GetEnvelope() const
+		{
+			return detectorMode == DetectorMode::PeakHold ? peakDetector.GetOutput() : envelopeFollower.GetOutput();
+		}
+
+		// True if silence leaves the selected detector, and so the envelope, unchanged
+		inline bool IsDetectorAtRest() const
+		{
+			return detectorMode == DetectorMode::PeakHold ? peakDetector.IsAtRest() : envelopeFollower.IsAtRest();
+		}
+
+		inline void PublishTelemetry(int len)
+		{
+			if (len <= 0)
+				return;
+
+			GateTelemetry record;
+			record.Sequence = telemetrySequence++;
+			record.SampleCount = len;
+			record.MinGainDb = (float)blockMinGain;
+			record.MaxGainDb = (float)blockMaxGain;
+			record.MeanGainDb = (float)(blockGainSum / len);
+			record.EnvelopePeakDb = (float)blockEnvelopePeak;
+			record.OpenFraction = (float)blockOpenCount / len;
+
+			// if the consumer has fallen behind the record is dropped, never wait for it
+			telemetryQueue.TryPush(record);
+		}
+
+		inline void SetRampLengths()
+		{
+			int rampSamples = (int)(ParameterRampMs * fs / 1000);
+			detectorGainSmoother.SetRampLength(rampSamples);
+			reductionSmoother.SetRampLength(rampSamples);
+			thresholdSmoother.SetRampLength(rampSamples);
+			slopeSmoother.SetRampLength(rampSamples);
+		}
+
+		// Switching between steps and the per sample gain starts exactly where the slew limiter is
+		inline void SetGainInterval(int interval)
+		{
+			if (interval == gainRamp.GetInterval())
+				return;
+
+			bool perSample = interval <= 1 || gainRamp.GetInterval() == 1;
+			gainRamp.SetInterval(interval);
+			if (perSample)
+				gainRamp.Reset(slewLimiter.GetOutput());
+		}
+
+		// release and lookahead are not smoothed
+		inline void UpdateTimes()
+		{
+			envelopeFollower.SetRelease(ReleaseMs);
+			envelopeFollower.SetPrecision(Precision);
+			peakDetector.SetDecay((T)Utils::DB2gain(-60 / ((double)ReleaseMs / 1000.0 * fs)));
+			slewLimiter.UpdateDb60(2.0, ReleaseMs);
+
+			int delaySamples = GetLatencySamples(LookaheadMs);
+			delayL.SetDelay(delaySamples);
+			delayR.SetDelay(delaySamples);
+		}
+
+		/// <summary>
+		/// Applies the parameters posted since the last call. Runs on the audio thread and never blocks. The flag is
+		/// cleared before the value is read, so a value posted in between is read now and applied again on the next call
+		/// </summary>
+		inline void ApplyPostedParameters()
+		{
+			bool timesChanged = false;
+
+			for (int i = 0; i < KernelParameterCount; i++)
+			{
+				if (!postedChanged[i].load(std::memory_order_relaxed) || !postedChanged[i].exchange(false, std::memory_order_acquire))
+					continue;
+
+				T value = (T)postedValues[i].load(std::memory_order_relaxed);
+				switch ((KernelParameter)i)
+				{
+				case KernelParameter::DetectorGain:
+					DetectorGain = value;
+					detectorGainSmoother.SetTarget(value);
+					break;
+				case KernelParameter::ReductionDb:
+					ReductionDb = value;
+					reductionSmoother.SetTarget(value);
+					break;
+				case KernelParameter::ThresholdDb:
+					ThresholdDb = value;
+					thresholdSmoother.SetTarget(value);
+					break;
+				case KernelParameter::Slope:
+					Slope = value;
+					slopeSmoother.SetTarget(value);
+					break;
+				case KernelParameter::ReleaseMs:
+					ReleaseMs = value;
+					timesChanged = true;
+					break;
+				case KernelParameter::LookaheadMs:
+					LookaheadMs = value;
+					timesChanged = true;
+					break;
+				}
+			}
+
+			if (timesChanged)
+				UpdateTimes();
+		}
+
+		/// <summary>
+		/// Runs the gain chain as a sequence of passes over the block. The stateless passes (detector gain,
+		/// dB conversion, gain exponentiation, stereo multiply) have no loop-carried dependencies and vectorize, the
+		/// recurrences (follower, expander, slew limiter, the gain factor followed with Exact) run as tight loops over the
+		/// scratch buffers.
+		/// Accumulates the metering values of the block.
+		/// With FastPaths, steady states take shortcuts that give the same result bit for bit:
+		///  - a silent detector block (max-abs pre-scan) reaching a detector at rest is not processed. The envelope stays
+		///    where it is, so the expander and slew limiter only run until their state stops changing
+		///  - a block whose envelope lies above the knees of both expander curves (fully open) skips the expander, one below
+		///    them (closed) runs its hysteresis without the curves, see ExpanderT::ExpandSteady. If that gives one gain for
+		///    the block, the slew limiter only steps until it has reached it
+		///  - a block with a constant gain (fully closed at the reduction floor, or fully open at 0dB) skips the
+		///    exponentiation and becomes a constant multiply, a copy when open, or a memset when the main input is silent
+		/// The detector otherwise always runs, and the hysteresis of a closed gate: their state decides exactly when it opens again
+		/// </summary>
+		inline void ProcessBlock(
+			float* inputL,
+			float* inputR,
+			float* detectorInput,
+			float* outputL,
+			float* outputR,
+			int len,
+			int traceOffset,
+			const StageTrace* trace)
+		{
+			bool settingsSmoothing = reductionSmoother.IsSmoothing() || thresholdSmoother.IsSmoothing() || slopeSmoother.IsSmoothing();
+			bool detectorIdle = FastPaths
+				&& IsDetectorAtRest()
+				&& !detectorGainSmoother.IsSmoothing()
+				&& !settingsSmoothing
+				&& VectorMath::MaxAbs(detectorInput, len) == 0;
+
+			if (detectorIdle)
+				ProcessIdleDetector(len);
+			else
+				ProcessDetector(detectorInput, len);
+
+			// the ramp of the decimated expander takes over from wherever the gain computer is
+			if (!IsExpanderDecimated())
+				expanderFrom = expanderTo = expander.GetOutput();
+
+			if (trace != nullptr)
+			{
+				if (trace->Envelope) Utils::Copy(envelope, &trace->Envelope[traceOffset], len);
+				if (trace->ExpanderDb) Utils::Copy(expanderDb, &trace->ExpanderDb[traceOffset], len);
+				if (trace->SlewDb) Utils::Copy(slewDb, &trace->SlewDb[traceOffset], len);
+			}
+
+			NOISEINVADER_PROFILE(&profiler, ProfileStage::GainApply);
+
+			// metering, branchless reductions that vectorize. The min and max of this block alone tell if the gain is constant
+			T minGain = slewDb[0];
+			T maxGain = slewDb[0];
+			T gainSum = 0;
+			T envelopePeak = blockEnvelopePeak;
+			int openCount = 0;
+			for (int i = 0; i < len; i++)
+			{
+				minGain = slewDb[i] < minGain ? slewDb[i] : minGain;
+				maxGain = slewDb[i] > maxGain ? slewDb[i] : maxGain;
+				gainSum += slewDb[i];
+				envelopePeak = envelopeDb[i] > envelopePeak ? envelopeDb[i] : envelopePeak;
+				openCount += slewDb[i] > (T)GateTelemetry::OpenGainDb;
+			}
+
+			blockMinGain = minGain < blockMinGain ? minGain : blockMinGain;
+			blockMaxGain = maxGain > blockMaxGain ? maxGain : blockMaxGain;
+			blockGainSum += gainSum;
+			blockEnvelopePeak = envelopePeak;
+			blockOpenCount += openCount;
+
+			// runs with zero lookahead as well, so the history is valid when the lookahead is turned on
+			delayL.Process(inputL, delayedL, len);
+			delayR.Process(inputR, delayedR, len);
+
+			bool inputSilent = detectorIdle && VectorMath::MaxAbs(inputL, len) == 0 && VectorMath::MaxAbs(inputR, len) == 0;
+			silentInputRun = inputSilent ? std::min(silentInputRun + len, MaxSampleRate) : 0;
+
+			// silent output once the lookahead delay holds nothing but silence for the whole block
+			bool outputSilent = inputSilent && silentInputRun >= len + delayL.GetDelay();
+			idle &= outputSilent;
+
+			if (outputSilent)
+			{
+				std::memset(outputL, 0, len * sizeof(float));
+				std::memset(outputR, 0, len * sizeof(float));
+			}
+			else if (FastPaths && gainFlat)
+			{
+				ApplyConstantGain(outputL, outputR, gain[0], len);
+			}
+			else if (FastPaths && !IsGainFollowed() && minGain == maxGain)
+			{
+				T blockGain;
+				VectorMath::Db2Gain(&slewDb[0], &blockGain, 1, Precision);
+				ApplyConstantGain(outputL, outputR, blockGain, len);
+			}
+			else
+			{
+				ApplyGain(outputL, outputR, len);
+			}
+		}
+
+		// The full detector, expander and slew limiter, into envelope, envelopeDb, expanderDb, slewDb and gain when followed
+		inline void ProcessDetector(float* detectorInput, int len)
+		{
+			int groupPhase = envelopeFollower.GetDecimationPhase();
+			{
+				NOISEINVADER_PROFILE(&profiler, ProfileStage::DetectorGain);
+				if (detectorGainSmoother.IsSmoothing())
+				{
+					detectorGainSmoother.Process(detectorGains, len);
+					for (int i = 0; i < len; i++)
+						detector[i] = detectorInput[i] * detectorGains[i];
+				}
+				else
+				{
+					T detectorGain = detectorGainSmoother.GetCurrent();
+					for (int i = 0; i < len; i++)
+						detector[i] = detectorInput[i] * detectorGain;
+				}
+			}
+
+			if (detectorMode == DetectorMode::PeakHold)
+			{
+				NOISEINVADER_PROFILE(&profiler, ProfileStage::HoldDecay);
+				for (int i = 0; i < len; i++)
+					detector[i] = std::abs(detector[i]);
+				peakDetector.ProcessPeaks(detector, envelope, len);
+			}
+			else
+			{
+				envelopeFollower.ProcessEnvelope(detector, envelope, len);
+			}
+
+			// the expander held one gain for the whole block, the slew limiter then only steps until it gets there
+			bool expanderFlat = false;
+			{
+				NOISEINVADER_PROFILE(&profiler, ProfileStage::Expander);
+				VectorMath::Gain2Db(envelope, envelopeDb, len, Precision);
+
+				bool settingsSmoothing = reductionSmoother.IsSmoothing() || thresholdSmoother.IsSmoothing() || slopeSmoother.IsSmoothing();
+				if (settingsSmoothing)
+				{
+					reductionSmoother.Process(reductions, len);
+					thresholdSmoother.Process(thresholds, len);
+					slopeSmoother.Process(slopes, len);
+				}
+
+				if (gainRamp.GetInterval() > 1)
+				{
+					gainFlat = ProcessGainSteps(len, settingsSmoothing);
+					return;
+				}
+
+				if (IsExpanderDecimated())
+					expanderFlat = ExpandGroups(groupPhase, len, settingsSmoothing) && FastPaths;
+				else if (settingsSmoothing)
+					expander.Expand(envelopeDb, thresholds, reductions, slopes, expanderDb, len);
+				else if (FastPaths)
+					expanderFlat = expander.ExpandSteady(envelopeDb, expanderDb, len);
+				else
+					expander.Expand(envelopeDb, expanderDb, len);
+			}
+
+			{
+				NOISEINVADER_PROFILE(&profiler, ProfileStage::SlewLimiter);
+				if (expanderFlat)
+					slewLimiter.ProcessConstant(expanderDb[0], slewDb, len);
+				else
+					slewLimiter.Process(expanderDb, slewDb, len);
+				FollowGain(len);
+			}
+		}
+
+		/// <summary>
+		/// Silent block with the detector at rest and the settings steady. The envelope holds its value, so the expander
+		/// and slew limiter see a constant input and are only evaluated until they have settled on it
+		/// </summary>
+		inline void ProcessIdleDetector(int len)
+		{
+			int groupPhase = envelopeFollower.GetDecimationPhase();
+			if (detectorMode == DetectorMode::PeakHold)
+				peakDetector.SkipSilence(len);
+			else
+				envelopeFollower.SkipSilence(len);
+
+			T value = GetEnvelope();
+			T valueDb;
+			VectorMath::Gain2Db(&value, &valueDb, 1, Precision);
+			for (int i = 0; i < len; i++)
+			{
+				envelope[i] = value;
+				envelopeDb[i] = valueDb;
+			}
+
+			if (gainRamp.GetInterval() > 1)
+			{
+				NOISEINVADER_PROFILE(&profiler, ProfileStage::Expander);
+				gainFlat = ProcessGainSteps(len, false);
+				return;
+			}
+
+			if (IsExpanderDecimated())
+			{
+				bool expanderFlat;
+				{
+					NOISEINVADER_PROFILE(&profiler, ProfileStage::Expander);
+					expanderFlat = ExpandGroups(groupPhase, len, false);
+				}
+
+				NOISEINVADER_PROFILE(&profiler, ProfileStage::SlewLimiter);
+				if (expanderFlat)
+					slewLimiter.ProcessConstant(expanderDb[0], slewDb, len);
+				else
+					slewLimiter.Process(expanderDb, slewDb, len);
+				FollowGain(len);
+				return;
+			}
+
+			int settled;
+			{
+				NOISEINVADER_PROFILE(&profiler, ProfileStage::Expander);
+				settled = expander.ExpandConstant(valueDb, expanderDb, len);
+			}
+
+			{
+				NOISEINVADER_PROFILE(&profiler, ProfileStage::SlewLimiter);
+				slewLimiter.Process(expanderDb, slewDb, settled);
+				if (settled < len)
+					slewLimiter.ProcessConstant(expanderDb[settled], &slewDb[settled], len - settled);
+				FollowGain(len);
+			}
+		}
+
+		// True if the expander runs once per group of the decimated follower, see ExpandGroups. The gain steps take precedence
+		inline bool IsExpanderDecimated() const
+		{
+			return detectorMode == DetectorMode::Envelope && envelopeFollower.GetDecimation() > 1 && gainRamp.GetInterval() == 1;
+		}
+
+		/// <summary>
+		/// The expander at the control rate of the decimated follower. It sees each new envelope value at the sample that
+		/// completes its group, phase counting the samples of the group at the start of the block, and its gain is ramped
+		/// linearly in dB from the last result to the new one over the following group, so it arrives one group late.
+		/// The slew limiter still runs on every sample. Writes expanderDb and returns whether it holds one value
+		/// </summary>
+		inline bool ExpandGroups(int phase, int len, bool settingsSmoothing)
 		{
-			Sse::PreventDernormals();
-			double gainDb = 1.0;
-			double currGain = -1000;
+			int decimation = envelopeFollower.GetDecimation();
+			T scale = (T)(1.0 / decimation);
+			// the first block starts the ramp at the gain of its first envelope value, which the follower held before it
+			if (std::isnan(expanderTo))
+			{
+				expander.Expand(envelopeDb[0]);
+				expanderFrom = expanderTo = expander.GetOutput();
+			}
 
-			for (size_t i = 0; i < len; i++)
+			T from = expanderFrom;
+			T to = expanderTo;
+			bool flat = from == to;
+			for (int i = 0; i < len; i++)
 			{
-				auto x = detectorInput[i] * DetectorGain;
-				envelopeFollower.ProcessEnvelope(x);
-				auto env = envelopeFollower.GetOutput();
+				phase++;
+				expanderDb[i] = from + (to - from) * ((T)phase * scale);
+				if (phase == decimation)
+				{
+					phase = 0;
+					if (settingsSmoothing)
+						expander.Update(thresholds[i], reductions[i], slopes[i]);
+					expander.Expand(envelopeDb[i]);
+					from = to;
+					to = expander.GetOutput();
+					flat &= from == to;
+				}
+			}
 
-				expander.Expand(Utils::Gain2DB(env));
-				gainDb = expander.GetOutput();
-				gainDb = slewLimiter.Process(gainDb);
+			// the settings of the last sample stay in effect, as with the per sample expander
+			if (settingsSmoothing)
+				expander.Update(thresholds[len - 1], reductions[len - 1], slopes[len - 1]);
 
-				if (gainDb > currGain)
-					currGain = gainDb;
+			expanderFrom = from;
+			expanderTo = to;
+			return flat;
+		}
+
+		/// <summary>
+		/// The gain computer at the control rate: the expander and the slew limiter see every GainInterval-th envelope
+		/// sample, and each step ramps the gain to the result over the following GainInterval samples, so the gain reaches
+		/// it GainInterval - 1 samples later than the per sample chain would. The slew limiter takes whole steps at its
+		/// per sample rates and the ramp is linear in dB, so no sample moves faster than the 2ms attack or the release allow.
+		/// The steps continue across blocks. Writes expanderDb (held over each step), slewDb and gain, and returns whether
+		/// every step of the block held the gain where it was
+		/// </summary>
+		inline bool ProcessGainSteps(int len, bool settingsSmoothing)
+		{
+			bool flat = true;
+			int interval = gainRamp.GetInterval();
+			for (int i = 0; i < len;)
+			{
+				if (gainRamp.IsStepDone())
+				{
+					if (settingsSmoothing)
+						expander.Update(thresholds[i], reductions[i], slopes[i]);
+					expander.Expand(envelopeDb[i]);
+					T deltaDb = slewLimiter.Step(expander.GetOutput(), interval);
+					gainRamp.Start(deltaDb, slewLimiter.GetOutput());
+				}
 
-				auto gain = Utils::DB2gain(gainDb);
-				outputL[i] = inputL[i] * gain;
-				outputR[i] = inputR[i] * gain;
+				flat &= gainRamp.IsFlat();
+				int count = gainRamp.Process(&slewDb[i], &gain[i], len - i);
+				T expanderGainDb = expander.GetOutput();
+				for (int k = 0; k < count; k++)
+					expanderDb[i + k] = expanderGainDb;
+
+				i += count;
 			}
 
-			currentGainDb = currGain;
+			// the settings of the last sample stay in effect, as with the per sample expander
+			if (settingsSmoothing)
+				expander.Update(thresholds[len - 1], reductions[len - 1], slopes[len - 1]);
+
+			return flat;
+		}
+
+		// True if the gain factor is computed along with slewDb, by the gain steps or by following it, see Precision
+		inline bool IsGainFollowed() const
+		{
+			return gainRamp.GetInterval() > 1 || Precision == MathPrecision::Exact;
+		}
+
+		/// <summary>
+		/// The gain factor of every sample of slewDb, with an interval of 1. With Exact it is followed incrementally, in
+		/// the fast modes ApplyGain exponentiates it and the ramp is only kept on the slew limiter's level, so following
+		/// can continue from any block
+		/// </summary>
+		inline void FollowGain(int len)
+		{
+			if (IsGainFollowed())
+			{
+				gainFlat = gainRamp.Follow(slewDb, gain, len);
+			}
+			else
+			{
+				gainFlat = false;
+				if (gainRamp.GetLevel() != slewDb[len - 1])
+					gainRamp.Reset(slewDb[len - 1]);
+			}
 		}
 
+		inline void ApplyGain(float* outputL, float* outputR, int len)
+		{
+			if (!IsGainFollowed())
+				VectorMath::Db2Gain(slewDb, gain, len, Precision);
+
+			for (int i = 0; i < len; i++)
+			{
+				outputL[i] = (float)(delayedL[i] * gain[i]);
+				outputR[i] = (float)(delayedR[i] * gain[i]);
+			}
+		}
+
+		// The same gain for the whole block: a copy when the gate is open, else a constant multiply
+		inline void ApplyConstantGain(float* outputL, float* outputR, T blockGain, int len)
+		{
+			if (blockGain == 1)
+			{
+				std::memcpy(outputL, delayedL, len * sizeof(float));
+				std::memcpy(outputR, delayedR, len * sizeof(float));
+			}
+			else
+			{
+				for (int i = 0; i < len; i++)
+				{
+					outputL[i] = (float)(delayedL[i] * blockGain);
+					outputR[i] = (float)(delayedR[i] * blockGain);
+				}
+			}
+		}
 	};
-}
 
+	extern template class NoiseGateKernelT<float>;
+	extern template class NoiseGateKernelT<double>;
+
+	typedef NoiseGateKernelT<float> NoiseGateKernel;
+	typedef NoiseGateKernelT<double> NoiseGateKernelDouble;
+}
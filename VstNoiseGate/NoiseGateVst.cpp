@@ -9,8 +9,9 @@ const char* DeveloperName = "Valdemar Erlingsson";
 
 AudioEffect* createEffectInstance (audioMasterCallback audioMaster)
 {
+	// The lookup tables are built once per process on first use, later instances find them ready.
+	// This builds the filter design tables here rather than in the first samplerate change
 	Utils::Initialize();
-	ValueTables::Init();
 	return new NoiseGateVst(audioMaster);
 }
 
@@ -37,7 +38,10 @@ NoiseGateVst::NoiseGateVst(audioMasterCallback audioMaster)
 	parameters[(int)Parameters::ThresholdDb] = 0.8;
 	parameters[(int)Parameters::Slope] = 0.5;
 	parameters[(int)Parameters::ReleaseMs] = 0.3;
-	//parameters[(int)Parameters::CurrentGain] = 0.0;
+	parameters[(int)Parameters::LookaheadMs] = 0.0;
+	parameters[(int)Parameters::CurrentGain] = 1.0;
+	telemetryPolling.clear();
+	currentGainDb.store(GateTelemetry().MaxGainDb);
 	
 	createDevice();
 }
@@ -98,44 +102,98 @@ void NoiseGateVst::getProgramName(char* name)
 	vst_strncpy(name, programName, kVstMaxProgNameLen);
 }
 
+// Maps the normalized parameter value to the kernel setting
+double NoiseGateVst::getKernelValue(Parameters parameter, float value)
+{
+	switch (parameter)
+	{
+	case Parameters::DetectorGain:
+		return Utils::DB2gain(40 * value - 20);
+	case Parameters::ReductionDb:
+		return -value * 100;
+	case Parameters::ReleaseMs:
+		return 10 + ValueTables::Get(value, ValueTables::Response2Dec()) * 990;
+	case Parameters::Slope:
+		return 1.0f + ValueTables::Get(value, ValueTables::Response2Dec()) * 50;
+	case Parameters::ThresholdDb:
+		return -ValueTables::Get(1 - value, ValueTables::Response2Oct()) * 80;
+	case Parameters::LookaheadMs:
+		return value * NoiseGateKernel::MaxLookaheadMs;
+	default:
+		return value;
+	}
+}
+
 void NoiseGateVst::setParameter(VstInt32 index, float value)
 {
+	// read only
+	if ((Parameters)index == Parameters::CurrentGain)
+		return;
+
 	parameters[index] = value;
-	bool update = true;
+	double kernelValue = getKernelValue((Parameters)index, value);
 
+	// The host may call this from any thread while processReplacing runs on the audio thread. Changes are handed
+	// over through the kernel's lock-free parameter slots and applied at the start of the next block
 	switch ((Parameters)index)
 	{
 	case Parameters::DetectorInput:
 		detectorInput = (int)(value * 1.999);
 		break;
 	case Parameters::DetectorGain:
-		kernel->DetectorGain = Utils::DB2gain(40 * value - 20);
+		kernel->PostParameter(KernelParameter::DetectorGain, kernelValue);
 		break;
 	case Parameters::ReductionDb:
-		kernel->ReductionDb = -value * 100;
+		kernel->PostParameter(KernelParameter::ReductionDb, kernelValue);
 		break;
 	case Parameters::ReleaseMs:
-		kernel->ReleaseMs = 10 + ValueTables::Get(value, ValueTables::Response2Dec) * 990;
+		kernel->PostParameter(KernelParameter::ReleaseMs, kernelValue);
 		break;
 	case Parameters::Slope:
-		kernel->Slope = 1.0f + ValueTables::Get(value, ValueTables::Response2Dec) * 50;
+		kernel->PostParameter(KernelParameter::Slope, kernelValue);
 		break;
 	case Parameters::ThresholdDb:
-		kernel->ThresholdDb = -ValueTables::Get(1 - value, ValueTables::Response2Oct) * 80;
+		kernel->PostParameter(KernelParameter::ThresholdDb, kernelValue);
+		break;
+	case Parameters::LookaheadMs:
+		kernel->PostParameter(KernelParameter::LookaheadMs, kernelValue);
+		updateLatency(kernel->GetLatencySamples(kernelValue));
 		break;
 	default:
-		update = false;
+		break;
 	}
-
-	if (update)
-		kernel->UpdateAll();
 }
 
 float NoiseGateVst::getParameter(VstInt32 index)
 {
+	if ((Parameters)index == Parameters::CurrentGain)
+	{
+		pollTelemetry();
+		float value = currentGainDb.load(std::memory_order_relaxed) / 150 + 1;
+		return value < 0 ? 0 : value > 1 ? 1 : value;
+	}
+
 	return parameters[index];
 }
 
+// Drains the kernel's telemetry ring and keeps the newest gain. Hosts call the getters from the UI thread and from
+// others at the same time, the flag keeps the ring to one consumer: a caller finding it taken reads the cached gain
+void NoiseGateVst::pollTelemetry()
+{
+	if (telemetryPolling.test_and_set(std::memory_order_acquire))
+		return;
+
+	GateTelemetry record;
+	bool received = false;
+	while (kernel->PollTelemetry(record))
+		received = true;
+
+	if (received)
+		currentGainDb.store(record.MaxGainDb, std::memory_order_relaxed);
+
+	telemetryPolling.clear(std::memory_order_release);
+}
+
 void NoiseGateVst::getParameterName(VstInt32 index, char* label)
 {
 	switch ((Parameters)index)
@@ -158,11 +216,14 @@ void NoiseGateVst::getParameterName(VstInt32 index, char* label)
 	case Parameters::ThresholdDb:
 		strcpy(label, "Threshold");
 		break;
+	case Parameters::LookaheadMs:
+		strcpy(label, "Lookahead");
+		break;
 
 	// for readout only
-	/*case Parameters::CurrentGain:
+	case Parameters::CurrentGain:
 		strcpy(label, "Output Gain");
-		break;*/
+		break;
 	}
 }
 
@@ -179,23 +240,21 @@ void NoiseGateVst::getParameterDisplay(VstInt32 index, char* text)
 			sprintf(text, "-----");
 		break;
 	case Parameters::DetectorGain:
-		sprintf(text, "%.2f", Utils::Gain2DB(kernel->DetectorGain));
+		sprintf(text, "%.2f", Utils::Gain2DB(getKernelValue(Parameters::DetectorGain, parameters[index])));
 		break;
 	case Parameters::ReductionDb:
-		sprintf(text, "%.1f", kernel->ReductionDb);
-		break;
 	case Parameters::ReleaseMs:
-		sprintf(text, "%.1f", kernel->ReleaseMs);
+	case Parameters::ThresholdDb:
+	case Parameters::LookaheadMs:
+		sprintf(text, "%.1f", getKernelValue((Parameters)index, parameters[index]));
 		break;
 	case Parameters::Slope:
-		sprintf(text, "%.2f", kernel->Slope);
+		sprintf(text, "%.2f", getKernelValue(Parameters::Slope, parameters[index]));
 		break;
-	case Parameters::ThresholdDb:
-		sprintf(text, "%.1f", kernel->ThresholdDb);
+	case Parameters::CurrentGain:
+		pollTelemetry();
+		sprintf(text, "%.1f", currentGainDb.load(std::memory_order_relaxed));
 		break;
-	/*case Parameters::CurrentGain:
-		sprintf(text, "%.7f", kernel->currentGainDb);
-		break;*/
 	}
 }
 
@@ -213,13 +272,14 @@ void NoiseGateVst::getParameterLabel(VstInt32 index, char* label)
 		strcpy(label, "dB");
 		break;
 	case Parameters::ReleaseMs:
+	case Parameters::LookaheadMs:
 		strcpy(label, "ms");
 		break;
 	case Parameters::Slope:
 		strcpy(label, "");
 		break;
 	case Parameters::ThresholdDb:
-	//case Parameters::CurrentGain:
+	case Parameters::CurrentGain:
 		strcpy(label, "dB");
 		break;
 	}
@@ -259,13 +319,23 @@ void NoiseGateVst::processReplacing(float** inputs, float** outputs, VstInt32 sa
 	float* detector = detectorInput == 0 ? inputs[0] : inputs[2];
     
 	kernel->Process(inL, inR, detector, outL, outR, sampleFrames);
-	//setParameterAutomated((int)Parameters::CurrentGain, kernel->currentGainDb / 150 + 1);
 }
 
 void NoiseGateVst::setSampleRate(float sampleRate)
 {
 	this->sampleRate = sampleRate;
-	createDevice();
+
+	// retuned in place, the kernel is only allocated once in createDevice
+	kernel->Reconfigure((int)sampleRate);
+	updateLatency(kernel->GetLatencySamples());
+}
+
+VstInt32 NoiseGateVst::getGetTailSize()
+{
+	// Once the input is silent the output follows within the lookahead, and the kernel skips its detector
+	// (NoiseGateKernel::IsIdle), so the host may suspend the plugin. 1 means no tail at all, 0 would mean unknown
+	int tail = kernel->GetTailSamples();
+	return tail > 0 ? tail : 1;
 }
 
 void NoiseGateVst::createDevice()
@@ -273,10 +343,25 @@ void NoiseGateVst::createDevice()
 	delete kernel;
 	kernel = new NoiseGateKernel(sampleRate);
 
-	// re-apply parameters
-	for (size_t i = 0; i < (int)Parameters::Count; i++)
+	// re-apply parameters. Processing is suspended here, so the settings are applied directly without smoothing
+	kernel->DetectorGain = getKernelValue(Parameters::DetectorGain, parameters[(int)Parameters::DetectorGain]);
+	kernel->ReductionDb = getKernelValue(Parameters::ReductionDb, parameters[(int)Parameters::ReductionDb]);
+	kernel->ThresholdDb = getKernelValue(Parameters::ThresholdDb, parameters[(int)Parameters::ThresholdDb]);
+	kernel->Slope = getKernelValue(Parameters::Slope, parameters[(int)Parameters::Slope]);
+	kernel->ReleaseMs = getKernelValue(Parameters::ReleaseMs, parameters[(int)Parameters::ReleaseMs]);
+	kernel->LookaheadMs = getKernelValue(Parameters::LookaheadMs, parameters[(int)Parameters::LookaheadMs]);
+	kernel->UpdateAll();
+	detectorInput = (int)(parameters[(int)Parameters::DetectorInput] * 1.999);
+	updateLatency(kernel->GetLatencySamples());
+}
+
+void NoiseGateVst::updateLatency(int latency)
+{
+	// The lookahead delays the main path, tell the host so it can compensate
+	if (latency != cEffect.initialDelay)
 	{
-		setParameter(i, parameters[i]);
+		setInitialDelay(latency);
+		ioChanged();
 	}
 }
 
@@ -1,6 +1,7 @@
 #ifndef _NoiseGateVst
 #define _NoiseGateVst
 
+#include <atomic>
 #include "public.sdk/source/vst2.x/audioeffectx.h"
 #include "NoiseGateKernel.h"
 
@@ -15,8 +16,10 @@ enum class Parameters
 	ThresholdDb,
 	Slope,
 	ReleaseMs,
+	LookaheadMs,
 
-	//CurrentGain,
+	// read only, output gain from the kernel telemetry
+	CurrentGain,
 
 	Count
 };
@@ -29,8 +32,8 @@ public:
 	NoiseGateVst(audioMasterCallback audioMaster);
 	~NoiseGateVst();
 	
-	bool NoiseGateVst::getInputProperties(VstInt32 index, VstPinProperties* properties);
-	bool NoiseGateVst::getOutputProperties(VstInt32 index, VstPinProperties* properties);
+	bool getInputProperties(VstInt32 index, VstPinProperties* properties);
+	bool getOutputProperties(VstInt32 index, VstPinProperties* properties);
 
 	// Programs
 	virtual void setProgramName (char* name);
@@ -52,13 +55,19 @@ public:
 	// Processing
 	virtual void processReplacing(float** inputs, float** outputs, VstInt32 sampleFrames);
 	virtual void setSampleRate(float sampleRate);
+	virtual VstInt32 getGetTailSize();
 	void createDevice();
+	void updateLatency(int latency);
+	void pollTelemetry();
+	static double getKernelValue(Parameters parameter, float value);
 
 protected:
 	float parameters[(int)Parameters::Count];
 	char programName[kVstMaxProgNameLen + 1];
 	int detectorInput;
 	NoiseGateKernel* kernel;
+	std::atomic_flag telemetryPolling; // held by the one thread draining the telemetry ring
+	std::atomic<float> currentGainDb; // MaxGainDb of the newest telemetry record
 };
 
 #endif
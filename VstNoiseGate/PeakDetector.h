@@ -1,121 +1,138 @@
 #pragma once
 
-class IntFloatPair
-{
-public:
-	long Int;
-	float Float;
+#include "AudioLib/SlidingExtreme.h"
 
-	IntFloatPair()
+namespace NoiseInvader
+{
+	/// <summary>
+	/// Peak hold detector over sample type T, float or double. Holds the largest local peak of the last hold period
+	/// and decays towards the input once no peak is left in it. The peaks sit in a sliding window maximum, so the
+	/// cost per sample does not depend on the hold time or samplerate. All state is held by value, sized for
+	/// MaxHoldSamples, and Reconfigure() retunes it to another samplerate in place
+	/// </summary>
+	template<typename T>
+	class PeakDetectorT
 	{
-		Int = 0;
-		Float = 0.0f;
-	}
+	public:
+		// Longest hold, over 10ms at 384kHz. The window holds one sample more, the one the peak is seen on
+		static const int MaxHoldSamples = 4095;
 
-	IntFloatPair(int i, float f)
-	{
-		Int = i;
-		Float = f;
-	}
-};
+		// The peaks in the window and the detector output, plain data for kernel snapshots
+		struct State
+		{
+			T PrevInputValue;
+			T CurrentValue;
+			typename AudioLib::SlidingMaxT<T, MaxHoldSamples + 1>::State Peaks;
+		};
 
-class PeakDetector
-{
-private:
-	
-	// array of peaks and the time indices
-	IntFloatPair* peakStorage;
+	private:
+		double fs;
+		double peakHoldMillis;
 
-	// Samplerate
-	float fs;
+		// The decay of the output value, when no peak is active to keep it level
+		T decay;
 
-	// The decay of the output value, when no peak is active to keep it level
-	float decay;
+		// The previous input value. If new input value < prevInputValue, then that was a peak
+		T prevInputValue;
 
-	// The maximum number of samples we see in the hold period specified
-	int windowSize;
-	
-	// The previous input value. If new input value < prevInputValue, then that was a peak
-	float prevInputValue;
+		// the output value of the detector
+		T currentValue;
 
-	// iterator that increments by one for every sample processed.
-	long timeIndex;
+		// peaks of the hold period, stamped with the sample after them
+		AudioLib::SlidingMaxT<T, MaxHoldSamples + 1> peaks;
 
-	int peakReadIndex;
-	int peakWriteIndex;
+	public:
+		PeakDetectorT(double fs, T decay = (T)0.995, double peakHoldMillis = 10.0)
+		{
+			// currently, I just use the defaults, they work very well for a guitar signal.
+			this->decay = decay;
+			this->peakHoldMillis = peakHoldMillis;
+			Reconfigure(fs);
 
-	// the output value of the detector
-	float currentValue;
+			prevInputValue = 0;
+			currentValue = 0;
+		}
 
-public:
-	PeakDetector(double fs, float decay = 0.995f, float peakHoldMillis = 10.0f)
-	{
-		this->fs = fs;
+		// Recomputes the hold window, the peaks in it are kept
+		void Reconfigure(double fs)
+		{
+			this->fs = fs;
+			SetHold(peakHoldMillis);
+		}
 
-		// currently, I just use the defaults, they work very well for a guitar signal.
-		this->decay = decay;
-		windowSize = (int)(peakHoldMillis / 1000.0f * fs);
-		
-		peakStorage = new IntFloatPair[windowSize];
+		// Clamped to MaxHoldSamples
+		void SetHold(double peakHoldMillis)
+		{
+			this->peakHoldMillis = peakHoldMillis;
+			int windowSize = (int)(peakHoldMillis / 1000.0 * fs);
 
-		prevInputValue = 0.0f;
-		timeIndex = 0;
-		peakReadIndex = 0;
-		peakWriteIndex = 0;
+			// a peak stays from the sample it is seen on until windowSize samples later
+			peaks.SetWindow((windowSize < 0 ? 0 : windowSize > MaxHoldSamples ? MaxHoldSamples : windowSize) + 1);
+		}
 
-		currentValue = 0.0f;
-	}
+		// Output factor per sample while no peak holds the output
+		void SetDecay(T decay)
+		{
+			this->decay = decay;
+		}
 
-	~PeakDetector()
-	{
-		delete[] peakStorage;
-	}
+		T GetOutput() const
+		{
+			return currentValue;
+		}
 
-	inline float ProcessPeaks(float val)
-	{
-		if (val < prevInputValue) // we just saw a peak, store it
+		// True if silence leaves the detector where it is: no peak held and the output decayed to 0
+		bool IsAtRest() const
+		{
+			return prevInputValue == 0 && currentValue == 0 && peaks.IsEmpty();
+		}
+
+		// Stands in for processing len samples of silence while IsAtRest()
+		void SkipSilence(int len)
 		{
-			peakStorage[peakWriteIndex] = IntFloatPair(timeIndex, prevInputValue);
-			peakWriteIndex = (peakWriteIndex + 1) % windowSize;
+			peaks.Skip(len);
 		}
-		prevInputValue = val;
-
-		// find largest peak within our look-back period
-		IntFloatPair maxPeak;
-		bool foundPeak = false;
-		int readIdx = peakReadIndex;
-		int minTimeIndex = timeIndex - windowSize;
-		while (readIdx != peakWriteIndex)
+
+		inline T ProcessPeaks(T val)
 		{
-			auto p = peakStorage[readIdx];
-			if (p.Int < minTimeIndex)
-			{
-				// this is old data, move read header forward
-				peakReadIndex = (peakReadIndex + 1) % windowSize;
-			}
+			if (val < prevInputValue) // we just saw a peak, store it
+				peaks.Push(prevInputValue);
+			prevInputValue = val;
+
+			// if no peak has occurred in the time period we are looking back at, fall back to a decaying signal
+			auto fallbackValue = currentValue * decay;
+			if (fallbackValue < val)
+				fallbackValue = val;
+
+			if (!peaks.IsEmpty() && peaks.GetExtreme() > fallbackValue)
+				currentValue = peaks.GetExtreme();
 			else
-			{
-				if (!foundPeak || p.Float > maxPeak.Float)
-				{
-					maxPeak = p;
-					foundPeak = true;
-				}
-			}
-
-			readIdx = (readIdx + 1) % windowSize;
+				currentValue = fallbackValue;
+
+			peaks.Advance();
+			return currentValue;
+		}
+
+		void ProcessPeaks(const T* input, T* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = ProcessPeaks(input[i]);
 		}
 
-		// if no peak has occurred in the time period we are looking back at, fall back to a decaying signal
-		auto fallbackValue = currentValue * decay;
-		if (fallbackValue < val)
-			fallbackValue = val;
+		void GetState(State& state) const
+		{
+			state.PrevInputValue = prevInputValue;
+			state.CurrentValue = currentValue;
+			peaks.GetState(state.Peaks);
+		}
 
-		if (foundPeak && maxPeak.Float > fallbackValue)
-			currentValue = maxPeak.Float;
-		else
-			currentValue = fallbackValue;
+		void SetState(const State& state)
+		{
+			prevInputValue = state.PrevInputValue;
+			currentValue = state.CurrentValue;
+			peaks.SetState(state.Peaks);
+		}
+	};
 
-		timeIndex++;
-		return currentValue;
-	}
-};
+	typedef PeakDetectorT<float> PeakDetector;
+}
@@ -0,0 +1,89 @@
+#include "Profiler.h"
+
+#include <chrono>
+#include <thread>
+
+namespace NoiseInvader
+{
+	double KernelProfiler::TicksPerSecond()
+	{
+#ifdef NOISEINVADER_HAS_TSC
+		static const double ticksPerSecond = []()
+		{
+			auto t0 = std::chrono::steady_clock::now();
+			auto c0 = ReadTicks();
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			auto c1 = ReadTicks();
+			auto t1 = std::chrono::steady_clock::now();
+			double seconds = std::chrono::duration<double>(t1 - t0).count();
+			return (c1 - c0) / seconds;
+		}();
+		return ticksPerSecond;
+#else
+		return 1e9;
+#endif
+	}
+
+	ProfileStats KernelProfiler::GetStats(ProfileStage stage, int blockSize) const
+	{
+		auto& h = GetHistogram(stage, blockSize);
+		ProfileStats stats;
+		stats.Count = h.GetCount();
+		stats.P50 = h.GetPercentile(0.5);
+		stats.P99 = h.GetPercentile(0.99);
+		stats.P999 = h.GetPercentile(0.999);
+		stats.Max = h.GetMax();
+		return stats;
+	}
+
+	void KernelProfiler::Reset()
+	{
+		for (int s = 0; s < (int)ProfileStage::Count; s++)
+			for (int c = 0; c < SizeClassCount; c++)
+				histograms[s][c].Reset();
+	}
+
+	const char* KernelProfiler::GetStageName(ProfileStage stage)
+	{
+		switch (stage)
+		{
+		case ProfileStage::Process: return "Process";
+		case ProfileStage::DetectorGain: return "DetectorGain";
+		case ProfileStage::DetectorFilter: return "DetectorFilter";
+		case ProfileStage::Averages: return "SMA/EMA";
+		case ProfileStage::HoldDecay: return "Hold/Decay";
+		case ProfileStage::Smoother: return "Smoother";
+		case ProfileStage::Expander: return "Expander";
+		case ProfileStage::SlewLimiter: return "SlewLimiter";
+		case ProfileStage::GainApply: return "GainApply";
+		default: return "?";
+		}
+	}
+
+	void KernelProfiler::Print(FILE* out, size_t instanceBytes) const
+	{
+		double nsPerTick = 1e9 / TicksPerSecond();
+		std::fprintf(out, "Kernel instance: %zu bytes\n", instanceBytes);
+		std::fprintf(out, "%-16s %8s %10s %10s %10s %10s %10s\n", "stage", "block", "count", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+
+		for (int c = 0; c < SizeClassCount; c++)
+		{
+			int blockSize = 1 << c;
+			for (int s = 0; s < (int)ProfileStage::Count; s++)
+			{
+				auto stats = GetStats((ProfileStage)s, blockSize);
+				if (stats.Count == 0)
+					continue;
+
+				std::fprintf(out, "%-16s %8d %10llu %10.0f %10.0f %10.0f %10.0f\n",
+					GetStageName((ProfileStage)s),
+					blockSize,
+					(unsigned long long)stats.Count,
+					stats.P50 * nsPerTick,
+					stats.P99 * nsPerTick,
+					stats.P999 * nsPerTick,
+					stats.Max * nsPerTick);
+			}
+		}
+	}
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define NOISEINVADER_HAS_TSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#include <chrono>
+#endif
+
+namespace NoiseInvader
+{
+	// The timed sections of NoiseGateKernel::Process. Process covers the whole call
+	enum class ProfileStage
+	{
+		Process,
+		DetectorGain,
+		DetectorFilter,
+		Averages,
+		HoldDecay,
+		Smoother,
+		Expander,
+		SlewLimiter,
+		GainApply,
+		Count
+	};
+
+	/// <summary>
+	/// Histogram of durations with logarithmic buckets, four per octave (about 19% resolution).
+	/// Written by one thread (the audio thread) with plain relaxed stores, so recording never waits,
+	/// and can be read from any other thread at any time. Readers may see a record half applied,
+	/// which only ever shifts a single count
+	/// </summary>
+	class LatencyHistogram
+	{
+	public:
+		static const int BucketCount = 160; // up to 2^40 ticks
+
+	private:
+		std::atomic<uint32_t> counts[BucketCount];
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> maxTicks;
+
+	public:
+		LatencyHistogram()
+		{
+			Reset();
+		}
+
+		// Not safe while the writer is active
+		void Reset()
+		{
+			for (int i = 0; i < BucketCount; i++)
+				counts[i].store(0, std::memory_order_relaxed);
+			count.store(0, std::memory_order_relaxed);
+			maxTicks.store(0, std::memory_order_relaxed);
+		}
+
+		inline void Record(uint64_t ticks)
+		{
+			int b = Bucket(ticks);
+			counts[b].store(counts[b].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			if (ticks > maxTicks.load(std::memory_order_relaxed))
+				maxTicks.store(ticks, std::memory_order_relaxed);
+		}
+
+		uint64_t GetCount() const
+		{
+			return count.load(std::memory_order_relaxed);
+		}
+
+		uint64_t GetMax() const
+		{
+			return maxTicks.load(std::memory_order_relaxed);
+		}
+
+		/// <summary>
+		/// Upper edge of the bucket that holds the given fraction (0...1) of the recorded values, at most the maximum
+		/// </summary>
+		uint64_t GetPercentile(double fraction) const
+		{
+			uint64_t total = 0;
+			for (int i = 0; i < BucketCount; i++)
+				total += counts[i].load(std::memory_order_relaxed);
+
+			if (total == 0)
+				return 0;
+
+			uint64_t rank = (uint64_t)(fraction * total);
+			if (rank >= total)
+				rank = total - 1;
+
+			uint64_t seen = 0;
+			for (int i = 0; i < BucketCount; i++)
+			{
+				seen += counts[i].load(std::memory_order_relaxed);
+				if (seen > rank)
+				{
+					auto edge = UpperEdge(i);
+					auto max = GetMax();
+					return edge < max ? edge : max;
+				}
+			}
+
+			return GetMax();
+		}
+
+		static inline int Bucket(uint64_t ticks)
+		{
+			if (ticks < 4)
+				return (int)ticks;
+
+			int octave = 63 - CountLeadingZeros(ticks);
+			int sub = (int)(ticks >> (octave - 2)) & 3;
+			int b = (octave - 1) * 4 + sub;
+			return b < BucketCount ? b : BucketCount - 1;
+		}
+
+		static inline uint64_t UpperEdge(int bucket)
+		{
+			if (bucket < 4)
+				return (uint64_t)bucket;
+
+			int octave = bucket / 4 + 1;
+			int sub = bucket % 4;
+			return ((uint64_t)(4 + sub + 1) << (octave - 2)) - 1;
+		}
+
+	private:
+		static inline int CountLeadingZeros(uint64_t x)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse64(&index, x);
+			return 63 - (int)index;
+#else
+			return __builtin_clzll(x);
+#endif
+		}
+	};
+
+	struct ProfileStats
+	{
+		uint64_t Count;
+		uint64_t P50;
+		uint64_t P99;
+		uint64_t P999;
+		uint64_t Max;
+	};
+
+	/// <summary>
+	/// Per-stage timing of one kernel instance. Every stage has one histogram per block size class (powers of two,
+	/// the block size of the Process call), so jitter can be compared across host buffer sizes.
+	/// Only compiled into the kernel when NOISEINVADER_PROFILING is defined
+	/// </summary>
+	class KernelProfiler
+	{
+	public:
+		static const int SizeClassCount = 14; // 1 ... 8192 and above
+
+	private:
+		LatencyHistogram histograms[(int)ProfileStage::Count][SizeClassCount];
+		int sizeClass;
+
+	public:
+		KernelProfiler()
+		{
+			sizeClass = 0;
+		}
+
+		static inline uint64_t ReadTicks()
+		{
+#ifdef NOISEINVADER_HAS_TSC
+			return __rdtsc();
+#else
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+		}
+
+		// Tick rate of ReadTicks(), measured against steady_clock the first time it is called
+		static double TicksPerSecond();
+
+		static inline int SizeClass(int blockSize)
+		{
+			int c = 0;
+			while (c < SizeClassCount - 1 && (2 << c) <= blockSize)
+				c++;
+			return c;
+		}
+
+		// Called by the kernel at the start of every Process call
+		inline void BeginCall(int blockSize)
+		{
+			sizeClass = SizeClass(blockSize);
+		}
+
+		inline void Record(ProfileStage stage, uint64_t ticks)
+		{
+			histograms[(int)stage][sizeClass].Record(ticks);
+		}
+
+		const LatencyHistogram& GetHistogram(ProfileStage stage, int blockSize) const
+		{
+			return histograms[(int)stage][SizeClass(blockSize)];
+		}
+
+		ProfileStats GetStats(ProfileStage stage, int blockSize) const;
+
+		// Not safe while the kernel is processing
+		void Reset();
+
+		static const char* GetStageName(ProfileStage stage);
+
+		/// <summary>
+		/// Prints p50 / p99 / p99.9 / max in nanoseconds for every stage and block size class with data,
+		/// and the memory footprint of the instance. Each class is labelled with its smallest block size
+		/// </summary>
+		void Print(FILE* out, size_t instanceBytes) const;
+	};
+
+	/// <summary>
+	/// Records the time between construction and destruction into a stage of the profiler
+	/// </summary>
+	class ProfileScope
+	{
+	private:
+		KernelProfiler* profiler;
+		ProfileStage stage;
+		uint64_t start;
+
+	public:
+		inline ProfileScope(KernelProfiler* profiler, ProfileStage stage)
+		{
+			this->profiler = profiler;
+			this->stage = stage;
+			start = profiler ? KernelProfiler::ReadTicks() : 0;
+		}
+
+		inline ~ProfileScope()
+		{
+			if (profiler)
+				profiler->Record(stage, KernelProfiler::ReadTicks() - start);
+		}
+	};
+}
+
+// Times the rest of the enclosing scope. Expands to nothing unless NOISEINVADER_PROFILING is defined
+#ifdef NOISEINVADER_PROFILING
+#define NOISEINVADER_PROFILE_CONCAT2(a, b) a##b
+#define NOISEINVADER_PROFILE_CONCAT(a, b) NOISEINVADER_PROFILE_CONCAT2(a, b)
+#define NOISEINVADER_PROFILE(profiler, stage) NoiseInvader::ProfileScope NOISEINVADER_PROFILE_CONCAT(profileScope, __LINE__)(profiler, stage)
+#else
+#define NOISEINVADER_PROFILE(profiler, stage)
+#endif
@@ -4,21 +4,30 @@
 
 namespace NoiseInvader
 {
-	class SlewLimiter
+	// T is the sample type, float or double
+	template<typename T>
+	class SlewLimiterT
 	{
 	private:
 		double fs;
-		double slewUp;
-		double slewDown;
-		double output;
+		T slewUp;
+		T slewDown;
+		T output;
 
 	public:
 
-		SlewLimiter(double fs)
+		SlewLimiterT(double fs)
 		{
 			this->fs = fs;
 			this->slewUp = 1;
 			this->slewDown = 1;
+			this->output = 0;
+		}
+
+		// Call UpdateDb60 afterwards, the slew rates are per sample
+		void SetSampleRate(double fs)
+		{
+			this->fs = fs;
 		}
 
 		/// <summary>
@@ -28,11 +37,22 @@ namespace NoiseInvader
 		{
 			auto upSamples = slewUpMillis / 1000.0 * fs;
 			auto downSamples = slewDownMillis / 1000.0 * fs;
-			this->slewUp = 60.0 / upSamples;
-			this->slewDown = 60.0 / downSamples;
+			this->slewUp = (T)(60.0 / upSamples);
+			this->slewDown = (T)(60.0 / downSamples);
+		}
+
+		T GetOutput() const
+		{
+			return output;
 		}
 
-		double Process(double value)
+		// The output is the only state, the slew rates are settings
+		void SetOutput(T value)
+		{
+			output = value;
+		}
+
+		T Process(T value)
 		{
 			if (value > output)
 			{
@@ -51,5 +71,49 @@ namespace NoiseInvader
 
 			return output;
 		}
+
+		/// <summary>
+		/// Moves towards value over the given number of samples at once and returns the change per sample, limited to the
+		/// same rates as Process. The output ends on value if the rates allow it, else on output + samples * the change
+		/// </summary>
+		T Step(T value, int samples)
+		{
+			T delta = (value - output) / (T)samples;
+			if (delta > slewUp)
+			{
+				delta = slewUp;
+				output = output + (T)samples * delta;
+			}
+			else if (delta < -slewDown)
+			{
+				delta = -slewDown;
+				output = output + (T)samples * delta;
+			}
+			else
+			{
+				output = value;
+			}
+
+			return delta;
+		}
+
+		void Process(const T* input, T* output, int len)
+		{
+			for (int i = 0; i < len; i++)
+				output[i] = Process(input[i]);
+		}
+
+		// Block version for a constant input, only steps until the output has reached it
+		void ProcessConstant(T value, T* output, int len)
+		{
+			int i = 0;
+			for (; i < len && this->output != value; i++)
+				output[i] = Process(value);
+
+			for (; i < len; i++)
+				output[i] = value;
+		}
 	};
+
+	typedef SlewLimiterT<float> SlewLimiter;
 }